@@ -0,0 +1,60 @@
+#include "../src/codegen.hh"
+#include "../src/pass.hh"
+#include "../src/util.hh"
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+static void prepare_design(Generator *top) {
+    fix_assignment_type(top);
+    hash_generators(top, HashStrategy::ParallelHash);
+    uniquify_generators(top);
+    create_module_instantiation(top);
+}
+
+static void BM_generate_verilog(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    Context context;
+    auto &top = build_benchmark_design(context, size);
+    prepare_design(&top);
+    StageMemory memory;
+    memory.begin();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generate_verilog(&top));
+    }
+    memory.end();
+    report_stage(state, &top, memory);
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_generate_verilog_package(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    Context context;
+    auto &top = build_benchmark_design(context, size);
+    prepare_design(&top);
+    SystemVerilogCodeGenOptions options;
+    options.package_name = "bench_pkg";
+    options.output_dir = fs::temp_directory_path();
+    StageMemory memory;
+    memory.begin();
+    for (auto _ : state) {
+        generate_verilog(&top, options);
+    }
+    memory.end();
+    report_stage(state, &top, memory);
+    // package mode only writes the files out
+    for (auto const &iter : generate_verilog(&top))
+        fs::remove(fs::join(options.output_dir, iter.first + ".sv"));
+    fs::remove(fs::join(options.output_dir, options.package_name + ".svh"));
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// modules are generated in parallel
+BENCHMARK(BM_generate_verilog)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE)
+    ->UseRealTime();
+BENCHMARK(BM_generate_verilog_package)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
@@ -0,0 +1,54 @@
+#include <fstream>
+
+#include "../src/codegen.hh"
+#include "../src/fault.hh"
+#include "../src/pass.hh"
+#include "../src/stmt.hh"
+#include "../src/util.hh"
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+// a register file with `size` if statements. the verilator coverage file has a line coverage
+// entry for every line of the generated module
+static void BM_parse_verilator_coverage(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    Context context;
+    auto &mod = context.generator("mod");
+    mod.debug = true;
+    auto &clk = mod.port(PortDirection::In, "clk", 1, PortType::Clock);
+    auto &in = mod.port(PortDirection::In, "in", 4);
+    auto seq = mod.sequential();
+    seq->add_condition({EventEdgeType::Posedge, clk.shared_from_this()});
+    for (uint32_t i = 0; i < size; i++) {
+        auto &reg = mod.var("r" + std::to_string(i), 4);
+        auto if_ = std::make_shared<IfStmt>(in > constant(i % 16, 4));
+        if_->add_then_stmt(reg.assign(constant(i % 16, 4)));
+        if_->add_else_stmt(reg.assign(reg + in));
+        seq->add_stmt(if_);
+    }
+    fix_assignment_type(&mod);
+    auto src = generate_verilog(&mod).at("mod");
+    mod.verilog_fn = "mod.sv";
+
+    auto filename = fs::join(fs::temp_directory_path(), "kratos_bench_cov.dat");
+    {
+        auto num_lines = std::count(src.begin(), src.end(), '\n');
+        std::ofstream stream(filename);
+        stream << "# SystemC::Coverage-3" << std::endl;
+        for (int64_t ln = 1; ln <= num_lines; ln++) {
+            stream << "C '\1f\2mod.sv\1l\2" << ln << "\1n\0020\1page\2v_line/mod\1o\2if\1h\2TOP.mod' "
+                   << (ln % 7) << std::endl;
+        }
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parse_verilator_coverage(&mod, filename));
+    }
+    fs::remove(filename);
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_parse_verilator_coverage)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
@@ -0,0 +1,91 @@
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+static void BM_construct_vars(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        Context context;
+        auto &mod = context.generator("mod");
+        for (uint32_t i = 0; i < size; i++) {
+            benchmark::DoNotOptimize(&mod.var("v" + std::to_string(i), 16));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_construct_ports(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        Context context;
+        auto &mod = context.generator("mod");
+        for (uint32_t i = 0; i < size; i++) {
+            auto direction = i % 2 ? PortDirection::In : PortDirection::Out;
+            benchmark::DoNotOptimize(&mod.port(direction, "p" + std::to_string(i), 16));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_construct_exprs(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        Context context;
+        auto &mod = context.generator("mod");
+        auto &a = mod.var("a", 16);
+        Var *result = &mod.var("b", 16);
+        for (uint32_t i = 0; i < size; i++) {
+            result = &(*result + a);
+        }
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_construct_slices(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        Context context;
+        auto &mod = context.generator("mod");
+        auto &a = mod.var("a", 16, size);
+        for (uint32_t i = 0; i < size; i++) {
+            benchmark::DoNotOptimize(&a[i][std::make_pair(i % 16, 0u)]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_construct_design(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    StageMemory memory;
+    for (auto _ : state) {
+        state.PauseTiming();
+        memory.begin();
+        state.ResumeTiming();
+        Context context;
+        auto &top = build_benchmark_design(context, size);
+        benchmark::DoNotOptimize(&top);
+        state.PauseTiming();
+        memory.end();
+        report_stage(state, &top, memory);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_construct_vars)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
+BENCHMARK(BM_construct_ports)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
+BENCHMARK(BM_construct_exprs)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
+BENCHMARK(BM_construct_slices)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
+BENCHMARK(BM_construct_design)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
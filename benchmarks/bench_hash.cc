@@ -0,0 +1,36 @@
+#include "../src/pass.hh"
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+static void hash_design(benchmark::State &state, HashStrategy strategy) {
+    auto const size = static_cast<uint32_t>(state.range(0));
+    Context context;
+    auto &top = build_benchmark_design(context, size);
+    StageMemory memory;
+    memory.begin();
+    for (auto _ : state) {
+        // the hash table is cleared on every call
+        hash_generators(&top, strategy);
+    }
+    memory.end();
+    report_stage(state, &top, memory);
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void BM_hash_generators_sequential(benchmark::State &state) {  // NOLINT
+    hash_design(state, HashStrategy::SequentialHash);
+}
+
+static void BM_hash_generators_parallel(benchmark::State &state) {  // NOLINT
+    hash_design(state, HashStrategy::ParallelHash);
+}
+
+BENCHMARK(BM_hash_generators_sequential)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
+BENCHMARK(BM_hash_generators_parallel)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE)
+    ->UseRealTime();
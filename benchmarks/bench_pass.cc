@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+
+#include "../src/pass.hh"
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+// the pipeline of kratos.verilog(fold_parameters=True). a pass is measured on a design that has been
+// through all the passes in front of it
+static const std::vector<std::string> pipeline = [] {
+    DefaultPassOptions options;
+    options.fold_parameters = true;
+    return default_pass_pipeline(options);
+}();
+
+// passes outside of the pipeline run on a design that is ready to be hashed
+static std::vector<std::string> get_prerequisites(const std::string &pass_name) {
+    auto iter = std::find(pipeline.begin(), pipeline.end(), pass_name);
+    if (iter == pipeline.end())
+        iter = std::find(pipeline.begin(), pipeline.end(), "hash_generators_parallel");
+    return std::vector<std::string>(pipeline.begin(), iter);
+}
+
+static void run_pass(benchmark::State &state, const std::string &pass_name) {
+    auto const size = static_cast<uint32_t>(state.range(0));
+    auto const prerequisites = get_prerequisites(pass_name);
+    StageMemory memory;
+    for (auto _ : state) {
+        Context context;
+        auto &top = build_benchmark_design(context, size);
+        PassManager setup;
+        setup.register_builtin_passes();
+        for (auto const &name : prerequisites) setup.add_pass(name);
+        PassManager manager;
+        manager.register_builtin_passes();
+        manager.add_pass(pass_name);
+        try {
+            setup.run_passes(&top);
+            memory.begin();
+            auto start = std::chrono::high_resolution_clock::now();
+            manager.run_passes(&top);
+            auto end = std::chrono::high_resolution_clock::now();
+            memory.end();
+            state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+            report_stage(state, &top, memory);
+        } catch (std::exception &ex) {
+            state.SkipWithError(ex.what());
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static bool register_pass_benchmarks() {
+    PassManager manager;
+    manager.register_builtin_passes();
+    for (auto const &pass_name : manager.registered_passes()) {
+        benchmark::RegisterBenchmark(("BM_pass/" + pass_name).c_str(),
+                                     [pass_name](benchmark::State &state) {
+                                         run_pass(state, pass_name);
+                                     })
+            ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+            ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE)
+            ->UseManualTime();
+    }
+    return true;
+}
+
+[[maybe_unused]] static const bool pass_benchmarks = register_pass_benchmarks();
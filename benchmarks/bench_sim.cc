@@ -0,0 +1,35 @@
+#include "../src/sim.hh"
+#include "../src/stmt.hh"
+#include "benchmark/benchmark.h"
+#include "design.hh"
+
+using namespace kratos;
+
+// a chain of `size` combinational assignments from the input to the output. one eval
+// propagates a new input value through the whole chain
+static void BM_simulator_eval(benchmark::State &state) {  // NOLINT
+    auto const size = static_cast<uint32_t>(state.range(0));
+    Context context;
+    auto &mod = context.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 16);
+    auto &out = mod.port(PortDirection::Out, "out", 16);
+    Var *prev = &in;
+    for (uint32_t i = 0; i < size; i++) {
+        auto &v = mod.var("v" + std::to_string(i), 16);
+        mod.add_stmt(v.assign((*prev + constant(i, 16)) ^ in));
+        prev = &v;
+    }
+    mod.add_stmt(out.assign(*prev));
+
+    Simulator sim(&mod);
+    uint64_t value = 0;
+    for (auto _ : state) {
+        sim.set(&in, value++ & 0xFFFF);
+        benchmark::DoNotOptimize(sim.get(&out));
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_simulator_eval)
+    ->RangeMultiplier(BENCHMARK_SIZE_MULTIPLIER)
+    ->Range(BENCHMARK_MIN_SIZE, BENCHMARK_MAX_SIZE);
@@ -0,0 +1,85 @@
+#ifndef KRATOS_BENCHMARK_DESIGN_HH
+#define KRATOS_BENCHMARK_DESIGN_HH
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../src/synthetic.hh"
+#include "../src/util.hh"
+#include "benchmark/benchmark.h"
+
+namespace kratos {
+
+// design sizes shared by all the benchmarks
+constexpr int64_t BENCHMARK_MIN_SIZE = 1 << 4;
+constexpr int64_t BENCHMARK_MAX_SIZE = 1 << 12;
+constexpr int64_t BENCHMARK_SIZE_MULTIPLIER = 4;
+
+// a top with `size` child instances of a synthetic leaf module. half of the instances share
+// the hash of another instance
+inline Generator &build_benchmark_design(Context &context, uint32_t size) {
+    SyntheticDesignOptions options;
+    options.fanout = size;
+    options.depth = 1;
+    options.duplication_ratio = 0.5;
+    options.max_width = 32;
+    return synthesize_design(&context, options);
+}
+
+// number of distinct IR nodes reachable from the top: generators, statements and the vars
+// they refer to
+inline uint64_t count_ir_nodes(Generator *top) {
+    std::unordered_set<IRNode *> visited = {top};
+    std::vector<IRNode *> nodes = {top};
+    while (!nodes.empty()) {
+        auto *node = nodes.back();
+        nodes.pop_back();
+        for (uint64_t i = 0; i < node->child_count(); i++) {
+            auto *child = node->get_child(i);
+            if (child && visited.emplace(child).second) nodes.emplace_back(child);
+        }
+    }
+    return visited.size();
+}
+
+// memory high-water mark of a stage above the resident set at its start. the IR isn't fully
+// released when a context is destroyed, so a stage that rebuilds its design has to be measured
+// per iteration to keep the result independent of the iteration count
+class StageMemory {
+public:
+    void begin() {
+#ifdef __GLIBC__
+        // hand the memory freed by earlier stages back to the OS
+        malloc_trim(0);
+#endif
+        mem::reset_peak_rss();
+        start_ = mem::current_rss();
+    }
+
+    void end() {
+        auto peak = std::max(mem::peak_rss(), mem::current_rss());
+        if (peak > start_) peak_ = std::max(peak_, peak - start_);
+    }
+
+    [[nodiscard]] uint64_t peak() const { return peak_; }
+
+private:
+    uint64_t start_ = 0;
+    uint64_t peak_ = 0;
+};
+
+// per-stage counters tracked by scripts/perf_regression.py
+inline void report_stage(benchmark::State &state, Generator *top, const StageMemory &memory) {
+    state.counters["ir_nodes"] = static_cast<double>(count_ir_nodes(top));
+    state.counters["peak_memory"] =
+        benchmark::Counter(static_cast<double>(memory.peak()), benchmark::Counter::kDefaults,
+                           benchmark::Counter::kIs1024);
+}
+
+}  // namespace kratos
+
+#endif  // KRATOS_BENCHMARK_DESIGN_HH
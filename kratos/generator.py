@@ -1,12 +1,13 @@
 from .pyast import transform_stmt_block, add_scope_context, \
-    get_frame_local, AlwaysWrapper
+    get_frame_local, AlwaysWrapper, clear_transform_cache
 from .util import clog2, max_value, cast, VarCastType
 from .stmts import if_, switch_, IfStmt, SwitchStmt
 from .ports import PortBundle
 from .fsm import FSM
 from .interface import InterfaceWrapper
 import _kratos
-from _kratos import get_fn_ln, StatementBlockType, EventEdgeType, PortType, PortDirection
+from _kratos import get_fn_ln, StatementBlockType, EventEdgeType, PortType, PortDirection, \
+    AssignmentType
 from typing import List, Dict, Union, Tuple
 
 __GLOBAL_DEBUG = False
@@ -239,9 +240,6 @@ class Generator(metaclass=GeneratorMeta):
         :param is_clone: mark whether the generator is a clone or not.
         :param internal_generator: native C++ handle
         """
-        # for initialization
-        self.__cached_initialization = []
-
         if internal_generator is not None:
             assert isinstance(internal_generator, _kratos.Generator)
             self.__generator = internal_generator
@@ -346,6 +344,19 @@ class Generator(metaclass=GeneratorMeta):
     def is_stub(self, value: bool):
         self.__generator.set_is_stub(value)
 
+    def set_lazy_body(self, fn):
+        """
+        Defers building the body of this generator. Ports and parameters have
+        to be declared beforehand. ``fn`` is called without arguments when
+        the generator is elaborated during ``verilog()``; it is never called
+        if the generator is a stub or its outputs are left unconnected
+        """
+        self.__generator.set_lazy_body(lambda _: fn())
+
+    @property
+    def is_lazy(self):
+        return self.__generator.is_lazy()
+
     @property
     def external(self):
         """
@@ -400,22 +411,18 @@ class Generator(metaclass=GeneratorMeta):
 
     def combinational(self):
         if self.is_cloned:
-            self.__cached_initialization.append((self.combinational, []))
-            return
+            self.initialize_clone()
         return CombinationalCodeBlock(self, 3)
 
     def sequential(self, *sensitivity_list: Tuple[EventEdgeType,
                                                   _kratos.Var]):
         if self.is_cloned:
-            self.__cached_initialization.append((self.sequential,
-                                                 [sensitivity_list]))
-            return
+            self.initialize_clone()
         return SequentialCodeBlock(self, sensitivity_list, 3)
 
     def initial(self):
         if self.is_cloned:
-            self.__cached_initialization.append((self.initial, []))
-            return
+            self.initialize_clone()
         return InitialCodeBlock(self, 3)
 
     @staticmethod
@@ -460,6 +467,18 @@ class Generator(metaclass=GeneratorMeta):
         self.__set_var_size(p, params)
         return p
 
+    def var_batch(self, names: List[str], widths, is_signed: bool = False):
+        # widths can be a single int, a list or a numpy array
+        debug_info = [get_fn_ln()] if self.debug else []
+        return self.__generator.var_batch(names, widths, is_signed, debug_info)
+
+    def port_batch(self, names: List[str], widths, direction: PortDirection,
+                   port_type: PortType = PortType.Data,
+                   is_signed: bool = False):
+        debug_info = [get_fn_ln()] if self.debug else []
+        return self.__generator.port_batch(direction, names, widths, port_type,
+                                           is_signed, debug_info)
+
     def port_from_def(self, port: _kratos.Port, name="", check_param: bool = True):
         if name:
             return self.__generator.port(port, name, check_param)
@@ -622,9 +641,7 @@ class Generator(metaclass=GeneratorMeta):
                    fn_ln=None, unroll_for=False, ssa_transform=False,
                    **kargs):
         if self.is_cloned:
-            # TODO: fix this with kargs
-            self.__cached_initialization.append((self.add_code, [fn, comment]))
-            return
+            self.initialize_clone()
         block_type, raw_sensitives, stmts = transform_stmt_block(self, fn, unroll_for=unroll_for,
                                                                  fn_ln=fn_ln, kargs=kargs,
                                                                  apply_ssa=ssa_transform)
@@ -712,12 +729,7 @@ class Generator(metaclass=GeneratorMeta):
              comment="", locals_=None, fn_ln=None, additional_frame=0,
              no_fn_ln=False):
         if self.is_cloned:
-            if self.debug and locals_ is None:
-                locals_ = get_frame_local(2 + additional_frame)
-            self.__cached_initialization.append((self.wire, [var_to, var_from,
-                                                             attributes,
-                                                             comment, locals_]))
-            return
+            self.initialize_clone()
         # wire interface is a special treatment
         if isinstance(var_from, (_kratos.InterfaceRef, InterfaceWrapper)) or \
                 isinstance(var_to, (_kratos.InterfaceRef, InterfaceWrapper)):
@@ -766,6 +778,25 @@ class Generator(metaclass=GeneratorMeta):
         if comment:
             stmt.comment = comment
 
+    def wire_batch(self, vars_to: List[_kratos.Var],
+                   vars_from: List[_kratos.Var]):
+        if self.is_cloned:
+            self.initialize_clone()
+        debug_info = [get_fn_ln()] if self.debug else []
+        return self.__generator.wire_batch(vars_to, vars_from, debug_info)
+
+    def assign_batch(self, vars_to: List[_kratos.Var],
+                     vars_from: List[_kratos.Var], block=None,
+                     assignment_type: AssignmentType = AssignmentType.Undefined):
+        # without a block the assignments are added to the top level
+        if self.is_cloned:
+            self.initialize_clone()
+        if isinstance(block, CodeBlock):
+            block = block.stmt()
+        debug_info = [get_fn_ln()] if self.debug else []
+        return self.__generator.assign_batch(block, vars_to, vars_from,
+                                             assignment_type, debug_info)
+
     def add_fsm(self, fsm_name: str, clk_name=None, reset_name=None,
                 reset_high=True):
         if clk_name is not None and reset_name is not None:
@@ -782,8 +813,7 @@ class Generator(metaclass=GeneratorMeta):
 
     def add_stmt(self, stmt, add_ln_info=True):
         if self.is_cloned:
-            self.__cached_initialization.append((self.add_stmt, [stmt]))
-            return
+            self.initialize_clone()
         self.__generator.add_stmt(stmt)
         if add_ln_info and self.debug:
             stmt.add_fn_ln(get_fn_ln())
@@ -791,16 +821,13 @@ class Generator(metaclass=GeneratorMeta):
 
     def remove_stmt(self, stmt):
         if self.is_cloned:
-            self.__cached_initialization.append((self.remove_stmt, [stmt]))
-            return
+            self.initialize_clone()
         self.__generator.remove_stmt(stmt)
 
     def add_child_generator(self, instance_name: str, generator: "Generator",
                             comment="", python_only=False, **kargs):
         if self.is_cloned:
-            self.__cached_initialization.append((self.add_child_generator,
-                                                 (instance_name, generator)))
-            return
+            self.initialize_clone()
         if instance_name in self.__child_generator:
             raise Exception(
                 "{0} already exists in {1}".format(instance_name,
@@ -852,9 +879,7 @@ class Generator(metaclass=GeneratorMeta):
 
     def remove_child_generator(self, generator):
         if self.is_cloned:
-            self.__cached_initialization.append((self.remove_child_generator,
-                                                 [generator]))
-            return
+            self.initialize_clone()
         if generator.instance_name not in self.__child_generator:
             raise Exception("{0} doesn't exist in {1}".format(generator.name,
                                                               self.name))
@@ -885,6 +910,8 @@ class Generator(metaclass=GeneratorMeta):
             for class_ in clses:  # type: Generator
                 clear_subclass(class_)
         clear_subclass(Generator)
+        # drop the transformed always blocks
+        clear_transform_cache()
         # clean the function calls
         from .func import clear_context
         clear_context()
@@ -909,6 +936,41 @@ class Generator(metaclass=GeneratorMeta):
                                                        lib_files, _port_mapping)
         return g
 
+    def save_ir(self, filename: str):
+        """Writes a binary snapshot of the IR of this generator and its
+        children, which can be restored with :meth:`load_ir`"""
+        _kratos.save_ir(self.__generator, filename)
+
+    @staticmethod
+    def load_ir(filename: str):
+        gen = _kratos.load_ir(Generator.__context, filename)
+        return Generator("", internal_generator=gen)
+
+    @staticmethod
+    def synthesize(fanout: int = 4, depth: int = 3,
+                   duplication_ratio: float = 0.5, num_stmts: int = 8,
+                   stmt_weights: Dict[str, int] = None, min_width: int = 1,
+                   max_width: int = 64, seed: int = 0):
+        """Builds a random generator hierarchy for stress tests and
+        benchmarks. ``stmt_weights`` maps ``assign``, ``if``, ``switch`` and
+        ``sequential`` to the relative frequency of each statement kind. The
+        same arguments always produce the same design"""
+        options = _kratos.SyntheticDesignOptions()
+        options.fanout = fanout
+        options.depth = depth
+        options.duplication_ratio = duplication_ratio
+        options.num_stmts = num_stmts
+        if stmt_weights is not None:
+            for kind, weight in stmt_weights.items():
+                if kind not in {"assign", "if", "switch", "sequential"}:
+                    raise ValueError("Unknown statement kind " + kind)
+                setattr(options, kind + "_weight", weight)
+        options.min_width = min_width
+        options.max_width = max_width
+        options.seed = seed
+        gen = _kratos.synthesize_design(Generator.__context, options)
+        return Generator("", internal_generator=gen)
+
     def __contains__(self, generator: "Generator"):
         if not isinstance(generator, (Generator, _kratos.Generator)):
             return False
@@ -918,30 +980,41 @@ class Generator(metaclass=GeneratorMeta):
             return generator in self.__generator
 
     def initialize_clone(self):
-        if self.is_cloned:
-            self.__generator.is_cloned = False
-            for fn, args in self.__cached_initialization:
-                fn(*args)
-            self.__cached_initialization.clear()
+        if not self.is_cloned:
+            return
+        # copy the definition's content natively
+        self.__generator.materialize()
+        # clones without a definition have nothing to copy
+        self.__generator.is_cloned = False
+        for child in self.__generator.get_child_generators():
+            if child.instance_name in self.__child_generator:
+                continue
+            gen = Generator("", internal_generator=child)
+            gen.__parent = self
+            self.__child_generator[child.instance_name] = gen
 
     def __set_generator_name(self, name):
         self.__generator.name = name
 
     @classmethod
     def __cached_py_generator(cls, **kargs):
-        hash_value = 0
-        for key, value in kargs.items():
-            if hasattr(value, "hash"):
-                value_hash = value.hash()
-            else:
-                value_hash = hash(value)
-            hash_value = hash_value ^ (hash(key) << 16) ^ value_hash
-        if hash_value not in cls._cache:
-            g = cls(**kargs)
-            cls._cache[hash_value] = g
-            return g, False
-        else:
-            return cls._cache[hash_value], True
+        # classes defined in different scopes can share the same name
+        key = _kratos.GeneratorCacheKey(
+            "{0}.{1}@{2:x}".format(cls.__module__, cls.__qualname__, id(cls)))
+        try:
+            for name, value in kargs.items():
+                key.add(name, value)
+        except TypeError:
+            # unable to tell whether two parametrizations are the same
+            return cls(**kargs), False
+        context = Generator.__context
+        internal_gen = context.get_cached_generator(key)
+        if internal_gen is not None and internal_gen in cls._cache:
+            return cls._cache[internal_gen], True
+        g = cls(**kargs)
+        context.add_cached_generator(key, g.internal_generator)
+        cls._cache[g.internal_generator] = g
+        return g, False
 
     @classmethod
     def clone(cls, **kargs):
@@ -949,20 +1022,22 @@ class Generator(metaclass=GeneratorMeta):
         if not cached:
             return gen
         else:
-            g = Generator("")
-            g.__generator = gen.__generator.clone()
+            g = Generator("", internal_generator=gen.__generator.clone())
             g.__def_instance = gen
-            # get all public port vars and parameters for wiring
-            variables = vars(gen)
-            for name, v in variables.items():
-                if isinstance(v, _kratos.Port):
-                    setattr(g, name, g.ports[v.name])
-                elif isinstance(v, _kratos.Param):
-                    setattr(g, name, g.params[v.name])
-                elif isinstance(v, (int, str, float, tuple)):
-                    setattr(g, name, v)
+            gen.__copy_public_attributes(g)
             return g
 
+    def __copy_public_attributes(self, clone: "Generator"):
+        # get all public port vars and parameters for wiring
+        variables = vars(self)
+        for name, v in variables.items():
+            if isinstance(v, _kratos.Port):
+                setattr(clone, name, clone.ports[v.name])
+            elif isinstance(v, _kratos.Param):
+                setattr(clone, name, clone.params[v.name])
+            elif isinstance(v, (int, str, float, tuple)):
+                setattr(clone, name, v)
+
     @classmethod
     def create(cls, **kargs):
         # if the debug is set to True globally, we don't create any
@@ -972,11 +1047,17 @@ class Generator(metaclass=GeneratorMeta):
         gen, cached = cls.__cached_py_generator(**kargs)
         if not cached:
             return gen
+        elif not gen.__generator.can_copy_content():
+            # the clone could not get its own copy once changed
+            return cls(**kargs)
         else:
-            kargs["is_clone"] = True
-            g = cls(**kargs)
+            # a native header that shares the definition's content. __init__
+            # is not run, the content is copied on the first change instead
+            g = cls.__new__(cls)
+            Generator.__init__(g, "",
+                               internal_generator=gen.__generator.clone())
             g.__def_instance = gen
-            g.__generator.def_instance = gen.internal_generator
+            gen.__copy_public_attributes(g)
             return g
 
     # list of helper functions similar to chisel, but force good naming
@@ -44,89 +44,54 @@ def verilog(generator: Generator, optimize_if: bool = True,
             fix_port_legality: bool = False,
             dead_code_elimination: bool = False,
             collect_pass_perf: bool = False,
-            codegen_options: _kratos.SystemVerilogCodeGenOptions = None):
+            codegen_options: _kratos.SystemVerilogCodeGenOptions = None,
+            stream: bool = False,
+            fold_parameters: bool = False,
+            pass_perf_results: list = None):
     code_gen = _kratos.VerilogModule(generator.internal_generator)
     pass_manager = code_gen.pass_manager()
-    pass_manager.collect_perf = collect_pass_perf
+    # passing in a list collects the per-pass statistics into it. they are
+    # only printed with collect_pass_perf
+    pass_manager.collect_perf = collect_pass_perf or \
+        pass_perf_results is not None
+    pass_manager.print_perf = collect_pass_perf
     if additional_passes is not None:
         for name, fn in additional_passes.items():
             pass_manager.register_pass(name, fn)
             pass_manager.add_pass(name)
-    # load all the passes
-    # you can easily roll your own functions to control how the passes
-    # are run
+    # load all the passes. the pipeline is defined in C++ and shared with
+    # the benchmarks. you can easily roll your own functions to control how
+    # the passes are run
+    options = _kratos.passes.DefaultPassOptions()
+    options.remove_assertion = remove_assertion
+    options.ssa_transform = ssa_transform
+    options.optimize_passthrough = optimize_passthrough
+    options.optimize_if = optimize_if
+    options.dead_code_elimination = dead_code_elimination
+    options.optimize_fanout = optimize_fanout
+    options.optimize_bundle = optimize_bundle
+    options.merge_const_port_assignment = merge_const_port_assignment
+    options.remove_unused = remove_unused
+    options.check_combinational_loop = check_combinational_loop
+    options.check_inferred_latch = check_inferred_latch
+    options.check_active_high = check_active_high
+    options.check_multiple_driver = check_multiple_driver
+    options.check_flip_flop_always_ff = check_flip_flop_always_ff
+    options.insert_debug_info = insert_debug_info
+    options.use_parallel = use_parallel
+    options.fold_parameters = fold_parameters
+    options.lift_genvar_instances = lift_genvar_instances
+    options.insert_pipeline_stages = insert_pipeline_stages
+    options.reorder_stmts = reorder_stmts
+    options.fix_port_legality = fix_port_legality
     # if it's a test bench, need to sort the initials
-    if remove_assertion:
-        pass_manager.add_pass("remove_assertion")
-    pass_manager.add_pass("realize_fsm")
-    if ssa_transform:
-        pass_manager.add_pass("ssa_transform_fix")
-    if optimize_passthrough:
-        pass_manager.add_pass("remove_pass_through_modules")
-    if optimize_if:
-        pass_manager.add_pass("merge_if_block")
-        pass_manager.add_pass("transform_if_to_case")
-    # we run the dead code elimination early on
-    if dead_code_elimination:
-        pass_manager.add_pass("dead_code_elimination")
-    # fsm elaboration has to happen before unused vars removal
-    pass_manager.add_pass("zero_out_stubs")
-    if optimize_fanout:
-        pass_manager.add_pass("remove_fanout_one_wires")
-    pass_manager.add_pass("zero_generator_inputs")
-    if optimize_bundle:
-        pass_manager.add_pass("change_port_bundle_struct")
-    pass_manager.add_pass("verify_generator_connectivity")
-    if merge_const_port_assignment:
-        pass_manager.add_pass("merge_const_port_assignment")
-    pass_manager.add_pass("decouple_generator_ports")
-    pass_manager.add_pass("fix_assignment_type")
-    if remove_unused and not insert_debug_info:
-        pass_manager.add_pass("remove_unused_vars")
-        pass_manager.add_pass("remove_unused_stmts")
-    pass_manager.add_pass("verify_assignments")
-    if check_combinational_loop:
-        pass_manager.add_pass("check_combinational_loop")
-    pass_manager.add_pass("check_mixed_assignment")
-    pass_manager.add_pass("check_always_sensitivity")
-    if check_inferred_latch:
-        pass_manager.add_pass("check_inferred_latch")
-    if check_active_high:
-        pass_manager.add_pass("check_active_high")
-    pass_manager.add_pass("check_function_return")
-    pass_manager.add_pass("merge_wire_assignments")
-    if check_multiple_driver:
-        pass_manager.add_pass("check_multiple_driver")
-    if check_flip_flop_always_ff:
-        pass_manager.add_pass("check_flip_flop_always_ff")
-    # insert debug break points if needed
-    if insert_debug_info:
-        pass_manager.add_pass("propagate_scope_variable")
-        pass_manager.add_pass("inject_assertion_fail")
-    if use_parallel:
-        pass_manager.add_pass("hash_generators_parallel")
-    else:
-        pass_manager.add_pass("hash_generators_sequential")
-    pass_manager.add_pass("inline_instance")
-    pass_manager.add_pass("change_property_into_stmt")
-    pass_manager.add_pass("infer_property_clocking")
-    pass_manager.add_pass("uniquify_generators")
-    pass_manager.add_pass("create_module_instantiation")
-    pass_manager.add_pass("create_interface_instantiation")
-    # genvar instance lifting only happens after the module hash
-    if lift_genvar_instances:
-        pass_manager.add_pass("lift_genvar_instances")
-    if insert_pipeline_stages:
-        pass_manager.add_pass("insert_pipeline_stages")
-    if isinstance(generator.internal_generator, _kratos.TestBench):
-        pass_manager.add_pass("sort_initial_stmts")
-    if reorder_stmts:
-        pass_manager.add_pass("sort_stmts")
-    # legality fix at the very end
-    if fix_port_legality:
-        pass_manager.add_pass("port_legality_fix")
+    options.sort_initial_stmts = isinstance(generator.internal_generator,
+                                            _kratos.TestBench)
+    pass_manager.add_default_passes(options)
 
     code_gen.run_passes()
+    if pass_perf_results is not None:
+        pass_perf_results.extend(pass_manager.perf_results)
 
     # debug database
     if debug_db_filename:
@@ -147,11 +112,27 @@ def verilog(generator: Generator, optimize_if: bool = True,
     if codegen_options is None:
         codegen_options = _kratos.SystemVerilogCodeGenOptions()
 
+    if stream:
+        # write out the finalized subtree and reduce it to a stub. its parent
+        # is generated with another call once it is done
+        if len(codegen_options.output_dir) == 0:
+            raise ValueError("stream requires codegen_options.output_dir")
+        # the streamed modules include the package written out with the top,
+        # so the top has to be generated with the same options
+        if len(codegen_options.package_name) == 0:
+            raise ValueError("stream requires codegen_options.package_name")
+        if not os.path.isdir(codegen_options.output_dir):
+            os.makedirs(codegen_options.output_dir)
+        codegen_options.extract_debug_info = debug_fn_ln
+        return _kratos.passes.stream_verilog(generator.internal_generator,
+                                             codegen_options)
+
     if len(codegen_options.output_dir) > 0:
         if not os.path.isdir(codegen_options.output_dir):
             os.makedirs(codegen_options.output_dir)
-        package_name = generator.internal_generator.name + "_pkg"
-        codegen_options.package_name = package_name
+        if len(codegen_options.package_name) == 0:
+            package_name = generator.internal_generator.name + "_pkg"
+            codegen_options.package_name = package_name
         codegen_options.extract_debug_info = debug_fn_ln
         _kratos.passes.generate_verilog(generator.internal_generator,
                                         codegen_options)
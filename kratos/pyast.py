@@ -1,10 +1,13 @@
 import ast
+import builtins
 import copy
 import enum
+import hashlib
 import inspect
 import os
 import sys
 import textwrap
+import types
 
 import _kratos
 import astor
@@ -245,11 +248,7 @@ class StaticElaborationNodeForVisitor(ast.NodeTransformer):
             # on the line number
             index_num = node.lineno
             # create the for statement in the scope
-            for_stmt = _kratos.ForStmt(target.id, iter_obj.start, iter_obj.stop, iter_obj.step)
-            self.scope.for_stmt[index_num] = for_stmt
-            # set the for iter var
-            # redirect the variable to env
-            self.scope.iter_var[index_num] = for_stmt.get_iter_var()
+            self.scope.create_for_stmt(index_num, target.id, iter_obj.start, iter_obj.stop, iter_obj.step)
             index = ast.Subscript(
                 slice=ast.Index(value=ast.Num(n=index_num)),
                 value=ast.Attribute(
@@ -836,6 +835,18 @@ class Scope:
 
         self.iter_var = {}
         self.for_stmt = {}
+        # loop bounds used to create the for statements. this is used
+        # to recreate them when a transformed block is reused
+        self.for_spec = {}
+
+    def create_for_stmt(self, index, var_name, start, end, step):
+        for_stmt = _kratos.ForStmt(var_name, start, end, step)
+        self.for_stmt[index] = for_stmt
+        # set the for iter var
+        # redirect the variable to env
+        self.iter_var[index] = for_stmt.get_iter_var()
+        self.for_spec[index] = (var_name, start, end, step)
+        return for_stmt
 
     def if_(self, target, *args, f_ln=None, **kargs):
         add_local = self.add_local
@@ -1042,13 +1053,7 @@ def legalize_body(body):
     return body
 
 
-def __ast_transform_blocks(generator, func_tree, fn_src, fn_name, scope, insert_self,
-                           filename, func_ln,
-                           transform_return=False, pre_locals=None, unroll_for=False,
-                           apply_ssa=False):
-    # pre-compute the frames
-    # we have 3 frames back
-    f = inspect.currentframe().f_back.f_back.f_back
+def get_frame_env(f, pre_locals=None):
     # will go one above to get the locals as well?
     if f.f_back is not None:
         _locals = f.f_back.f_locals.copy()
@@ -1059,6 +1064,17 @@ def __ast_transform_blocks(generator, func_tree, fn_src, fn_name, scope, insert_
 
     if pre_locals is not None:
         _locals.update(pre_locals)
+    return _locals, _globals
+
+
+def __ast_transform_blocks(generator, func_tree, fn_src, fn_name, scope, insert_self,
+                           filename, func_ln,
+                           transform_return=False, pre_locals=None, unroll_for=False,
+                           apply_ssa=False):
+    # pre-compute the frames
+    # we have 3 frames back
+    f = inspect.currentframe().f_back.f_back.f_back
+    _locals, _globals = get_frame_env(f, pre_locals)
 
     debug = generator.debug
     fn_body = func_tree.body[0]
@@ -1165,10 +1181,168 @@ def filter_fn_args(fn_args):
     return args
 
 
+class StaticInputVisitor(ast.NodeVisitor):
+    """collect the names and attribute chains static elaboration may
+    evaluate, e.g. ``self.width`` or ``num_stage``"""
+    def __init__(self):
+        self.inputs = set()
+
+    def visit_Name(self, node: ast.Name):
+        self.inputs.add(node.id)
+
+    def visit_Attribute(self, node: ast.Attribute):
+        root = node.value
+        while isinstance(root, ast.Attribute):
+            root = root.value
+        if isinstance(root, ast.Name):
+            self.inputs.add(root.id)
+            self.inputs.add(astor.to_source(node).strip())
+        else:
+            self.generic_visit(node)
+
+
+class BlockSource:
+    def __init__(self, fn):
+        self.src = inspect.getsource(fn)
+        self.digest = hashlib.sha1(self.src.encode()).hexdigest()
+        self.filename = get_fn(fn)
+        self.ln = get_ln(fn)
+        fn_body = ast.parse(textwrap.dedent(self.src)).body[0]
+        self.decorator_list = fn_body.decorator_list
+        visitor = StaticInputVisitor()
+        for node in fn_body.body:
+            visitor.visit(node)
+        # scope is reserved and self is bound to the generator
+        visitor.inputs.discard("scope")
+        # attribute chains only contain names, see StaticInputVisitor
+        self.static_inputs = [(name, name.split("."))
+                              for name in sorted(visitor.inputs)]
+
+
+# source information, keyed by the code object
+__block_source_cache = {}
+# transformed code objects, keyed by the function name, source hash,
+# transformer flags and the static elaboration inputs
+__transformed_block_cache = {}
+
+
+def get_block_source(fn):
+    code = getattr(fn, "__code__", None)
+    if code is None:
+        return BlockSource(fn)
+    if code not in __block_source_cache:
+        __block_source_cache[code] = BlockSource(fn)
+    return __block_source_cache[code]
+
+
+def clear_transform_cache():
+    __block_source_cache.clear()
+    __transformed_block_cache.clear()
+
+
+class NoStaticSignature(Exception):
+    """raised when a static input can't be looked up or compared safely, in
+    which case the block is not cached"""
+
+
+def static_signature(value, refs):
+    # only the properties static elaboration looks at are part of the signature.
+    # anything else is compared by identity, and kept alive in refs so that its
+    # id can't be reused while the cache entry exists
+    if value is None or isinstance(value, (bool, int, float, str, bytes)):
+        return type(value).__name__, value
+    if isinstance(value, _kratos.Var):
+        return "var", type(value).__name__, value.width
+    if isinstance(value, enum.Enum):
+        return "enum", type(value).__qualname__, value.name
+    if isinstance(value, range):
+        return "range", value.start, value.stop, value.step
+    if isinstance(value, (tuple, list)):
+        return type(value).__name__, tuple([static_signature(v, refs) for v in value])
+    if isinstance(value, dict):
+        return "dict", tuple([(static_signature(k, refs), static_signature(v, refs))
+                              for k, v in value.items()])
+    if isinstance(value, kratos.Generator):
+        # generator parameters are usually stored as plain attributes
+        attrs = []
+        for name, v in sorted(vars(value).items()):
+            if v is None or isinstance(v, (bool, int, float, str)):
+                attrs.append((name, v))
+        return "gen", type(value).__qualname__, tuple(attrs)
+    if isinstance(value, types.MethodType):
+        # a method can read any state of the object it is bound to, e.g.
+        # lists or dicts, which the signature doesn't capture
+        raise NoStaticSignature(value.__name__)
+    refs.append(value)
+    return "obj", id(value)
+
+
+def is_kratos_type(cls):
+    return cls.__module__.split(".")[0] in ("kratos", "_kratos")
+
+
+def static_attribute(value, attr):
+    # only plain attribute lookups. properties and other descriptors may have
+    # side effects, so only the ones kratos defines itself are evaluated
+    raw = inspect.getattr_static(value, attr)
+    if not hasattr(type(raw), "__get__") or \
+            isinstance(raw, (types.FunctionType, types.BuiltinFunctionType,
+                             staticmethod, classmethod)):
+        return getattr(value, attr)
+    if isinstance(value, type) and issubclass(value, enum.Enum):
+        return getattr(value, attr)
+    cls = value if isinstance(value, type) else type(value)
+    for klass in cls.__mro__:
+        if attr in vars(klass):
+            if is_kratos_type(klass):
+                return getattr(value, attr)
+            break
+    raise NoStaticSignature(attr)
+
+
+def lookup_static_input(names, local, _globals):
+    name = names[0]
+    if name in local:
+        value = local[name]
+    elif name in _globals:
+        value = _globals[name]
+    elif hasattr(builtins, name):
+        value = getattr(builtins, name)
+    else:
+        raise NameError(name)
+    for attr in names[1:]:
+        value = static_attribute(value, attr)
+    return value
+
+
+def compute_static_signature(source, generator, _locals, _globals):
+    """returns the signature and the objects it refers to by identity, or
+    None if the block can't be cached"""
+    local = _locals.copy()
+    local["self"] = generator
+    result = []
+    refs = []
+    for name, names in source.static_inputs:
+        try:
+            value = lookup_static_input(names, local, _globals)
+        except NoStaticSignature:
+            return None
+        except Exception as ex:
+            value = "error", type(ex).__name__
+        else:
+            try:
+                value = static_signature(value, refs)
+            except NoStaticSignature:
+                return None
+        result.append((name, value))
+    return tuple(result), refs
+
+
 def transform_stmt_block(generator, fn, unroll_for=False, apply_ssa=False, fn_ln=None, kargs=None):
     if kargs is None:
         kargs = dict()
     env_kargs = dict()
+    source = None
 
     if callable(fn) or isinstance(fn, AlwaysWrapper):
         if isinstance(fn, AlwaysWrapper):
@@ -1183,47 +1357,76 @@ def transform_stmt_block(generator, fn, unroll_for=False, apply_ssa=False, fn_ln
                           "deprecated soon. Please use @always_ff or "
                           "@always_comb", SyntaxWarning)
             print_src(get_fn(fn), get_ln(fn))
-        fn_src = inspect.getsource(fn)
+        source = get_block_source(fn)
+        fn_src = source.src
         fn_name = fn.__name__
-        func_tree = ast.parse(textwrap.dedent(fn_src))
+        decorator_list = source.decorator_list
     else:
         assert isinstance(fn, ast.FunctionDef)
         # user directly passed in ast nodes
         assert fn_ln is not None
         fn_name = fn.name
-        func_tree = ast.Module(body=[fn])
         fn_src = astor.to_source(fn)
+        decorator_list = fn.decorator_list
 
-    fn_body = func_tree.body[0]
     # needs debug
     debug = generator.debug
     store_local = debug and fn_ln is None
-    filename = get_fn(fn) if fn_ln is None else fn_ln[0]
-    ln = get_ln(fn) if fn_ln is None else fn_ln[1]
+    if fn_ln is None:
+        filename, ln = source.filename, source.ln
+    else:
+        filename, ln = fn_ln
 
     # extract the sensitivity list from the decorator
-    blk_type, sensitivity = extract_sensitivity_from_dec(fn_body.decorator_list, fn_name)
-    # remove the decorator
-    fn_body.decorator_list = []
-    # check the function args. it should only has one self now
-    func_args = filter_fn_args(fn_body.args.args)
-    insert_self = len(func_args) == 1
-    fn_body.args.args = func_args
+    blk_type, sensitivity = extract_sensitivity_from_dec(decorator_list, fn_name)
     # creating the scope here
     scope = Scope(generator, filename, ln, store_local)
 
     apply_ssa = blk_type == StatementBlockType.Combinational and apply_ssa
 
-    _locals, _globals, scope_name = __ast_transform_blocks(generator, func_tree, fn_src,
-                                                           fn_name, scope,
-                                                           insert_self, filename, ln,
-                                                           unroll_for=unroll_for,
-                                                           apply_ssa=apply_ssa,
-                                                           pre_locals=env_kargs)
-
-    src = astor.to_source(func_tree, pretty_source=__pretty_source)
-    src = inject_import_code(src)
-    code_obj = compile(src, "<ast>", "exec")
+    # ssa creates variables in the generator while transforming, so it always
+    # has to go through the full transformation
+    cache_key = None
+    if source is not None and fn_ln is None and not apply_ssa:
+        # the same frame __ast_transform_blocks looks at
+        _locals, _globals = get_frame_env(inspect.currentframe().f_back.f_back, env_kargs)
+        signature = compute_static_signature(source, generator, _locals, _globals)
+        if signature is not None:
+            static_inputs, static_refs = signature
+            cache_key = (fn.__qualname__, source.digest, unroll_for, debug, filename, ln,
+                         static_inputs)
+
+    entry = __transformed_block_cache.get(cache_key) if cache_key is not None else None
+    if entry is not None:
+        code_obj, scope_name, for_spec, _ = entry
+        for index, (var_name, start, end, step) in for_spec.items():
+            scope.create_for_stmt(index, var_name, start, end, step)
+    else:
+        if isinstance(fn, ast.FunctionDef):
+            func_tree = ast.Module(body=[fn])
+        else:
+            func_tree = ast.parse(textwrap.dedent(fn_src))
+        fn_body = func_tree.body[0]
+        # remove the decorator
+        fn_body.decorator_list = []
+        # check the function args. it should only has one self now
+        func_args = filter_fn_args(fn_body.args.args)
+        insert_self = len(func_args) == 1
+        fn_body.args.args = func_args
+
+        _locals, _globals, scope_name = __ast_transform_blocks(generator, func_tree, fn_src,
+                                                               fn_name, scope,
+                                                               insert_self, filename, ln,
+                                                               unroll_for=unroll_for,
+                                                               apply_ssa=apply_ssa,
+                                                               pre_locals=env_kargs)
+
+        src = astor.to_source(func_tree, pretty_source=__pretty_source)
+        src = inject_import_code(src)
+        code_obj = compile(src, "<ast>", "exec")
+        if cache_key is not None:
+            __transformed_block_cache[cache_key] = (code_obj, scope_name, scope.for_spec.copy(),
+                                                    static_refs)
 
     # notice that this ln is an offset
     _locals.update({"_self": generator, scope_name: scope})
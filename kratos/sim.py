@@ -27,6 +27,13 @@ class Simulator:
         else:
             return self._sim.get(var)
 
+    def set_many(self, vars, values, eval=True):
+        # values is a flat uint64 numpy array, arrays take one slot per element
+        self._sim.set_many(vars, values, eval)
+
+    def get_many(self, vars, out=None, valid=None):
+        return self._sim.get_many(vars, out, valid)
+
     def cycle(self, n=1):
         if self._clk is None:
             raise RuntimeError("Single clock not found")
@@ -20,10 +20,12 @@ void init_code_gen(py::module &m) {
 
     py::class_<VerilogModule>(m, "VerilogModule")
         .def(py::init<Generator *>())
-        .def("verilog_src", py::overload_cast<>(&VerilogModule::verilog_src))
+        .def("verilog_src", py::overload_cast<>(&VerilogModule::verilog_src),
+             py::call_guard<py::gil_scoped_release>())
         .def("verilog_src",
-             py::overload_cast<SystemVerilogCodeGenOptions>(&VerilogModule::verilog_src))
-        .def("run_passes", &VerilogModule::run_passes)
+             py::overload_cast<SystemVerilogCodeGenOptions>(&VerilogModule::verilog_src),
+             py::call_guard<py::gil_scoped_release>())
+        .def("run_passes", &VerilogModule::run_passes, py::call_guard<py::gil_scoped_release>())
         .def("pass_manager", &VerilogModule::pass_manager, py::return_value_policy::reference);
 
     m.def("create_wrapper_flatten", &create_wrapper_flatten, py::return_value_policy::reference)
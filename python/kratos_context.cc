@@ -4,12 +4,93 @@
 
 #include "../src/context.hh"
 #include "../src/generator.hh"
+#include "../src/serialize.hh"
+#include "../src/synthetic.hh"
 #include "../src/tb.hh"
 
 namespace py = pybind11;
 
+// canonical encoding of python values for the generator cache. values that cannot be
+// encoded raise TypeError, in which case the generator should not be cached
+std::string encode_cache_value(const py::handle &value) {
+    using kratos::GeneratorCacheKey;
+    using ValueType = GeneratorCacheKey::ValueType;
+    auto encode_items = [](ValueType type, const py::iterable &items) {
+        std::vector<std::string> result;
+        for (auto const &item : items) result.emplace_back(encode_cache_value(item));
+        return GeneratorCacheKey::encode(type, result);
+    };
+
+    if (value.is_none()) return GeneratorCacheKey::encode(ValueType::None, "");
+    if (py::isinstance<py::bool_>(value))
+        return GeneratorCacheKey::encode(ValueType::Bool, value.cast<bool>() ? "1" : "0");
+    if (py::isinstance<py::int_>(value) || py::hasattr(value, "__index__")) {
+        // python ints are unbounded, so use the decimal representation
+        auto index = py::reinterpret_steal<py::object>(PyNumber_Index(value.ptr()));
+        if (!index) throw py::error_already_set();
+        return GeneratorCacheKey::encode(ValueType::Int, py::str(index).cast<std::string>());
+    }
+    if (py::isinstance<py::float_>(value)) {
+        auto v = value.cast<double>();
+        // 0.0 == -0.0
+        if (v == 0) v = 0;
+        return GeneratorCacheKey::encode(ValueType::Float,
+                                         std::string(reinterpret_cast<const char *>(&v), sizeof(v)));
+    }
+    if (py::isinstance<py::str>(value))
+        return GeneratorCacheKey::encode(ValueType::Str, value.cast<std::string>());
+    if (py::isinstance<py::bytes>(value))
+        return GeneratorCacheKey::encode(ValueType::Bytes, value.cast<std::string>());
+    if (py::isinstance<py::tuple>(value)) return encode_items(ValueType::Tuple, value);
+    if (py::isinstance<py::list>(value)) return encode_items(ValueType::List, value);
+    if (PyAnySet_Check(value.ptr())) return encode_items(ValueType::Set, value);
+    if (py::isinstance<py::dict>(value)) {
+        std::vector<std::string> items;
+        for (auto const &[k, v] : value.cast<py::dict>()) {
+            items.emplace_back(GeneratorCacheKey::encode(
+                ValueType::Tuple, std::vector<std::string>{encode_cache_value(k),
+                                                           encode_cache_value(v)}));
+        }
+        return GeneratorCacheKey::encode(ValueType::Dict, items);
+    }
+    // enum members are keyed by their type and name. anything else, kratos objects included,
+    // has no value that tells two parametrizations apart
+    auto type = py::type::handle_of(value);
+    auto type_name = py::str(type.attr("__module__")).cast<std::string>() + "." +
+                     py::str(type.attr("__qualname__")).cast<std::string>();
+    auto enum_type = py::module::import("enum").attr("Enum");
+    if (py::isinstance(value, enum_type)) {
+        return GeneratorCacheKey::encode(
+            ValueType::Object, type_name + ":" + py::str(value.attr("name")).cast<std::string>());
+    }
+    throw py::type_error("Unable to use value of type " + type_name + " as generator cache key");
+}
+
 void init_context(py::module &m) {
     using namespace kratos;
+    py::class_<GeneratorCacheKey>(m, "GeneratorCacheKey")
+        .def(py::init<std::string>(), py::arg("class_name"))
+        .def(
+            "add",
+            [](GeneratorCacheKey &key, const std::string &name, const py::handle &value) {
+                key.add(name, encode_cache_value(value));
+            },
+            py::arg("name"), py::arg("value"))
+        .def_property_readonly("canonical",
+                               [](const GeneratorCacheKey &key) { return py::bytes(key.canonical()); })
+        .def_property_readonly("digest", &GeneratorCacheKey::digest);
+
+    py::class_<IRStats>(m, "IRStats")
+        .def_readonly("node_visits", &IRStats::node_visits)
+        .def_readonly("exprs_created", &IRStats::exprs_created)
+        .def_readonly("slice_cache_hits", &IRStats::slice_cache_hits)
+        .def_readonly("slice_cache_misses", &IRStats::slice_cache_misses)
+        .def_readonly("stmts_added", &IRStats::stmts_added)
+        .def_readonly("stmts_removed", &IRStats::stmts_removed)
+        .def_readonly("src_moves", &IRStats::src_moves)
+        .def_readonly("sink_moves", &IRStats::sink_moves)
+        .def_readonly("pass_visits", &IRStats::pass_visits);
+
     auto context = py::class_<Context>(m, "Context");
     context.def(py::init())
         .def("generator", &Context::generator, py::return_value_policy::reference)
@@ -31,5 +112,59 @@ void init_context(py::module &m) {
         .def("enum", &Context::enum_, py::arg("enum_name"), py::arg("definition"),
              py::arg("width"), py::return_value_policy::reference)
         .def("has_enum", &Context::has_enum)
-        .def_property("track_generated", &Context::track_generated, &Context::set_track_generated);
+        .def("get_cached_generator", &Context::get_cached_generator, py::arg("key"))
+        .def("add_cached_generator", &Context::add_cached_generator, py::arg("key"),
+             py::arg("internal_generator"))
+        .def("clear_generator_cache", &Context::clear_generator_cache)
+        .def("generator_cache_size", &Context::generator_cache_size)
+        .def_property("track_generated", &Context::track_generated, &Context::set_track_generated)
+        .def_property_readonly_static("ir_stats_enabled",
+                                      [](const py::object &) { return Context::ir_stats_enabled(); })
+        .def("ir_stats", &Context::ir_stats)
+        .def("reset_ir_stats", &Context::reset_ir_stats);
+
+    m.attr("IR_FORMAT_VERSION") = IR_FORMAT_VERSION;
+    m.def(
+        "serialize_ir",
+        [](Generator *top) {
+            std::string data;
+            {
+                py::gil_scoped_release release;
+                data = serialize_ir(top);
+            }
+            return py::bytes(data);
+        },
+        py::arg("top"));
+    m.def("save_ir", &save_ir, py::arg("top"), py::arg("filename"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def(
+        "deserialize_ir",
+        [](Context *context, const py::bytes &data) {
+            // keep the bytes object alive and read it in place
+            char *buffer;
+            Py_ssize_t size;
+            if (PyBytes_AsStringAndSize(data.ptr(), &buffer, &size) != 0)
+                throw py::error_already_set();
+            py::gil_scoped_release release;
+            return deserialize_ir(context, std::string_view(buffer, size));
+        },
+        py::arg("context"), py::arg("data"), py::return_value_policy::reference);
+    m.def("load_ir", &load_ir, py::arg("context"), py::arg("filename"),
+          py::return_value_policy::reference, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SyntheticDesignOptions>(m, "SyntheticDesignOptions")
+        .def(py::init<>())
+        .def_readwrite("fanout", &SyntheticDesignOptions::fanout)
+        .def_readwrite("depth", &SyntheticDesignOptions::depth)
+        .def_readwrite("duplication_ratio", &SyntheticDesignOptions::duplication_ratio)
+        .def_readwrite("num_stmts", &SyntheticDesignOptions::num_stmts)
+        .def_readwrite("assign_weight", &SyntheticDesignOptions::assign_weight)
+        .def_readwrite("if_weight", &SyntheticDesignOptions::if_weight)
+        .def_readwrite("switch_weight", &SyntheticDesignOptions::switch_weight)
+        .def_readwrite("sequential_weight", &SyntheticDesignOptions::sequential_weight)
+        .def_readwrite("min_width", &SyntheticDesignOptions::min_width)
+        .def_readwrite("max_width", &SyntheticDesignOptions::max_width)
+        .def_readwrite("seed", &SyntheticDesignOptions::seed);
+    m.def("synthesize_design", &synthesize_design, py::arg("context"), py::arg("options"),
+          py::return_value_policy::reference, py::call_guard<py::gil_scoped_release>());
 }
\ No newline at end of file
@@ -27,7 +27,8 @@ void init_debug(py::module &m) {
         // dump the database file
         .def("save_database",
              py::overload_cast<const std::string &, bool>(&DebugDatabase::save_database),
+             py::call_guard<py::gil_scoped_release>(),
              py::arg("filename"), py::arg("override"))
         .def("save_database", py::overload_cast<const std::string &>(&DebugDatabase::save_database),
-             py::arg("filename"));
+             py::call_guard<py::gil_scoped_release>(), py::arg("filename"));
 }
\ No newline at end of file
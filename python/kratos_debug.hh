@@ -18,7 +18,12 @@ void def_trace(T &class_) {
         }
     })
     .def_readwrite("comment", &K::comment)
-    .def_readwrite("fn_name_ln", &K::fn_name_ln)
+    .def_property(
+        "fn_name_ln",
+        [](const K &k) { return std::vector<std::pair<std::string, uint32_t>>(k.fn_name_ln); },
+        [](K &k, const std::vector<std::pair<std::string, uint32_t>> &fn_name_ln) {
+            k.fn_name_ln = fn_name_ln;
+        })
     .def_property_readonly("verilog_ln", [](K& k) { return k.verilog_ln; });
 }
 
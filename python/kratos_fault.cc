@@ -12,10 +12,22 @@ void init_fault(py::module &main_m) {
     auto m = main_m.def_submodule("fault");
     auto run = py::class_<SimulationRun, std::shared_ptr<SimulationRun>>(m, "SimulationRun");
     run.def(py::init<Generator *>())
-        .def("add_simulation_state", &SimulationRun::add_simulation_state)
+        .def("add_simulation_state",
+             py::overload_cast<const std::map<std::string, int64_t> &>(
+                 &SimulationRun::add_simulation_state))
+        .def("add_simulation_state",
+             py::overload_cast<const std::vector<int64_t> &>(&SimulationRun::add_simulation_state))
+        .def("set_signal_names", &SimulationRun::set_signal_names)
         .def("mark_wrong_value", &SimulationRun::mark_wrong_value)
         .def_property_readonly("has_wrong_value", &SimulationRun::has_wrong_value)
-        .def("get_state", &SimulationRun::get_state, py::return_value_policy::reference)
+        .def("get_state",
+             [](const SimulationRun &run, uint32_t index) -> std::unique_ptr<Simulator> {
+                 // the simulator of the run is reused by the next call, so python gets its own
+                 if (index >= run.num_states()) return nullptr;
+                 auto simulator = std::make_unique<Simulator>(run.top());
+                 run.load_state(index, simulator.get());
+                 return simulator;
+             })
         .def_property_readonly("num_states", &SimulationRun::num_states)
         .def("add_simulation_coverage", &SimulationRun::add_simulation_coverage);
 
@@ -24,7 +36,8 @@ void init_fault(py::module &main_m) {
         .def("add_simulation_run", &FaultAnalyzer::add_simulation_run)
         .def_property_readonly("num_runs", &FaultAnalyzer::num_runs)
         .def("compute_coverage", &FaultAnalyzer::compute_coverage)
-        .def("compute_fault_stmts_from_coverage", &FaultAnalyzer::compute_fault_stmts_from_coverage)
+        .def("compute_fault_stmts_from_coverage", &FaultAnalyzer::compute_fault_stmts_from_coverage,
+             py::call_guard<py::gil_scoped_release>())
         .def("output_coverage_xml",
              py::overload_cast<const std::string &>(&FaultAnalyzer::output_coverage_xml));
 
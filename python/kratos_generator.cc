@@ -1,4 +1,5 @@
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -14,6 +15,15 @@
 namespace py = pybind11;
 using std::shared_ptr;
 
+// accepts an int, a list of ints, or a numpy array. numpy arrays are read without
+// converting each element through python
+using BatchWidth = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+
+std::vector<uint32_t> batch_widths(const BatchWidth &widths) {
+    auto const *data = widths.data();
+    return std::vector<uint32_t>(data, data + widths.size());
+}
+
 void init_generator(py::module &m) {
     using namespace kratos;
     auto generator = py::class_<Generator, ::shared_ptr<Generator>, IRNode>(m, "Generator");
@@ -221,9 +231,38 @@ void init_generator(py::module &m) {
         .def("external_filename", &Generator::external_filename)
         .def("is_stub", &Generator::is_stub)
         .def("set_is_stub", &Generator::set_is_stub)
+        .def("set_lazy_body", &Generator::set_lazy_body)
+        .def("is_lazy", &Generator::is_lazy)
+        .def("elaborate", &Generator::elaborate)
         .def("wire_ports", &Generator::wire_ports)
         .def("wire", &Generator::wire)
         .def("unwire", &Generator::unwire)
+        .def(
+            "var_batch",
+            [](Generator &gen, const std::vector<std::string> &names, const BatchWidth &widths,
+               bool is_signed, const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+                return gen.var_batch(names, batch_widths(widths), is_signed, debug_info);
+            },
+            py::arg("names"), py::arg("widths"), py::arg("is_signed") = false,
+            py::arg("debug_info") = std::vector<std::pair<std::string, uint32_t>>{},
+            py::return_value_policy::reference)
+        .def(
+            "port_batch",
+            [](Generator &gen, PortDirection direction, const std::vector<std::string> &names,
+               const BatchWidth &widths, PortType type, bool is_signed,
+               const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+                return gen.port_batch(direction, names, batch_widths(widths), type, is_signed,
+                                      debug_info);
+            },
+            py::arg("direction"), py::arg("names"), py::arg("widths"),
+            py::arg("port_type") = PortType::Data, py::arg("is_signed") = false,
+            py::arg("debug_info") = std::vector<std::pair<std::string, uint32_t>>{},
+            py::return_value_policy::reference)
+        .def("wire_batch", &Generator::wire_batch, py::arg("sinks"), py::arg("sources"),
+             py::arg("debug_info") = std::vector<std::pair<std::string, uint32_t>>{})
+        .def("assign_batch", &Generator::assign_batch, py::arg("block"), py::arg("sinks"),
+             py::arg("sources"), py::arg("type") = AssignmentType::Undefined,
+             py::arg("debug_info") = std::vector<std::pair<std::string, uint32_t>>{})
         .def("wire_interface", &Generator::wire_interface)
         .def("correct_wire_direction", &Generator::correct_wire_direction)
         .def("correct_wire_direction",
@@ -257,6 +296,8 @@ void init_generator(py::module &m) {
         .def_readwrite("debug", &Generator::debug)
         .def("clone", &Generator::clone)
         .def("set_clone_ref", &Generator::set_clone_ref)
+        .def("materialize", &Generator::materialize)
+        .def("can_copy_content", &Generator::can_copy_content)
         .def_property("is_cloned", &Generator::is_cloned, &Generator::set_is_cloned)
         .def("copy_over_missing_ports", &Generator::copy_over_missing_ports)
         .def("__contains__",
@@ -25,8 +25,13 @@ void init_pass(py::module &m) {
         .def("hash_generators_sequential", &hash_generators_sequential)
         .def("decouple_generator_ports", &decouple_generator_ports)
         .def("uniquify_generators", &uniquify_generators)
+        .def("fold_generator_parameters", &fold_generator_parameters)
+        .def("elaborate_lazy_generators", &elaborate_lazy_generators)
         .def("generate_verilog",
-             py::overload_cast<Generator *, SystemVerilogCodeGenOptions>(&generate_verilog))
+             py::overload_cast<Generator *, SystemVerilogCodeGenOptions>(&generate_verilog),
+             py::call_guard<py::gil_scoped_release>())
+        .def("stream_verilog", &stream_verilog, py::arg("generator"), py::arg("options"),
+             py::call_guard<py::gil_scoped_release>())
         .def("transform_if_to_case", &transform_if_to_case)
         .def("remove_fanout_one_wires", &remove_fanout_one_wires)
         .def("remove_pass_through_modules", &remove_pass_through_modules)
@@ -68,6 +73,41 @@ void init_pass(py::module &m) {
         .def("check_non_synthesizable_content", &check_non_synthesizable_content)
         .def("inject_assertion_fail", &inject_assertion_fail);
 
+    py::class_<PassPerf>(pass_m, "PassPerf")
+        .def_readonly("name", &PassPerf::name)
+        .def_readonly("time", &PassPerf::time)
+        .def_readonly("rss_before", &PassPerf::rss_before)
+        .def_readonly("rss_after", &PassPerf::rss_after)
+        .def_readonly("peak_rss", &PassPerf::peak_rss)
+        .def_readonly("allocations", &PassPerf::allocations)
+        .def_readonly("allocated_bytes", &PassPerf::allocated_bytes);
+
+    py::class_<DefaultPassOptions>(pass_m, "DefaultPassOptions")
+        .def(py::init<>())
+        .def_readwrite("remove_assertion", &DefaultPassOptions::remove_assertion)
+        .def_readwrite("ssa_transform", &DefaultPassOptions::ssa_transform)
+        .def_readwrite("optimize_passthrough", &DefaultPassOptions::optimize_passthrough)
+        .def_readwrite("optimize_if", &DefaultPassOptions::optimize_if)
+        .def_readwrite("dead_code_elimination", &DefaultPassOptions::dead_code_elimination)
+        .def_readwrite("optimize_fanout", &DefaultPassOptions::optimize_fanout)
+        .def_readwrite("optimize_bundle", &DefaultPassOptions::optimize_bundle)
+        .def_readwrite("merge_const_port_assignment", &DefaultPassOptions::merge_const_port_assignment)
+        .def_readwrite("remove_unused", &DefaultPassOptions::remove_unused)
+        .def_readwrite("check_combinational_loop", &DefaultPassOptions::check_combinational_loop)
+        .def_readwrite("check_inferred_latch", &DefaultPassOptions::check_inferred_latch)
+        .def_readwrite("check_active_high", &DefaultPassOptions::check_active_high)
+        .def_readwrite("check_multiple_driver", &DefaultPassOptions::check_multiple_driver)
+        .def_readwrite("check_flip_flop_always_ff", &DefaultPassOptions::check_flip_flop_always_ff)
+        .def_readwrite("insert_debug_info", &DefaultPassOptions::insert_debug_info)
+        .def_readwrite("use_parallel", &DefaultPassOptions::use_parallel)
+        .def_readwrite("fold_parameters", &DefaultPassOptions::fold_parameters)
+        .def_readwrite("lift_genvar_instances", &DefaultPassOptions::lift_genvar_instances)
+        .def_readwrite("insert_pipeline_stages", &DefaultPassOptions::insert_pipeline_stages)
+        .def_readwrite("sort_initial_stmts", &DefaultPassOptions::sort_initial_stmts)
+        .def_readwrite("reorder_stmts", &DefaultPassOptions::reorder_stmts)
+        .def_readwrite("fix_port_legality", &DefaultPassOptions::fix_port_legality);
+    pass_m.def("default_pass_pipeline", &default_pass_pipeline);
+
     auto manager = py::class_<PassManager>(pass_m, "PassManager", R"pbdoc(
 This class gives you the fined control over which pass to run and in which order.
 Most passes doesn't return anything, thus it's safe to put it in the pass manager and
@@ -75,15 +115,26 @@ let is run. However, if you want to code gen verilog, you have to call generate_
 by yourself to obtain the verilog code.)pbdoc");
     manager.def(py::init<>())
         .def("register_pass",
-             py::overload_cast<const std::string &, std::function<void(Generator *)>>(
-                 &PassManager::register_pass))
-        .def("run_passes", &PassManager::run_passes)
+             [](PassManager &manager, const std::string &name,
+                const std::function<void(Generator *)> &fn) {
+                 // passes run with the GIL released, so Python passes have to take it back
+                 manager.register_pass(name, [fn](Generator *generator) {
+                     py::gil_scoped_acquire acquire;
+                     fn(generator);
+                 });
+             })
+        .def("run_passes", &PassManager::run_passes, py::call_guard<py::gil_scoped_release>())
         .def("add_pass", &PassManager::add_pass)
         .def("has_pass", &PassManager::has_pass)
         .def_property_readonly("num_pass", &PassManager::num_passes)
         .def("register_builtin_passes", &PassManager::register_builtin_passes)
+        .def("add_default_passes", &PassManager::add_default_passes)
         .def_property("collect_perf", &PassManager::get_collect_perf,
-                      &PassManager::set_collect_perf);
+                      &PassManager::set_collect_perf)
+        .def_property("print_perf", &PassManager::get_print_perf, &PassManager::set_print_perf)
+        .def_property("reset_peak_rss", &PassManager::get_reset_peak_rss,
+                      &PassManager::set_reset_peak_rss)
+        .def_property_readonly("perf_results", &PassManager::perf_results);
 
     // trampoline class for ast visitor
     class PyIRVisitor : public IRVisitor {
@@ -141,6 +192,12 @@ by yourself to obtain the verilog code.)pbdoc");
         }
 
         using Attribute::Attribute;
+        PyAttribute(const PyAttribute &) = default;
+        ~PyAttribute() override {
+            // IR nodes can be freed by passes that run without the GIL
+            py::gil_scoped_acquire acquire;
+            target_ = py::object();
+        }
 
         py::object get_py_obj() { return target_; }
 
@@ -1,11 +1,17 @@
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "../src/except.hh"
 #include "../src/sim.hh"
 
 namespace py = pybind11;
 
+using ValueArray = py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+using OutArray = py::array_t<uint64_t, py::array::c_style>;
+using ValidArray = py::array_t<bool, py::array::c_style>;
+
 // simulator module
 void init_simulator(py::module &m) {
     using namespace kratos;
@@ -24,6 +30,40 @@ void init_simulator(py::module &m) {
         .def("set", [](Simulator &sim, Var *var, std::optional<int64_t> v) { sim.set_i(var, v); })
         .def("set", [](Simulator &sim, Var *var,
                        const std::optional<std::vector<int64_t>> &v) { sim.set_i(var, v); })
+        .def("eval", &Simulator::eval, py::call_guard<py::gil_scoped_release>())
         .def("get", &Simulator::get)
-        .def("get_array", &Simulator::get_array);
+        .def("get_array", &Simulator::get_array)
+        .def(
+            "set_many",
+            [](Simulator &sim, const std::vector<Var *> &vars, const ValueArray &values,
+               bool eval) {
+                // values are read straight from the numpy buffer
+                auto const *data = values.data();
+                auto size = static_cast<uint64_t>(values.size());
+                py::gil_scoped_release release;
+                sim.set_many(vars, data, size, eval);
+            },
+            py::arg("vars"), py::arg("values"), py::arg("eval") = true)
+        .def(
+            "get_many",
+            [](const Simulator &sim, const std::vector<Var *> &vars, std::optional<OutArray> out,
+               std::optional<ValidArray> valid) {
+                // write into the caller's buffer if given, otherwise allocate one
+                auto result = out ? *out : OutArray(Simulator::value_count(vars));
+                if (valid && static_cast<uint64_t>(valid->size()) != vars.size())
+                    throw UserException(fmt::format("Expected valid buffer of size {0}, got {1}",
+                                                    vars.size(), valid->size()));
+                auto *data = result.mutable_data();
+                auto size = static_cast<uint64_t>(result.size());
+                auto *valid_data = valid ? valid->mutable_data() : nullptr;
+                {
+                    py::gil_scoped_release release;
+                    sim.get_many(vars, data, size, valid_data);
+                }
+                return result;
+            },
+            py::arg("vars"), py::arg("out").noconvert() = py::none(),
+            py::arg("valid").noconvert() = py::none())
+        .def_static("value_count",
+                    py::overload_cast<const std::vector<Var *> &>(&Simulator::value_count));
 }
\ No newline at end of file
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""Runs the benchmarks on the synthetic designs and compares them with a
+baseline.
+
+Every stage (design construction, hashing, each pass and codegen) reports its
+time, the memory high-water mark above the resident set at its start, and the
+number of IR nodes of the design. The results are written as JSON and compared
+with the baseline. The script exits with 1 if any stage regresses beyond the
+tolerances.
+
+Only the fields present in the baseline are compared. The checked-in baseline
+has the IR node counts alone, which are the same on every machine; a baseline
+with timings and memory is recorded on the machine it is compared on.
+
+    python3 scripts/perf_regression.py --build-dir build/benchmarks
+    python3 scripts/perf_regression.py --build-dir build/benchmarks \\
+        --update-baseline --baseline local.json
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+# benchmark binaries and the benchmarks in them that run on a synthetic design
+BENCHMARKS = {
+    "bench_generator": "BM_construct_design",
+    "bench_hash": "BM_hash_generators",
+    "bench_pass": "BM_pass/",
+    "bench_codegen": "BM_generate_verilog",
+}
+
+TIME_UNITS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_BASELINE = os.path.join(ROOT, "benchmarks", "baseline.json")
+
+
+def parse_args(args=None):
+    parser = argparse.ArgumentParser(
+        description="Track the performance of kratos against a baseline")
+    parser.add_argument("--build-dir", required=True,
+                        help="directory with the benchmark binaries")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE,
+                        help="baseline JSON to compare against")
+    parser.add_argument("--output", default="perf.json",
+                        help="where to write the results")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="overwrite the baseline with the results")
+    parser.add_argument("--ir-nodes-only", action="store_true",
+                        help="only keep the IR node counts when updating the "
+                             "baseline, as done for the checked-in one")
+    parser.add_argument("--sizes", default="16,256",
+                        help="comma separated design sizes to run")
+    parser.add_argument("--filter", default="",
+                        help="only run stages matching this regex")
+    parser.add_argument("--min-time", type=float, default=0.01,
+                        help="minimum time in seconds spent on each stage")
+    parser.add_argument("--repetitions", type=int, default=3,
+                        help="number of runs per stage. the fastest one is "
+                             "compared")
+    parser.add_argument("--time-tolerance", type=float, default=0.25,
+                        help="allowed relative increase of the time")
+    parser.add_argument("--memory-tolerance", type=float, default=0.25,
+                        help="allowed relative increase of the peak memory")
+    parser.add_argument("--memory-floor", type=int, default=1 << 20,
+                        help="memory increases below this many bytes are "
+                             "ignored")
+    parser.add_argument("--node-tolerance", type=float, default=0,
+                        help="allowed relative change of the IR node count")
+    return parser.parse_args(args)
+
+
+def run_benchmark(binary, pattern, args):
+    sizes = "|".join(str(s) for s in get_sizes(args))
+    pattern = "{0}.*/({1})(/|$)".format(pattern, sizes)
+    output = subprocess.check_output([
+        binary,
+        "--benchmark_filter=" + pattern,
+        "--benchmark_format=json",
+        "--benchmark_min_time=" + str(args.min_time),
+        "--benchmark_repetitions=" + str(args.repetitions)])
+    return json.loads(output.decode())
+
+
+def get_sizes(args):
+    return [int(s) for s in args.sizes.split(",") if s]
+
+
+def selected(name, args):
+    # stage names are <benchmark>/<size>, optionally followed by the timing
+    size = re.search(r"/(\d+)(/|$)", name)
+    if size and int(size.group(1)) not in get_sizes(args):
+        return False
+    return not args.filter or re.search(args.filter, name) is not None
+
+
+def collect_stages(report, args):
+    stages = {}
+    for entry in report["benchmarks"]:
+        # the mean, median and deviation of the repetitions are skipped
+        if entry.get("run_type", "iteration") != "iteration":
+            continue
+        name = entry.get("run_name", entry["name"])
+        if not selected(name, args):
+            continue
+        if entry.get("error_occurred", False):
+            stages[name] = {"error": entry.get("error_message", "")}
+            continue
+        if "error" in stages.get(name, {}):
+            continue
+        unit = TIME_UNITS[entry.get("time_unit", "ns")]
+        stage = {"time": round(entry["real_time"] * unit),
+                 "peak_memory": int(entry.get("peak_memory", 0)),
+                 "ir_nodes": int(entry.get("ir_nodes", 0))}
+        # the fastest and smallest run is the least disturbed by the machine
+        if name in stages:
+            stage["time"] = min(stage["time"], stages[name]["time"])
+            stage["peak_memory"] = min(stage["peak_memory"],
+                                       stages[name]["peak_memory"])
+        stages[name] = stage
+    return stages
+
+
+def run_stages(args):
+    result = {"context": {}, "stages": {}}
+    for binary, pattern in BENCHMARKS.items():
+        path = os.path.join(args.build_dir, binary)
+        if not os.path.isfile(path):
+            raise FileNotFoundError("unable to find " + path)
+        print("running", binary, flush=True)
+        report = run_benchmark(path, pattern, args)
+        if not result["context"]:
+            context = report["context"]
+            result["context"] = {key: context[key] for key in
+                                 ("host_name", "num_cpus", "mhz_per_cpu",
+                                  "library_build_type") if key in context}
+        result["stages"].update(collect_stages(report, args))
+    return result
+
+
+def exceeds(value, reference, tolerance, floor=0):
+    return value - reference > max(reference * tolerance, floor)
+
+
+def compare(result, baseline, args):
+    regressions = []
+    stages = result["stages"]
+    for name, ref in sorted(baseline["stages"].items()):
+        if not selected(name, args):
+            continue
+        if name not in stages:
+            regressions.append("{0}: missing".format(name))
+            continue
+        stage = stages[name]
+        if "error" in stage:
+            if "error" not in ref:
+                regressions.append("{0}: {1}".format(name, stage["error"]))
+            continue
+        if "error" in ref:
+            continue
+        if "time" in ref and exceeds(stage["time"], ref["time"],
+                                     args.time_tolerance):
+            regressions.append("{0}: time {1:.0f} ns -> {2:.0f} ns".format(
+                name, ref["time"], stage["time"]))
+        if "peak_memory" in ref and \
+                exceeds(stage["peak_memory"], ref["peak_memory"],
+                        args.memory_tolerance, args.memory_floor):
+            regressions.append("{0}: peak memory {1} -> {2} bytes".format(
+                name, ref["peak_memory"], stage["peak_memory"]))
+        # the node count should only change when the IR or the synthetic
+        # designs change, so it is checked in both directions
+        if "ir_nodes" in ref and abs(stage["ir_nodes"] - ref["ir_nodes"]) > \
+                ref["ir_nodes"] * args.node_tolerance:
+            regressions.append("{0}: ir nodes {1} -> {2}".format(
+                name, ref["ir_nodes"], stage["ir_nodes"]))
+    for name in sorted(set(stages) - set(baseline["stages"])):
+        print("new stage not in the baseline:", name)
+    return regressions
+
+
+def main(args=None):
+    args = parse_args(args)
+    result = run_stages(args)
+    with open(args.output, "w") as f:
+        json.dump(result, f, indent=2, sort_keys=True)
+    print("results written to", args.output)
+
+    if args.update_baseline:
+        stages = result["stages"]
+        baseline = {"context": result["context"], "stages": {}}
+        if args.ir_nodes_only:
+            stages = {name: {key: value for key, value in stage.items()
+                             if key in ("ir_nodes", "error")}
+                      for name, stage in stages.items()}
+            baseline = {"stages": {}}
+        # keep the stages that were not run this time
+        if os.path.isfile(args.baseline):
+            with open(args.baseline) as f:
+                baseline["stages"] = json.load(f)["stages"]
+        baseline["stages"].update(stages)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline updated:", args.baseline)
+        return 0
+
+    if not os.path.isfile(args.baseline):
+        print("no baseline found at", args.baseline)
+        print("create one with --update-baseline or the perf_baseline target")
+        return 1
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    regressions = compare(result, baseline, args)
+    if regressions:
+        print("performance regressions:")
+        for line in regressions:
+            print("  " + line)
+        return 1
+    print("no performance regressions against", args.baseline)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -57,6 +57,9 @@ class CMakeBuild(build_ext):
         env = os.environ.copy()
 
         cmake_args += ['-DCMAKE_BUILD_TYPE=' + cfg]
+        # IR mutation and traversal counters, see Context.ir_stats()
+        if os.environ.get("KRATOS_IR_STATS") is not None:
+            cmake_args += ['-DKRATOS_IR_STATS=ON']
         if self.is_windows():
             cmake_args += ["-G", "Unix Makefiles"]
             # make sure clang is in the PATH
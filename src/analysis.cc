@@ -1014,6 +1014,13 @@ std::unordered_map<const Stmt*, std::string> compute_enable_condition(Generator*
     return visitor.values;
 }
 
+std::unordered_map<const Stmt*, std::string> compute_generator_enable_condition(
+    Generator* generator) {
+    EnableStmtVisitor visitor;
+    visitor.visit_content(generator);
+    return visitor.values;
+}
+
 class PortPackedVisitor : public IRVisitor {
 public:
     void visit(Generator* generator) override {
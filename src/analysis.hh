@@ -23,6 +23,9 @@ void check_combinational_loop(Generator *top);
 void check_flip_flop_always_ff(Generator *top);
 
 std::unordered_map<const Stmt *, std::string> compute_enable_condition(Generator *top);
+// only compute the statements inside the generator, not its children
+std::unordered_map<const Stmt *, std::string> compute_generator_enable_condition(
+    Generator *generator);
 
 std::map<std::string, std::string> extract_struct_info(Generator *top);
 
@@ -198,6 +198,11 @@ SystemVerilogCodeGen::SystemVerilogCodeGen(kratos::Generator* generator,
     : generator_(generator), options_(std::move(options)), stream_(generator, this) {
     // if it's an external file, we don't output anything
     if (generator->external()) return;
+    if (generator->is_lazy())
+        throw GeneratorException(
+            ::format("{0} has not been elaborated. Please run elaborate_lazy_generators first",
+                     generator->name),
+            {generator});
 
     // index the named blocks
     label_index_ = index_named_block();
@@ -1308,8 +1313,21 @@ std::pair<std::string, uint32_t> generate_sv_package_header(Generator* top,
         stream << "package " << package_name << ";" << stream.endl();
     }
 
+    // definitions used by modules that have been streamed out. they are no longer reachable
+    // from the top
+    std::map<std::string, std::string> streamed_info;
+    if (top->context()) {
+        for (auto const& [name, def] : top->context()->streamed_definitions()) {
+            if (dpi_info.find(name) == dpi_info.end() &&
+                struct_info.find(name) == struct_info.end() &&
+                enum_info.find(name) == enum_info.end() &&
+                interface_info.find(name) == interface_info.end())
+                streamed_info.emplace(name, def);
+        }
+    }
+
     // all the information list
-    auto info_list = {dpi_info, struct_info, enum_info, interface_info};
+    auto info_list = {dpi_info, struct_info, enum_info, interface_info, streamed_info};
     for (auto const& info : info_list) {
         for (auto const& iter : info) {
             auto def = iter.second;
@@ -1452,6 +1470,21 @@ void output_pkg_debug_info(const std::map<std::string, Generator*>& generator_ma
     }
 }
 
+bool write_if_changed(const std::string& path, const std::string& src) {
+    if (kratos::fs::exists(path)) {
+        // load up the file
+        std::ifstream in(path);
+        std::stringstream content_stream;
+        content_stream << in.rdbuf();
+        std::string content = content_stream.str();
+        if (content == src) return false;
+    }
+    // truncate mode
+    std::ofstream out(path, std::ios::trunc);
+    out << src;
+    return true;
+}
+
 void generate_verilog_pkg(Generator* top, SystemVerilogCodeGenOptions options) {
     // input check
     if (options.package_name == top->name) {
@@ -1482,17 +1515,7 @@ void generate_verilog_pkg(Generator* top, SystemVerilogCodeGenOptions options) {
     // https://www.veripool.org/boards/2/topics/2822
     for (auto const& [module_name, src] : result) {
         auto path = kratos::fs::join(options.output_dir, module_name + ".sv");
-        if (kratos::fs::exists(path)) {
-            // load up the file
-            std::ifstream in(path);
-            std::stringstream content_stream;
-            content_stream << in.rdbuf();
-            std::string content = content_stream.str();
-            if (content == src) continue;
-        }
-        // truncate mode
-        std::ofstream out(path, std::ios::trunc);
-        out << src;
+        if (!write_if_changed(path, src)) continue;
         // tell the system where it went, if allowed
         auto gens = top->context()->get_generators_by_name(module_name);
         for (auto const& gen : gens) {
@@ -1526,8 +1549,92 @@ std::map<std::string, std::string> generate_verilog(Generator* top) {
     return generate_verilog(top, {});
 }
 
+namespace {
+void collect_subtree(Generator* generator, std::vector<Generator*>& result) {
+    for (auto const& child : generator->get_child_generators()) {
+        collect_subtree(child.get(), result);
+        result.emplace_back(child.get());
+    }
+}
+}  // namespace
+
+std::vector<std::string> stream_verilog(Generator* generator,
+                                        const SystemVerilogCodeGenOptions& options) {
+    if (options.output_dir.empty())
+        throw UserException("Streaming codegen requires an output directory");
+    if (generator->external()) return {};
+    auto* context = generator->context();
+    // every streamed module includes the same package
+    context->set_streamed_package(options.package_name);
+
+    UniqueGeneratorVisitor unique_visitor;
+    unique_visitor.visit_generator_root_p(generator);
+    auto const& generator_map = unique_visitor.generator_map();
+    for (auto const& [module_name, module_gen] : generator_map) {
+        if (!context->has_hash(module_gen))
+            throw GeneratorException(
+                ::format("{0} has to be hashed and uniquified before it is streamed", module_name),
+                {module_gen});
+    }
+
+    std::vector<std::string> result;
+    for (auto const& [module_name, module_gen] : generator_map) {
+        auto hash = context->get_hash(module_gen);
+        auto streamed_hash = context->streamed_module_hash(module_name);
+        if (streamed_hash) {
+            // same name and hash means the same content, which has been written already
+            if (*streamed_hash == hash) continue;
+            throw GeneratorException(
+                ::format("{0} has already been streamed with different content", module_name),
+                {module_gen});
+        }
+        SystemVerilogCodeGen codegen(module_gen, options);
+        auto path = kratos::fs::join(options.output_dir, module_name + ".sv");
+        write_if_changed(path, codegen.str());
+        context->add_streamed_module(module_name, hash);
+        result.emplace_back(module_name);
+    }
+    if (options.extract_debug_info) {
+        output_pkg_debug_info(generator_map, options);
+    }
+    if (!options.package_name.empty()) {
+        // written out with the package header of the top
+        auto info_list = {extract_dpi_function(generator, true), extract_struct_info(generator),
+                          extract_enum_info(generator), extract_interface_info(generator)};
+        for (auto const& info : info_list) {
+            for (auto const& [name, def] : info) context->add_streamed_definition(name, def);
+        }
+    }
+
+    // release the subtree. clones outside of it can't share the content anymore
+    std::vector<Generator*> subtree;
+    collect_subtree(generator, subtree);
+    subtree.emplace_back(generator);
+    std::unordered_set<const Generator*> subtree_set(subtree.begin(), subtree.end());
+    for (auto* gen : subtree) {
+        for (auto const& clone : gen->get_clones()) {
+            if (subtree_set.find(clone.get()) == subtree_set.end()) clone->materialize();
+        }
+    }
+    for (auto* gen : subtree) {
+        if (gen == generator) continue;
+        context->remove_hash(gen);
+        gen->release_body();
+        context->remove(gen);
+    }
+    generator->release_body();
+    return result;
+}
+
 std::map<std::string, std::string> generate_verilog(Generator* top,
                                                     SystemVerilogCodeGenOptions options) {
+    // the streamed modules include the package of the top
+    auto const* context = top->context();
+    auto const& streamed_package = context ? context->streamed_package() : std::nullopt;
+    if (streamed_package && *streamed_package != options.package_name)
+        throw UserException(::format("Package name {0} does not match the streamed modules ({1})",
+                                     options.package_name.empty() ? "<none>" : options.package_name,
+                                     streamed_package->empty() ? "<none>" : *streamed_package));
     if (options.package_name.empty()) {
         return generate_verilog_no_pkg(top, options);
     } else {
@@ -17,7 +17,7 @@ struct SystemVerilogCodeGenOptions {
     std::string package_name;
     uint64_t line_wrap = 80;
     std::string output_dir;
-    bool extract_debug_info;
+    bool extract_debug_info = false;
 };
 
 class VerilogModule {
@@ -194,5 +194,14 @@ std::map<std::string, std::string> generate_verilog(Generator *top);
 std::map<std::string, std::string> generate_verilog(Generator* top,
                                                     SystemVerilogCodeGenOptions options);
 
+// streaming mode. writes the unique modules of a finalized subtree, i.e. one that has been
+// through the passes including hashing and uniquification, into options.output_dir, then
+// reduces the subtree to an external stub with only the ports, parameters and hash left.
+// passes and codegen on the parent treat the stub as an already generated module, so peak
+// memory is bounded by the largest subtree instead of the whole design.
+// returns the names of the modules written
+std::vector<std::string> stream_verilog(Generator* generator,
+                                        const SystemVerilogCodeGenOptions& options);
+
 }  // namespace kratos
 #endif  // KRATOS_CODEGEN_HH
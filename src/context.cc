@@ -1,8 +1,11 @@
 #include "context.hh"
 
+#include <algorithm>
+
 #include "except.hh"
 #include "fmt/format.h"
 #include "generator.hh"
+#include "hash.hh"
 #include "tb.hh"
 
 using fmt::format;
@@ -11,6 +14,8 @@ using std::string;
 
 namespace kratos {
 
+Context::Context() : source_files_(SourceFileTable::shared()) {}
+
 Generator &Context::generator(const std::string &name) {
     auto const &p = std::make_shared<Generator>(this, name);
     modules_[name].emplace(p);
@@ -60,6 +65,32 @@ uint64_t Context::get_hash(const Generator *generator) const {
     return generator_hash_.at(generator);
 }
 
+std::optional<uint64_t> Context::get_source_hash(const std::string &filename,
+                                                 const std::pair<int64_t, uint64_t> &stamp) const {
+    auto iter = source_hash_.find(filename);
+    if (iter == source_hash_.end() || iter->second.first != stamp) return std::nullopt;
+    return iter->second.second;
+}
+
+void Context::add_source_hash(const std::string &filename,
+                              const std::pair<int64_t, uint64_t> &stamp, uint64_t hash) {
+    source_hash_[filename] = std::make_pair(stamp, hash);
+}
+
+std::shared_ptr<const VerilogModuleIndex> Context::get_verilog_module_index(
+    const std::string &filename, const std::pair<int64_t, uint64_t> &stamp) const {
+    auto iter = verilog_module_index_.find(filename);
+    if (iter == verilog_module_index_.end() || iter->second.first != stamp) return nullptr;
+    return iter->second.second;
+}
+
+void Context::add_verilog_module_index(const std::string &filename,
+                                       const std::pair<int64_t, uint64_t> &stamp,
+                                       std::shared_ptr<const VerilogModuleIndex> index) {
+    // replaces the entry of an older version of the file
+    verilog_module_index_[filename] = std::make_pair(stamp, std::move(index));
+}
+
 void Context::change_generator_name(Generator *generator, const std::string &new_name) {
     if (new_name.empty() || generator->name.empty()) {
         // don't care names
@@ -138,6 +169,27 @@ bool Context::is_generated_tracked(Generator *gen) const {
     return tracked_generators_.find(gen) != tracked_generators_.end();
 }
 
+void Context::add_streamed_module(const std::string &name, uint64_t hash) {
+    auto iter = streamed_modules_.find(name);
+    if (iter != streamed_modules_.end() && iter->second != hash)
+        throw InternalException(
+            ::format("{0} has already been streamed with a different hash", name));
+    streamed_modules_.emplace(name, hash);
+}
+
+void Context::set_streamed_package(const std::string &package_name) {
+    if (streamed_package_ && *streamed_package_ != package_name)
+        throw UserException(::format("Modules have already been streamed with package {0}",
+                                     streamed_package_->empty() ? "<none>" : *streamed_package_));
+    streamed_package_ = package_name;
+}
+
+std::optional<uint64_t> Context::streamed_module_hash(const std::string &name) const {
+    auto iter = streamed_modules_.find(name);
+    if (iter == streamed_modules_.end()) return std::nullopt;
+    return iter->second;
+}
+
 bool Context::is_unique(kratos::Generator *gen) const {
     if (gen == nullptr) return false;
     if (modules_.find(gen->name) == modules_.end()) return false;
@@ -151,12 +203,122 @@ bool Context::is_unique(kratos::Generator *gen) const {
     return c == 1;
 }
 
+namespace {
+void append_length(std::string &result, uint64_t length) {
+    result.append(reinterpret_cast<const char *>(&length), sizeof(length));
+}
+}  // namespace
+
+void GeneratorCacheKey::add(const std::string &name, std::string value) {
+    auto pos = std::find_if(params_.begin(), params_.end(),
+                            [&name](auto const &param) { return param.first == name; });
+    if (pos != params_.end()) throw UserException(::format("Parameter {0} already exists", name));
+    params_.emplace_back(name, std::move(value));
+    canonical_ = std::nullopt;
+}
+
+const std::string &GeneratorCacheKey::canonical() const {
+    if (!canonical_) {
+        auto params = params_;
+        std::sort(params.begin(), params.end(),
+                  [](auto const &a, auto const &b) { return a.first < b.first; });
+        std::string result;
+        append_length(result, class_name_.size());
+        result.append(class_name_);
+        for (auto const &[name, value] : params) {
+            append_length(result, name.size());
+            result.append(name);
+            result.append(value);
+        }
+        canonical_ = std::move(result);
+    }
+    return *canonical_;
+}
+
+GeneratorCacheKey::Digest GeneratorCacheKey::digest() const {
+    auto const &key = canonical();
+    return hash_128(key.data(), key.size());
+}
+
+std::string GeneratorCacheKey::encode(ValueType type, const std::string &payload) {
+    std::string result(1, static_cast<char>(type));
+    append_length(result, payload.size());
+    result.append(payload);
+    return result;
+}
+
+std::string GeneratorCacheKey::encode(ValueType type, std::vector<std::string> items) {
+    if (type == ValueType::Set || type == ValueType::Dict) {
+        std::sort(items.begin(), items.end());
+    }
+    std::string payload;
+    for (auto const &item : items) payload.append(item);
+    return encode(type, payload);
+}
+
+std::shared_ptr<Generator> Context::get_cached_generator(const GeneratorCacheKey &key) const {
+    auto iter = generator_cache_.find(key.digest());
+    if (iter == generator_cache_.end()) return nullptr;
+    auto const &canonical = key.canonical();
+    for (auto const &[entry_key, generator] : iter->second) {
+        if (entry_key == canonical) return generator;
+    }
+    return nullptr;
+}
+
+void Context::add_cached_generator(const GeneratorCacheKey &key,
+                                   const std::shared_ptr<Generator> &generator) {
+    auto &entries = generator_cache_[key.digest()];
+    auto const &canonical = key.canonical();
+    for (auto &[entry_key, entry] : entries) {
+        if (entry_key == canonical) {
+            entry = generator;
+            return;
+        }
+    }
+    entries.emplace_back(canonical, generator);
+}
+
+uint64_t Context::generator_cache_size() const {
+    uint64_t result = 0;
+    for (auto const &iter : generator_cache_) result += iter.second.size();
+    return result;
+}
+
+void Context::add_pass_visits(const std::string &pass_name, uint64_t visits) {
+    pass_visits_[pass_name] += visits;
+}
+
+IRStats Context::ir_stats() const {
+    IRStats stats;
+    stats.node_visits = ir_counter(IRCounter::NodeVisits);
+    stats.exprs_created = ir_counter(IRCounter::ExprsCreated);
+    stats.slice_cache_hits = ir_counter(IRCounter::SliceCacheHits);
+    stats.slice_cache_misses = ir_counter(IRCounter::SliceCacheMisses);
+    stats.stmts_added = ir_counter(IRCounter::StmtsAdded);
+    stats.stmts_removed = ir_counter(IRCounter::StmtsRemoved);
+    stats.src_moves = ir_counter(IRCounter::SrcMoves);
+    stats.sink_moves = ir_counter(IRCounter::SinkMoves);
+    stats.pass_visits = pass_visits_;
+    return stats;
+}
+
+void Context::reset_ir_stats() {
+    for (auto &counter : ir_counters_) counter.store(0, std::memory_order_relaxed);
+    pass_visits_.clear();
+}
+
 void Context::clear() {
     modules_.clear();
+    clear_generator_cache();
     clear_hash();
     reset_id();
     enum_defs_.clear();
     clear_tracked_generator();
+    streamed_modules_.clear();
+    streamed_definitions_.clear();
+    streamed_package_.reset();
+    verilog_module_index_.clear();
 }
 
 }  // namespace kratos
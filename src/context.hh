@@ -1,12 +1,16 @@
 #ifndef KRATOS_CONTEXT_HH
 #define KRATOS_CONTEXT_HH
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace kratos {
 
@@ -34,6 +38,7 @@ struct EnumVar;
 struct FunctionCallVar;
 struct PackedSlice;
 class Stmt;
+class SourceFileTable;
 class AssignStmt;
 class IfStmt;
 class SwitchStmt;
@@ -67,10 +72,96 @@ struct InterfaceRef;
 class Property;
 class Sequence;
 
+// canonical key of a generator parametrization: class name plus parameters sorted by name.
+// every value is tagged with its type, so 1, 1.0, true and "1" are different keys
+class GeneratorCacheKey {
+public:
+    enum class ValueType : char {
+        None = 'n',
+        Bool = 'b',
+        Int = 'i',
+        Float = 'f',
+        Str = 's',
+        Bytes = 'y',
+        Tuple = 't',
+        List = 'l',
+        Set = 'S',
+        Dict = 'd',
+        Object = 'o'
+    };
+    using Digest = std::pair<uint64_t, uint64_t>;
+
+    explicit GeneratorCacheKey(std::string class_name) : class_name_(std::move(class_name)) {}
+
+    // value is produced by one of the encode functions
+    void add(const std::string& name, std::string value);
+    const std::string& canonical() const;
+    Digest digest() const;
+
+    // encoded values are self-delimiting. items of sets and dicts are sorted
+    static std::string encode(ValueType type, const std::string& payload);
+    static std::string encode(ValueType type, std::vector<std::string> items);
+
+private:
+    std::string class_name_;
+    std::vector<std::pair<std::string, std::string>> params_;
+    mutable std::optional<std::string> canonical_;
+};
+
+// counters over the IR hot paths. they are only updated when kratos is built with
+// KRATOS_IR_STATS, otherwise counting compiles away
+enum class IRCounter : int {
+    NodeVisits,
+    ExprsCreated,
+    SliceCacheHits,
+    SliceCacheMisses,
+    StmtsAdded,
+    StmtsRemoved,
+    SrcMoves,
+    SinkMoves,
+    Size
+};
+
+#ifdef KRATOS_IR_STATS
+#define KRATOS_IR_COUNT(context, counter)                                          \
+    do {                                                                           \
+        if (auto *ir_stats_context_ = (context))                                   \
+            ir_stats_context_->count(::kratos::IRCounter::counter);                \
+    } while (0)
+#else
+#define KRATOS_IR_COUNT(context, counter) \
+    do {                                  \
+    } while (0)
+#endif
+
+// snapshot of the IR counters
+struct IRStats {
+    uint64_t node_visits = 0;
+    uint64_t exprs_created = 0;
+    uint64_t slice_cache_hits = 0;
+    uint64_t slice_cache_misses = 0;
+    uint64_t stmts_added = 0;
+    uint64_t stmts_removed = 0;
+    uint64_t src_moves = 0;
+    uint64_t sink_moves = 0;
+    // node visits made by each pass run through a PassManager, keyed by pass name
+    std::map<std::string, uint64_t> pass_visits;
+};
+
+// [begin, end) offsets of every module definition in a verilog file, keyed by module name
+using VerilogModuleIndex = std::unordered_map<std::string, std::pair<uint64_t, uint64_t>>;
+
 class Context {
 private:
     std::unordered_map<std::string, std::set<std::shared_ptr<Generator>>> modules_;
     std::unordered_map<const Generator*, uint64_t> generator_hash_;
+    // hash of external source files, keyed by path and invalidated by (mtime, size)
+    std::unordered_map<std::string, std::pair<std::pair<int64_t, uint64_t>, uint64_t>>
+        source_hash_;
+    // module index of external verilog files, keyed by path and invalidated by (mtime, size)
+    std::unordered_map<std::string, std::pair<std::pair<int64_t, uint64_t>,
+                                              std::shared_ptr<const VerilogModuleIndex>>>
+        verilog_module_index_;
     int max_instance_id_ = 0;
     int max_stmt_id_ = 0;
 
@@ -80,14 +171,38 @@ private:
     // just hold some generators that's not essential
     std::unordered_set<std::shared_ptr<Generator>> empty_generators_;
 
+    // parametrized generators. the 128-bit digest picks the bucket and the canonical key is
+    // compared in full, so digest collisions never return the wrong generator
+    struct DigestHash {
+        size_t operator()(const GeneratorCacheKey::Digest& digest) const { return digest.first; }
+    };
+    std::unordered_map<GeneratorCacheKey::Digest,
+                       std::vector<std::pair<std::string, std::shared_ptr<Generator>>>, DigestHash>
+        generator_cache_;
+
     // for some cases we need to keep hash for generated generators,
     // this is particular useful in python env where kratos is used to generate
     // building blocks separately to RTL
     bool track_generated_ = false;
     std::unordered_set<Generator*> tracked_generators_;
 
+    // modules already written out by stream_verilog and their hash. their generators are
+    // reduced to external stubs, so the names have to stay reserved
+    std::unordered_map<std::string, uint64_t> streamed_modules_;
+    // package definitions used by the streamed modules
+    std::map<std::string, std::string> streamed_definitions_;
+    // package the streamed modules include. the top has to be generated with the same one
+    std::optional<std::string> streamed_package_;
+
+    // IR stats. counters are bumped concurrently by parallel passes
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(IRCounter::Size)> ir_counters_ = {};
+    std::map<std::string, uint64_t> pass_visits_;
+
+    // file names of the debug info, shared with the other live contexts
+    std::shared_ptr<SourceFileTable> source_files_;
+
 public:
-    Context() = default;
+    Context();
 
     Generator& generator(const std::string& name);
     Generator& empty_generator();
@@ -100,9 +215,25 @@ public:
     bool has_hash(const Generator* generator) const;
     uint64_t get_hash(const Generator* generator) const;
     void inline clear_hash() { generator_hash_.clear(); }
+    void inline remove_hash(const Generator* generator) { generator_hash_.erase(generator); }
+    std::optional<uint64_t> get_source_hash(const std::string& filename,
+                                            const std::pair<int64_t, uint64_t>& stamp) const;
+    void add_source_hash(const std::string& filename, const std::pair<int64_t, uint64_t>& stamp,
+                         uint64_t hash);
+    std::shared_ptr<const VerilogModuleIndex> get_verilog_module_index(
+        const std::string& filename, const std::pair<int64_t, uint64_t>& stamp) const;
+    void add_verilog_module_index(const std::string& filename,
+                                  const std::pair<int64_t, uint64_t>& stamp,
+                                  std::shared_ptr<const VerilogModuleIndex> index);
 
     void reset_id();
 
+    std::shared_ptr<Generator> get_cached_generator(const GeneratorCacheKey& key) const;
+    void add_cached_generator(const GeneratorCacheKey& key,
+                              const std::shared_ptr<Generator>& generator);
+    void inline clear_generator_cache() { generator_cache_.clear(); }
+    uint64_t generator_cache_size() const;
+
     // for debugging
     uint64_t hash_table_size() const { return generator_hash_.size(); }
 
@@ -126,6 +257,36 @@ public:
 
     [[nodiscard]] bool is_unique(Generator *gen) const;
 
+    void add_streamed_module(const std::string& name, uint64_t hash);
+    std::optional<uint64_t> streamed_module_hash(const std::string& name) const;
+    void add_streamed_definition(const std::string& name, const std::string& definition) {
+        streamed_definitions_.emplace(name, definition);
+    }
+    const std::map<std::string, std::string>& streamed_definitions() const {
+        return streamed_definitions_;
+    }
+    void set_streamed_package(const std::string& package_name);
+
+    const std::shared_ptr<SourceFileTable>& source_files() const { return source_files_; }
+    const std::optional<std::string>& streamed_package() const { return streamed_package_; }
+
+    static constexpr bool ir_stats_enabled() {
+#ifdef KRATOS_IR_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+    inline void count(IRCounter counter) {
+        ir_counters_[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+    }
+    uint64_t ir_counter(IRCounter counter) const {
+        return ir_counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    void add_pass_visits(const std::string& pass_name, uint64_t visits);
+    IRStats ir_stats() const;
+    void reset_ir_stats();
+
     void clear();
 };
 
@@ -1,7 +1,14 @@
 #include "debug.hh"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
 #include <mutex>
+#include <optional>
 
+#include "analysis.hh"
+#include "cxxpool.h"
 #include "except.hh"
 #include "fmt/format.h"
 #include "generator.hh"
@@ -111,21 +118,17 @@ std::unordered_map<Var *, std::unordered_set<Var *>> find_driver_signal(Generato
 class PropagateScopeVisitor : public IRVisitor {
 public:
     void visit(IfStmt *stmt) override {
-        auto variables = stmt->scope_context();
-        for (auto const &[name, var] : variables) {
-            stmt->then_body()->add_scope_variable(name, var.second, var.first, false);
-            stmt->else_body()->add_scope_variable(name, var.second, var.first, false);
-        }
+        auto const &frame = stmt->scope_frame();
+        if (!frame) return;
+        stmt->then_body()->inherit_scope_context(frame);
+        stmt->else_body()->inherit_scope_context(frame);
     }
 
     void visit(SwitchStmt *stmt) override {
-        auto variables = stmt->scope_context();
-        for (auto const &[name, var] : variables) {
-            auto cases = stmt->body();
-            for (auto &iter : cases) {
-                auto case_ = iter.second;
-                case_->add_scope_variable(name, var.second, var.first, false);
-            }
+        auto const &frame = stmt->scope_frame();
+        if (!frame) return;
+        for (auto const &iter : stmt->body()) {
+            iter.second->inherit_scope_context(frame);
         }
     }
 };
@@ -166,10 +169,7 @@ void mock_hierarchy(Generator *top, const std::string &top_name) {
 void DebugDatabase::compute_generators(Generator *top) {
     top_ = top;
     GeneratorGraph g(top);
-    auto generators = g.get_sorted_nodes();
-    for (auto *gen : generators) {
-        generators_.emplace(gen);
-    }
+    generators_ = g.get_sorted_nodes();
 }
 
 void DebugDatabase::set_break_points(Generator *top) { set_break_points(top, ".py"); }
@@ -181,8 +181,7 @@ void DebugDatabase::set_break_points(Generator *top, const std::string &ext) {
     // index all the front-end code
     // we are only interested in the files that has the extension
     for (auto const *stmt : break_points_) {
-        auto fn_ln = stmt->fn_name_ln;
-        for (auto const &[fn, ln] : fn_ln) {
+        for (auto const &[fn, ln] : stmt->fn_name_ln) {
             auto fn_ext = fs::get_ext(fn);
             if (fn_ext == ext) {
                 // this is the one we need
@@ -397,7 +396,13 @@ private:
         // store all the context variables
         // TODO: use stack address as a way to determine the actual scope
         //  for now we flatten everything
-        for (auto const &[name, value_pair] : stmt->scope_context()) {
+        // statements share scope frames, so each frame only needs to be stored once per scope
+        auto const &frame = stmt->scope_frame();
+        if (!frame || !stored_frames_[parent_scope].emplace(frame.get()).second) {
+            add_stmt_scope(parent_scope, stmt, filename, ln);
+            return;
+        }
+        for (auto const &[name, value_pair] : frame->flatten()) {
             auto const &[rtl, value] = value_pair;
             // we don't put line number down for static variables
             // since we can't obtain them from Python
@@ -406,6 +411,11 @@ private:
                 var_stmt->condition = enable_conditions_.at(stmt);
             }
         }
+        add_stmt_scope(parent_scope, stmt, filename, ln);
+    }
+
+    void add_stmt_scope(hgdb::json::Scope<> *parent_scope, Stmt *stmt,
+                        const std::string &filename, uint32_t ln) {
         // add itself
         auto *stmt_scope = add_stmt(parent_scope, stmt, filename, ln);
         if (stmt_scope) {
@@ -486,79 +496,587 @@ private:
     hgdb::json::Module &module_;
     const Generator *gen_;
     std::unordered_map<const Stmt *, hgdb::json::Scope<> *> stmt_scope_mapping_;
+    std::unordered_map<const hgdb::json::Scope<> *, std::unordered_set<const ScopeContext *>>
+        stored_frames_;
     const std::map<const Stmt *, std::pair<std::string, uint32_t>> &stmt_fn_ln_;
     const std::unordered_map<const Stmt *, std::string> &enable_conditions_;
 };
 
-void DebugDatabase::save_database(const std::string &filename, bool override) {
-    if (override) {
-        if (fs::exists(filename)) {
-            fs::remove(filename);
+namespace {
+// every module in the database is written on its own line, and so is every variable. the key of
+// each section is kept in an index next to the database, which stays a plain hgdb symbol table.
+// when the database is saved again, modules whose key did not change, together with their
+// variables, are copied over from the previous file verbatim
+constexpr std::string_view table_end = R"(],"variables":[)";
+constexpr std::string_view database_end = R"(],"reorder":false})";
+constexpr std::string_view variable_id = R"("id":")";
+constexpr std::string_view index_header = "kratos-debug-sections ";
+
+std::string index_filename(const std::string &filename) { return filename + ".sections"; }
+
+struct DatabaseSection {
+    std::string module;
+    std::vector<std::string> variables;
+};
+
+// location of a section in the previous file. its variables are on consecutive lines
+struct PreviousSection {
+    std::string_view module;
+    std::string_view variables;
+    uint64_t num_variables = 0;
+};
+
+struct PreviousDatabase {
+    // the reused sections are copied from the mapped file, which is kept open while saving
+    std::unique_ptr<fs::MappedFile> file;
+    std::unordered_map<uint64_t, PreviousSection> sections;
+};
+
+bool consume(std::string_view &str, std::string_view prefix) {
+    if (str.substr(0, prefix.size()) != prefix) return false;
+    str.remove_prefix(prefix.size());
+    return true;
+}
+
+bool consume_number(std::string_view &str, uint64_t &value, int base = 10) {
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value, base);
+    if (ec != std::errc() || ptr == str.data()) return false;
+    str.remove_prefix(ptr - str.data());
+    return true;
+}
+
+// the index holds the size of the database it describes, followed by the key and the number of
+// variables of every section
+std::optional<std::vector<std::pair<uint64_t, uint64_t>>> load_index(const std::string &filename,
+                                                                     uint64_t database_size) {
+    if (!fs::exists(filename)) return std::nullopt;
+    fs::MappedFile file(filename);
+    auto content = file.content();
+    uint64_t size;
+    if (!consume(content, index_header) || !consume_number(content, size) ||
+        !consume(content, "\n") || size != database_size)
+        return std::nullopt;
+    std::vector<std::pair<uint64_t, uint64_t>> keys;
+    while (!content.empty()) {
+        uint64_t key, count;
+        if (!consume_number(content, key, 16) || !consume(content, " ") ||
+            !consume_number(content, count) || !consume(content, "\n"))
+            return std::nullopt;
+        keys.emplace_back(key, count);
+    }
+    return keys;
+}
+
+PreviousDatabase load_previous_database(const std::string &filename) {
+    PreviousDatabase result;
+    if (!fs::exists(filename)) return result;
+    auto file = std::make_unique<fs::MappedFile>(filename);
+    auto content = file->content();
+    // anything we don't recognize, e.g. an older format, is rebuilt from scratch
+    if (content.substr(0, 21) != R"({"generator":"kratos")") return result;
+    auto index = load_index(index_filename(filename), content.size());
+    if (!index) return result;
+    auto const &keys = *index;
+
+    // the database ends with a line of its own
+    if (content.size() <= database_end.size() || content.back() != '\n') return result;
+    auto trailer_pos = content.size() - database_end.size() - 1;
+    if (content.substr(trailer_pos, database_end.size()) != database_end) return result;
+
+    uint64_t pos = content.find('\n');
+    auto next_line = [&](std::string_view &line) {
+        if (pos >= trailer_pos) return false;
+        pos++;
+        auto next = content.find('\n', pos);
+        if (next == std::string_view::npos || next > trailer_pos) next = trailer_pos;
+        line = content.substr(pos, next - pos);
+        pos = next;
+        return true;
+    };
+    std::unordered_map<uint64_t, PreviousSection> sections;
+    std::vector<PreviousSection *> section_list;
+    section_list.reserve(keys.size());
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        std::string_view line;
+        if (!next_line(line) || (i > 0 && !consume(line, ","))) return result;
+        auto key = keys[i].first;
+        PreviousSection *section = nullptr;
+        if (key != 0) {
+            auto [iter, inserted] = sections.emplace(key, PreviousSection{line, {}, 0});
+            if (inserted) section = &iter->second;
+        }
+        section_list.emplace_back(section);
+    }
+    std::string_view line;
+    if (!next_line(line) || line != table_end) return result;
+
+    uint64_t num_variables = 0;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        auto count = keys[i].second;
+        if (count == 0) continue;
+        auto start = pos + 1;
+        for (uint64_t j = 0; j < count; j++) {
+            if (!next_line(line) || (num_variables++ > 0 && !consume(line, ","))) return result;
+            if (j == 0) start = line.data() - content.data();
+        }
+        if (section_list[i]) {
+            section_list[i]->variables = content.substr(start, pos - start);
+            section_list[i]->num_variables = count;
         }
     }
+    // the trailer has to follow the variables directly
+    if (pos + 1 != trailer_pos) return result;
 
-    // compute breakpoint conditions
-    auto breakpoint_conditions = compute_enable_condition(top_);
-    auto table = hgdb::json::SymbolTable("kratos");
+    result.file = std::move(file);
+    result.sections = std::move(sections);
+    return result;
+}
+
+// variable ids used by a section of the previous file
+void collect_variable_ids(const PreviousSection &section, std::vector<uint64_t> &ids) {
+    auto variables = section.variables;
+    for (auto pos = variables.find(variable_id); pos != std::string_view::npos;
+         pos = variables.find(variable_id)) {
+        variables.remove_prefix(pos + variable_id.size());
+        uint64_t id;
+        if (consume_number(variables, id)) ids.emplace_back(id);
+    }
+}
 
-    std::unordered_map<Generator *, hgdb::json::Module *> gen_mod_map;
+// hands out the smallest ids that are not taken by the reused sections, so that the ids of the
+// sections that are rebuilt or dropped are given out again
+class VariableIdAllocator {
+public:
+    explicit VariableIdAllocator(std::vector<uint64_t> used) : used_(std::move(used)) {
+        std::sort(used_.begin(), used_.end());
+    }
 
-    // first pass to create modules
-    for (auto *gen : generators_) {
-        auto *mod = table.add_module(gen->name);
-        gen_mod_map.emplace(gen, mod);
+    uint64_t next() {
+        while (used_pos_ < used_.size() && used_[used_pos_] <= next_) {
+            if (used_[used_pos_] == next_) next_++;
+            used_pos_++;
+        }
+        return next_++;
+    }
+
+private:
+    std::vector<uint64_t> used_;
+    uint64_t used_pos_ = 0;
+    uint64_t next_ = 0;
+};
+
+// digest of the debug information that is not covered by the generator hash
+class DebugSectionDigestVisitor : public IRVisitor {
+public:
+    DebugSectionDigestVisitor(
+        std::string &buffer,
+        const std::map<const Stmt *, std::pair<std::string, uint32_t>> &stmt_fn_ln)
+        : buffer_(buffer), stmt_fn_ln_(stmt_fn_ln) {}
+    void visit(AssignStmt *stmt) override { handle_stmt(stmt); }
+    void visit(ScopedStmtBlock *stmt) override { handle_stmt(stmt); }
+    void visit(IfStmt *stmt) override { handle_stmt(stmt); }
+    void visit(SwitchStmt *stmt) override { handle_stmt(stmt); }
+    void visit(FunctionCallStmt *stmt) override { handle_stmt(stmt); }
+    void visit(ReturnStmt *stmt) override { handle_stmt(stmt); }
+    void visit(AssertBase *stmt) override { handle_stmt(stmt); }
+    void visit(AuxiliaryStmt *stmt) override { handle_stmt(stmt); }
+    void visit(CombinationalStmtBlock *stmt) override { handle_stmt(stmt); }
+    void visit(SequentialStmtBlock *stmt) override { handle_stmt(stmt); }
+    void visit(LatchStmtBlock *stmt) override { handle_stmt(stmt); }
+
+private:
+    void handle_stmt(Stmt *stmt) {
+        buffer_.append(";");
+        if (stmt_fn_ln_.find(stmt) != stmt_fn_ln_.end()) {
+            auto const &[fn, ln] = stmt_fn_ln_.at(stmt);
+            buffer_.append(::format("{0}:{1}", fn, ln));
+        }
+        auto const &frame = stmt->scope_frame();
+        if (!frame) return;
+        // statements share frames so each of them is only flattened once
+        if (frame_digest_.find(frame.get()) == frame_digest_.end()) {
+            std::string str;
+            for (auto const &[name, entry] : frame->flatten()) {
+                str.append(::format("{0}={1}{2},", name, entry.first, entry.second));
+            }
+            frame_digest_.emplace(frame.get(), hash_64_fnv1a(str.data(), str.size()));
+        }
+        buffer_.append(std::to_string(frame_digest_.at(frame.get())));
+    }
+
+    std::string &buffer_;
+    const std::map<const Stmt *, std::pair<std::string, uint32_t>> &stmt_fn_ln_;
+    std::unordered_map<const ScopeContext *, uint64_t> frame_digest_;
+};
+
+std::string json_string(std::string_view str) {
+    std::string result = "\"";
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+            result.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result.append(::format("\\u{0:04x}", static_cast<int>(c)));
+        } else {
+            result.push_back(c);
+        }
+    }
+    result.push_back('"');
+    return result;
+}
+
+// same as the filename compression of hgdb's SymbolTable: a scope doesn't repeat the filename of
+// its parent
+void clear_repeated_filenames(hgdb::json::ScopeBase *scope) {
+    for (auto const &child : *scope) clear_repeated_filenames(child.get());
+    std::string *filename = nullptr;
+    if (auto *s = dynamic_cast<hgdb::json::Scope<> *>(scope)) {
+        filename = &s->filename;
+    } else if (auto *v = dynamic_cast<hgdb::json::VarStmt *>(scope)) {
+        filename = &v->filename;
+    }
+    if (!filename || filename->empty() || !scope->parent) return;
+    // top level scopes need to have the filename
+    if (dynamic_cast<hgdb::json::Module *>(scope->parent)) return;
+    if (scope->parent->get_filename() == *filename) filename->clear();
+}
+
+// a variable is serialized as {"name":"...","value":"...","rtl":...}. instances also start with
+// a name, so the whole object is matched
+std::string_view match_variable(std::string_view text) {
+    constexpr std::string_view name = R"({"name":")";
+    constexpr std::string_view value = R"(","value":")";
+    constexpr std::string_view rtl = R"(","rtl":)";
+    auto rest = text;
+    if (!consume(rest, name)) return {};
+    auto pos = rest.find('"');
+    if (pos == std::string_view::npos) return {};
+    rest.remove_prefix(pos);
+    if (!consume(rest, value)) return {};
+    pos = rest.find('"');
+    if (pos == std::string_view::npos) return {};
+    rest.remove_prefix(pos);
+    if (!consume(rest, rtl)) return {};
+    if (!consume(rest, "true}") && !consume(rest, "false}")) return {};
+    return text.substr(0, text.size() - rest.size());
+}
+
+// variables used more than once in the serialized module, in the order they first appear. these
+// are moved to the variable table and referenced by id, the same way hgdb's SymbolTable compresses
+// them. since modules are written out before the rest of the design is built, only the
+// variables within a module are shared
+std::vector<std::string> shared_variables(std::string_view module) {
+    std::unordered_map<std::string_view, uint64_t> count;
+    std::vector<std::string_view> order;
+    for (auto pos = module.find(R"({"name":")"); pos != std::string_view::npos;
+         pos = module.find(R"({"name":")", pos + 1)) {
+        auto var = match_variable(module.substr(pos));
+        if (var.empty()) continue;
+        if (count[var]++ == 0) order.emplace_back(var);
+    }
+    std::vector<std::string> result;
+    for (auto const &var : order) {
+        if (count.at(var) > 1) result.emplace_back(var);
+    }
+    return result;
+}
+
+// replaces the shared variables in the module with their ids and returns the entries of the
+// variable table
+std::vector<std::string> assign_variable_ids(std::string &module,
+                                             const std::vector<std::string> &variables,
+                                             const std::vector<uint64_t> &ids) {
+    std::unordered_map<std::string_view, uint64_t> id_map;
+    std::vector<std::string> entries;
+    entries.reserve(variables.size());
+    for (uint64_t i = 0; i < variables.size(); i++) {
+        id_map.emplace(variables[i], ids[i]);
+        auto const &var = variables[i];
+        entries.emplace_back(
+            ::format(R"({0},"id":"{1}"}})", std::string_view(var).substr(0, var.size() - 1), ids[i]));
     }
-    // second pass to add instances
+    if (variables.empty()) return entries;
+
+    std::string result;
+    result.reserve(module.size());
+    uint64_t copied = 0;
+    std::string_view text = module;
+    for (auto pos = text.find(R"({"name":")"); pos != std::string_view::npos;
+         pos = text.find(R"({"name":")", pos + 1)) {
+        auto var = match_variable(text.substr(pos));
+        if (var.empty() || id_map.find(var) == id_map.end()) continue;
+        result.append(text.substr(copied, pos - copied));
+        result.append(::format(R"("{0}")", id_map.at(var)));
+        copied = pos + var.size();
+        pos = copied - 1;
+    }
+    result.append(text.substr(copied));
+    module = std::move(result);
+    return entries;
+}
+}  // namespace
+
+void DebugDatabase::save_database(const std::string &filename, bool override) {
+    // sections from the previous output can be reused regardless of whether we override.
+    // the file is removed instead of truncated since they are copied from its mapping
+    auto previous = load_previous_database(filename);
+    if (override || previous.file) {
+        if (fs::exists(filename)) {
+            fs::remove(filename);
+        }
+    }
+    // the index is written last. until then, a stale one must not describe the new file
+    if (fs::exists(index_filename(filename))) fs::remove(index_filename(filename));
+
+    // modules are created and serialized independently, in batches, and written out to the
+    // stream in order. only the current batch is kept in memory
+    std::unordered_set<Generator *> gen_set(generators_.begin(), generators_.end());
+    std::set<std::string> top_names;
+    for (auto *gen : generators_) top_names.emplace(gen->name);
     for (auto *gen : generators_) {
-        auto *mod = gen_mod_map.at(gen);
         auto children = gen->get_child_generators();
         for (auto const &child : children) {
-            if (gen_mod_map.find(child.get()) == gen_mod_map.end()) continue;
-            auto *child_mod = gen_mod_map.at(child.get());
-            mod->add_instance(child->instance_name, child_mod);
+            if (gen_set.find(child.get()) != gen_set.end()) top_names.erase(child->name);
         }
     }
 
-    // now add generator variables
-    for (auto *gen : generators_) {
-        if (variable_mapping_.find(gen) == variable_mapping_.end()) continue;
-        auto *mod = gen_mod_map.at(gen);
-        auto const &var_names = variable_mapping_.at(gen);
-        for (auto const &[front_name, back_name] : var_names) {
-            auto var = gen->get_var(back_name);
-            if (var && (var->type() == VarType::Base || var->type() == VarType::PortIO)) {
-                auto vars = create_variables(var.get(), front_name);
-                for (auto const &v : vars) {
-                    mod->add_variable(v.first);
+    std::unordered_set<Generator *> scope_gens;
+    for (auto const *stmt : break_points_) {
+        auto *gen = stmt->generator_parent();
+        if (gen && gen_set.find(gen) != gen_set.end()) scope_gens.emplace(gen);
+    }
+
+    std::ofstream stream;
+    stream.open(filename);
+    stream << R"({"generator":"kratos","top":)";
+    if (top_names.size() == 1) {
+        stream << json_string(*top_names.begin());
+    } else {
+        stream << '[';
+        for (auto it = top_names.begin(); it != top_names.end(); it++) {
+            if (it != top_names.begin()) stream << ',';
+            stream << json_string(*it);
+        }
+        stream << ']';
+    }
+    stream << R"(,"table":[)" << '\n';
+
+    // a section can only be reused if the generator has been hashed. 0 means not cacheable
+    auto section_key = [&](Generator *gen) -> uint64_t {
+        auto *context = gen->context();
+        if (!context || !context->has_hash(gen)) return 0;
+        std::string buffer = ::format("{0}#{1}", gen->name, context->get_hash(gen));
+        auto children = gen->get_child_generators();
+        for (auto const &child : children) {
+            if (gen_set.find(child.get()) == gen_set.end()) continue;
+            buffer.append(::format(";{0}:{1}", child->instance_name, child->name));
+        }
+        if (variable_mapping_.find(gen) != variable_mapping_.end()) {
+            for (auto const &[front_name, back_name] : variable_mapping_.at(gen)) {
+                buffer.append(::format(";{0}={1}", front_name, back_name));
+            }
+        }
+        for (auto const &[name, var] : gen->vars()) {
+            if (var->fn_name_ln.empty()) continue;
+            buffer.append(::format(";{0}@{1}", name, var->fn_name_ln.front().second));
+        }
+        if (scope_gens.find(gen) != scope_gens.end()) {
+            DebugSectionDigestVisitor v(buffer, stmt_mapping_);
+            v.visit_content(gen);
+        }
+        auto key = hash_64_fnv1a(buffer.data(), buffer.size());
+        return key == 0 ? 1 : key;
+    };
+
+    // the modules are built in parallel. variable ids are assigned when a batch is written out,
+    // in generator order, so that the database does not depend on the scheduling
+    struct PendingModule {
+        std::unique_ptr<hgdb::json::Module> mod;
+        std::vector<std::unique_ptr<hgdb::json::Module>> child_mods;
+        std::vector<std::string> shared_variables;
+    };
+    auto build_module = [&](Generator *gen,
+                            const std::unordered_map<const Stmt *, std::string> &conditions,
+                            PendingModule &pending) {
+        auto no_op = [](const std::string &) {};
+        pending.mod = std::make_unique<hgdb::json::Module>(gen->name, no_op);
+        auto &mod = *pending.mod;
+        // instances only need the module name
+        auto children = gen->get_child_generators();
+        for (auto const &child : children) {
+            if (gen_set.find(child.get()) == gen_set.end()) continue;
+            auto const &child_mod = pending.child_mods.emplace_back(
+                std::make_unique<hgdb::json::Module>(child->name, no_op));
+            mod.add_instance(child->instance_name, child_mod.get());
+        }
+
+        // now add generator variables
+        if (variable_mapping_.find(gen) != variable_mapping_.end()) {
+            auto const &var_names = variable_mapping_.at(gen);
+            for (auto const &[front_name, back_name] : var_names) {
+                auto var = gen->get_var(back_name);
+                if (var && (var->type() == VarType::Base || var->type() == VarType::PortIO)) {
+                    auto vars = create_variables(var.get(), front_name);
+                    for (auto const &v : vars) {
+                        mod.add_variable(v.first);
+                    }
+                } else if (!var) {
+                    add_generator_static_value(mod, front_name, back_name);
                 }
-            } else if (!var) {
-                add_generator_static_value(*mod, front_name, back_name);
             }
         }
-    }
 
-    // now deal with scopes
-    std::unordered_set<Generator *> visited_gens;
-    for (auto const *stmt : break_points_) {
-        auto *gen = stmt->generator_parent();
-        if (!gen || visited_gens.find(gen) != visited_gens.end()) continue;
-        if (gen_mod_map.find(gen) == gen_mod_map.end()) continue;
-        visited_gens.emplace(gen);
-        auto *mod = gen_mod_map.at(gen);
-        StmtScopeVisitor v(*mod, gen, stmt_mapping_, breakpoint_conditions);
-        v.visit_content(gen);
+        // now deal with scopes
+        if (scope_gens.find(gen) != scope_gens.end()) {
+            StmtScopeVisitor v(mod, gen, stmt_mapping_, conditions);
+            v.visit_content(gen);
+        }
+    };
+
+    auto serialize_module = [&](PendingModule &pending, DatabaseSection &section) {
+        clear_repeated_filenames(pending.mod.get());
+        hgdb::json::JSONWriter w;
+        pending.mod->serialize(w);
+        section.module = w.str();
+        // remove the new line
+        section.module.pop_back();
+        pending.shared_variables = shared_variables(section.module);
+        pending.mod.reset();
+        pending.child_mods.clear();
+    };
+
+    uint32_t num_cpus = get_num_cpus();
+    cxxpool::thread_pool pool{num_cpus};
+
+    // all the keys are needed upfront to know which ids the reused sections hold on to
+    std::vector<std::pair<uint64_t, uint64_t>> keys(generators_.size());
+    std::vector<std::optional<PreviousSection>> reused(generators_.size());
+    {
+        std::vector<std::future<uint64_t>> key_tasks;
+        key_tasks.reserve(generators_.size());
+        for (auto *gen : generators_) key_tasks.emplace_back(pool.push(section_key, gen));
+        for (uint64_t i = 0; i < key_tasks.size(); i++) keys[i].first = key_tasks[i].get();
+    }
+    std::vector<uint64_t> used_ids;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        auto iter = previous.sections.find(keys[i].first);
+        if (keys[i].first == 0 || iter == previous.sections.end()) continue;
+        reused[i] = iter->second;
+        keys[i].second = iter->second.num_variables;
+        collect_variable_ids(iter->second, used_ids);
+        previous.sections.erase(iter);
     }
+    previous.sections.clear();
+    VariableIdAllocator ids(std::move(used_ids));
+
+    // the variable table comes after the modules. it is spilled to an anonymous temporary file,
+    // which is gone once closed, and copied over at the end so that only one batch is held in
+    // memory
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> variables_file(std::tmpfile(), &std::fclose);
+    if (!variables_file) throw InternalException("Unable to create a temporary file");
+    auto write_variable = [&](std::string_view var) {
+        std::fwrite(var.data(), 1, var.size(), variables_file.get());
+        std::fputc('\n', variables_file.get());
+    };
+    uint64_t num_variables = 0;
+
+    const uint64_t batch_size = num_cpus * 4;
+    for (uint64_t start = 0; start < generators_.size(); start += batch_size) {
+        auto end = std::min<uint64_t>(start + batch_size, generators_.size());
+        std::vector<DatabaseSection> sections(end - start);
+
+        // compute breakpoint conditions. this creates new expressions so it has to be done
+        // sequentially
+        std::vector<std::unordered_map<const Stmt *, std::string>> conditions(end - start);
+        for (auto i = start; i < end; i++) {
+            auto *gen = generators_[i];
+            if (!reused[i] && scope_gens.find(gen) != scope_gens.end())
+                conditions[i - start] = compute_generator_enable_condition(gen);
+        }
+        std::vector<PendingModule> pending(end - start);
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(end - start);
+        for (auto i = start; i < end; i++) {
+            if (reused[i]) continue;
+            auto t = pool.push(
+                [&](uint64_t index) {
+                    build_module(generators_[start + index], conditions[index], pending[index]);
+                },
+                i - start);
+            tasks.emplace_back(std::move(t));
+        }
+        for (auto &t : tasks) t.get();
+
+        tasks.clear();
+        for (uint64_t i = 0; i < pending.size(); i++) {
+            if (reused[start + i]) continue;
+            auto t = pool.push(
+                [&](uint64_t index) { serialize_module(pending[index], sections[index]); }, i);
+            tasks.emplace_back(std::move(t));
+        }
+        for (auto &t : tasks) t.get();
+
+        // ids are handed out in generator order
+        std::vector<std::vector<uint64_t>> variable_ids(end - start);
+        for (uint64_t i = 0; i < pending.size(); i++) {
+            if (reused[start + i]) continue;
+            auto const &variables = pending[i].shared_variables;
+            variable_ids[i].reserve(variables.size());
+            for (uint64_t j = 0; j < variables.size(); j++) variable_ids[i].emplace_back(ids.next());
+            keys[start + i].second = variables.size();
+        }
+        tasks.clear();
+        for (uint64_t i = 0; i < pending.size(); i++) {
+            if (reused[start + i]) continue;
+            auto t = pool.push(
+                [&](uint64_t index) {
+                    auto &section = sections[index];
+                    section.variables = assign_variable_ids(
+                        section.module, pending[index].shared_variables, variable_ids[index]);
+                },
+                i);
+            tasks.emplace_back(std::move(t));
+        }
+        for (auto &t : tasks) t.get();
+
+        for (uint64_t i = 0; i < sections.size(); i++) {
+            if (start + i > 0) stream << ',';
+            if (auto const &section = reused[start + i]) {
+                stream << section->module << '\n';
+                if (section->num_variables == 0) continue;
+                if (num_variables > 0) std::fputc(',', variables_file.get());
+                write_variable(section->variables);
+                num_variables += section->num_variables;
+                continue;
+            }
+            auto const &section = sections[i];
+            stream << section.module << '\n';
+            for (auto const &var : section.variables) {
+                if (num_variables++ > 0) std::fputc(',', variables_file.get());
+                write_variable(var);
+            }
+        }
+    }
+    stream << table_end << '\n';
 
-    // compress the table
-    table.compress();
+    std::rewind(variables_file.get());
+    std::array<char, 1 << 16> buffer{};
+    uint64_t size;
+    while ((size = std::fread(buffer.data(), 1, buffer.size(), variables_file.get())) > 0) {
+        stream.write(buffer.data(), static_cast<std::streamsize>(size));
+    }
+    variables_file.reset();
+    reused.clear();
+    previous.file.reset();
 
     // setting attributes
-    table.disable_reorder();
-
-    std::ofstream stream;
-    stream.open(filename);
-    stream << table.output();
+    stream << database_end << std::endl;
+    uint64_t database_size = stream.tellp();
     stream.close();
+
+    std::ofstream index(index_filename(filename));
+    index << index_header << database_size << '\n';
+    for (auto const &[key, count] : keys) index << ::format("{0:016x} {1}\n", key, count);
 }
 
 // TODO: implement transformer visitor
@@ -668,16 +1186,20 @@ private:
             // look into its scope variables
             auto const &scope = stmt->scope_context();
             std::map<std::string, std::pair<bool, std::string>> new_scope;
+            bool changed = false;
             for (auto const &[name, var_map] : scope) {
                 auto const &[is_var, var_name] = var_map;
                 if (is_var && symbol_mapping.find(name) != symbol_mapping.end()) {
-                    new_scope.emplace(name, std::make_pair(true, symbol_mapping.at(name)));
+                    auto const &mapped_name = symbol_mapping.at(name);
+                    changed = changed || mapped_name != var_name;
+                    new_scope.emplace(name, std::make_pair(true, mapped_name));
                 } else {
                     // just put it in the new scope
                     new_scope.emplace(name, var_map);
                 }
             }
-            stmt->set_scope_context(new_scope);
+            // keep sharing the frame if nothing is renamed
+            if (changed) stmt->set_scope_context(new_scope);
 
             // just update the table name
             // update symbol after the scope since the left side hasn't showed up in scope yet
@@ -743,14 +1265,16 @@ public:
 private:
     void inline add_info(Stmt *stmt) {
         if (!stmt->fn_name_ln.empty() && stmt->verilog_ln != 0) {
-            result_.emplace(stmt->verilog_ln, stmt->fn_name_ln);
+            result_.emplace(stmt->verilog_ln,
+                            std::vector<std::pair<std::string, uint32_t>>(stmt->fn_name_ln));
         }
     }
 
     void inline add_info(Var *var) {
         if (!var->fn_name_ln.empty() && var->verilog_ln != 0 &&
             result_.find(var->verilog_ln) == result_.end()) {
-            result_.emplace(var->verilog_ln, var->fn_name_ln);
+            result_.emplace(var->verilog_ln,
+                            std::vector<std::pair<std::string, uint32_t>>(var->fn_name_ln));
         }
     }
 
@@ -763,7 +1287,8 @@ public:
         if (result_.find(generator->name) != result_.end()) return;
         if (!generator->fn_name_ln.empty()) {
             DebugInfoVisitor visitor;
-            visitor.result().emplace(1, generator->fn_name_ln);
+            visitor.result().emplace(
+                1, std::vector<std::pair<std::string, uint32_t>>(generator->fn_name_ln));
             visitor.visit_content(generator);
             result_.emplace(generator->name, visitor.result());
         }
@@ -38,7 +38,8 @@ private:
     std::map<const Stmt *, std::pair<std::string, uint32_t>> stmt_mapping_;
     std::unordered_map<const Generator *, std::map<std::string, std::string>> variable_mapping_;
     std::map<const Stmt *, std::map<std::string, std::pair<bool, std::string>>> stmt_context_;
-    std::unordered_set<Generator *> generators_;
+    // sorted so that the output is deterministic
+    std::vector<Generator *> generators_;
 
     Generator *top_ = nullptr;
 
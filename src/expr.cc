@@ -203,9 +203,13 @@ VarSlice &Var::operator[](std::pair<uint32_t, uint32_t> slice) {
     // if there is one already
     for (auto const &s : slices_) {
         if (!s->sliced_by_var()) {
-            if (high == s->high && low == s->low) return *s;
+            if (high == s->high && low == s->low) {
+                KRATOS_IR_COUNT(generator()->context(), SliceCacheHits);
+                return *s;
+            }
         }
     }
+    KRATOS_IR_COUNT(generator()->context(), SliceCacheMisses);
     // create a new one
     // notice that slice is not part of generator's variables. It's handled by the parent (var)
     // itself
@@ -236,9 +240,13 @@ VarSlice &Var::operator[](const std::shared_ptr<Var> &var) {
     for (auto const &s : slices_) {
         if (s->sliced_by_var()) {
             auto const s_ = s->as<VarVarSlice>();
-            if (s_->sliced_var() == var.get()) return *s_;
+            if (s_->sliced_var() == var.get()) {
+                KRATOS_IR_COUNT(generator()->context(), SliceCacheHits);
+                return *s_;
+            }
         }
     }
+    KRATOS_IR_COUNT(generator()->context(), SliceCacheMisses);
     auto var_slice = ::make_shared<VarVarSlice>(this, var.get());
     slices_.emplace_back(var_slice);
     if (width_param_) {
@@ -1613,6 +1621,7 @@ void stmt_set_left(AssignStmt *stmt, Var *target, Var *new_var) {
 }
 
 void Var::move_src_to(Var *var, Var *new_var, Generator *parent, bool keep_connection) {
+    KRATOS_IR_COUNT(parent->context(), SrcMoves);
     // only base and port vars are allowed
     if (var->type_ == VarType::Expression || var->type_ == VarType::ConstValue)
         throw VarException("Only base or port variables are allowed.", {var, new_var});
@@ -1644,6 +1653,7 @@ void Var::move_src_to(Var *var, Var *new_var, Generator *parent, bool keep_conne
 }
 
 void Var::move_sink_to(Var *var, Var *new_var, Generator *parent, bool keep_connection) {
+    KRATOS_IR_COUNT(parent->context(), SinkMoves);
     // only base and port vars are allowed
     if (var->type_ == VarType::Expression || var->type_ == VarType::ConstValue)
         throw VarException("Only base or port variables are allowed.", {var, new_var});
@@ -1,13 +1,20 @@
 #include "fault.hh"
 
+#include <charconv>
 #include <chrono>
 #include <fstream>
 #include <stack>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "eval.hh"
+#include "cxxpool.h"
 #include "except.hh"
 #include "fmt/format.h"
 #include "graph.hh"
+#include "pass.hh"
 #include "stmt.hh"
 #include "util.hh"
 
@@ -15,10 +22,31 @@ using fmt::format;
 
 namespace kratos {
 
+namespace {
+// index of the lowest set bit. word can't be 0
+uint64_t lowest_bit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+#ifdef _WIN64
+    _BitScanForward64(&index, word);
+#else
+    // 32-bit targets only have the 32-bit scan
+    if (!_BitScanForward(&index, static_cast<unsigned long>(word))) {
+        _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+        index += 32;
+    }
+#endif
+    return index;
+#else
+    return static_cast<uint64_t>(__builtin_ctzll(word));
+#endif
+}
+}  // namespace
+
 void SimulationRun::add_simulation_state(const std::map<std::string, int64_t> &values) {
     // need to parse the inputs and outputs
-    states_.emplace_back(std::make_unique<Simulator>(top_));
-    auto *state = get_state(states_.size() - 1);
+    std::vector<std::pair<uint32_t, int64_t>> state;
+    state.reserve(values.size());
     for (auto const &[name, value] : values) {
         // we need to use dot notation to select from the hierarchy
         // notice these names do not contain the "top" name, e.g. TOP for verilator
@@ -26,8 +54,44 @@ void SimulationRun::add_simulation_state(const std::map<std::string, int64_t> &v
         if (!var) {
             throw UserException(::format("Unable to parse {0}", name));
         }
-        state->set(var, value, false);
+        state.emplace_back(get_var_index(var), value);
+    }
+    states_.emplace_back(std::move(state));
+}
+
+void SimulationRun::set_signal_names(const std::vector<std::string> &names) {
+    // the previous names stay in place if any of the new ones can't be resolved
+    std::vector<uint32_t> indices;
+    indices.reserve(names.size());
+    for (auto const &name : names) {
+        auto *var = select(name);
+        if (!var) {
+            throw UserException(::format("Unable to parse {0}", name));
+        }
+        indices.emplace_back(get_var_index(var));
+    }
+    signal_indices_.swap(indices);
+}
+
+void SimulationRun::add_simulation_state(const std::vector<int64_t> &values) {
+    if (values.size() != signal_indices_.size())
+        throw UserException(::format("Expect {0} values, got {1}", signal_indices_.size(),
+                                     values.size()));
+    std::vector<std::pair<uint32_t, int64_t>> state;
+    state.reserve(values.size());
+    for (uint64_t i = 0; i < values.size(); i++) {
+        state.emplace_back(signal_indices_[i], values[i]);
     }
+    states_.emplace_back(std::move(state));
+}
+
+uint32_t SimulationRun::get_var_index(Var *var) {
+    auto iter = var_index_.find(var);
+    if (iter != var_index_.end()) return iter->second;
+    auto index = static_cast<uint32_t>(vars_.size());
+    vars_.emplace_back(var);
+    var_index_.emplace(var, index);
+    return index;
 }
 
 void SimulationRun::mark_wrong_value(const std::string &name) {
@@ -48,18 +112,36 @@ void SimulationRun::add_simulation_coverage(const std::unordered_map<Stmt *, uin
 std::pair<Generator *, uint64_t> SimulationRun::select_gen(const std::vector<std::string> &tokens) {
     Generator *gen = top_;
     if (tokens[0] != gen->instance_name) return {nullptr, 1};
+    // cache is keyed by the dotted path
+    std::string path = tokens[0];
     for (uint64_t index = 1; index < tokens.size(); index++) {
         auto const &name = tokens[index];
+        path.append(".").append(name);
+        auto iter = gen_cache_.find(path);
+        if (iter != gen_cache_.end()) {
+            gen = iter->second;
+            continue;
+        }
         if (!gen->has_child_generator(name)) {
             return {gen, index};
         } else {
             gen = gen->get_child_generator(name);
+            gen_cache_.emplace(path, gen);
         }
     }
     return {gen, tokens.size()};
 }
 
 Var *SimulationRun::select(const std::string &name) {
+    auto iter = var_cache_.find(name);
+    if (iter != var_cache_.end()) return iter->second;
+    auto *var = select_var(name);
+    // only cache the successful ones since errors are reported to the user anyway
+    if (var) var_cache_.emplace(name, var);
+    return var;
+}
+
+Var *SimulationRun::select_var(const std::string &name) {
     auto tokens = string::get_tokens(name, ".");
     auto [gen, index] = select_gen(tokens);
     if (index >= tokens.size()) return nullptr;
@@ -90,10 +172,18 @@ Var *SimulationRun::select(const std::string &name) {
 }
 
 Simulator *SimulationRun::get_state(uint32_t index) {
-    if (index < states_.size()) {
-        return states_[index].get();
+    if (index >= states_.size()) return nullptr;
+    if (!simulator_) simulator_ = std::make_unique<Simulator>(top_);
+    load_state(index, simulator_.get());
+    return simulator_.get();
+}
+
+void SimulationRun::load_state(uint32_t index, Simulator *simulator) const {
+    if (index >= states_.size()) throw UserException(::format("Invalid state index {0}", index));
+    simulator->reset();
+    for (auto const &[var_index, value] : states_[index]) {
+        simulator->set(vars_[var_index], value, false);
     }
-    return nullptr;
 }
 
 FaultAnalyzer::FaultAnalyzer(kratos::Generator *generator) : generator_(generator) {}
@@ -109,92 +199,191 @@ T *cast(Stmt *stmt) {
     return r;
 }
 
-void compute_hit_stmts(Simulator *state, std::unordered_set<Stmt *> &result, Stmt *stmt) {
+void compute_hit_stmts(Simulator *state, const std::unordered_map<Stmt *, uint32_t> &stmt_index,
+                       std::vector<uint64_t> &result, Stmt *stmt) {
     if (stmt->type() == StatementType::If) {
         auto *if_ = cast<IfStmt>(stmt);
         auto cond = if_->predicate();
         auto val = state->get(cond.get());
         if (val && *val) {
-            compute_hit_stmts(state, result, if_->then_body().get());
+            compute_hit_stmts(state, stmt_index, result, if_->then_body().get());
         } else {
-            compute_hit_stmts(state, result, if_->else_body().get());
+            compute_hit_stmts(state, stmt_index, result, if_->else_body().get());
         }
     } else if (stmt->type() == StatementType::Block) {
         auto *block = cast<StmtBlock>(stmt);
         // normal sequential block and combinational block always gets executed
         // as a result, we're only interested in the conditional statement block, i.e. scoped block
-        if (block->block_type() == StatementBlockType::Scope) result.emplace(stmt);
+        if (block->block_type() == StatementBlockType::Scope) {
+            auto index = stmt_index.at(stmt);
+            result[index / 64] |= 1ull << (index % 64);
+        }
         for (auto const &s : *block) {
-            compute_hit_stmts(state, result, s.get());
+            compute_hit_stmts(state, stmt_index, result, s.get());
         }
     } else if (stmt->type() == StatementType::FunctionalCall) {
         auto *func = cast<FunctionCallStmt>(stmt);
         if (func->var()->func()->is_dpi() || func->var()->func()->is_builtin()) {
             // nothing
         } else {
-            compute_hit_stmts(state, result, func->var()->func());
+            compute_hit_stmts(state, stmt_index, result, func->var()->func());
+        }
+    }
+}
+
+// number every statement compute_hit_stmts can possibly reach
+void collect_hit_stmts(std::unordered_set<Stmt *> &visited, std::vector<Stmt *> &result,
+                       Stmt *stmt) {
+    if (stmt->type() == StatementType::If) {
+        auto *if_ = cast<IfStmt>(stmt);
+        collect_hit_stmts(visited, result, if_->then_body().get());
+        collect_hit_stmts(visited, result, if_->else_body().get());
+    } else if (stmt->type() == StatementType::Block) {
+        // functions can be called multiple times
+        if (visited.find(stmt) != visited.end()) return;
+        visited.emplace(stmt);
+        auto *block = cast<StmtBlock>(stmt);
+        if (block->block_type() == StatementBlockType::Scope) result.emplace_back(stmt);
+        for (auto const &s : *block) {
+            collect_hit_stmts(visited, result, s.get());
+        }
+    } else if (stmt->type() == StatementType::FunctionalCall) {
+        auto *func = cast<FunctionCallStmt>(stmt);
+        if (!func->var()->func()->is_dpi() && !func->var()->func()->is_builtin()) {
+            collect_hit_stmts(visited, result, func->var()->func());
+        }
+    }
+}
+
+void FaultAnalyzer::index_stmts() {
+    if (stmts_indexed_) return;
+    // make sure the simulators created later on don't change the IR while we are running in
+    // parallel
+    fix_assignment_type(generator_);
+    GeneratorGraph g(generator_);
+    auto generators = g.get_sorted_nodes();
+    std::unordered_set<Stmt *> visited;
+    std::vector<Stmt *> stmts;
+    for (auto const &gen : generators) {
+        auto gen_stmts = gen->get_all_stmts();
+        for (auto const &stmt : gen_stmts) {
+            root_stmts_.emplace_back(stmt.get());
+            collect_hit_stmts(visited, stmts, stmt.get());
+        }
+    }
+    for (auto *stmt : stmts) get_stmt_index(stmt);
+    stmts_indexed_ = true;
+}
+
+uint32_t FaultAnalyzer::get_stmt_index(Stmt *stmt) {
+    auto iter = stmt_index_.find(stmt);
+    if (iter != stmt_index_.end()) return iter->second;
+    auto index = static_cast<uint32_t>(stmts_.size());
+    stmts_.emplace_back(stmt);
+    stmt_index_.emplace(stmt, index);
+    return index;
+}
+
+FaultAnalyzer::StmtBits FaultAnalyzer::compute_coverage_bits(SimulationRun *run,
+                                                              Simulator *simulator) const {
+    StmtBits result((stmts_.size() + 63) / 64, 0);
+    auto num_states = run->num_states();
+    for (uint64_t i = 0; i < num_states; i++) {
+        run->load_state(i, simulator);
+        // given the state, we need to go through each generators
+        for (auto *stmt : root_stmts_) {
+            compute_hit_stmts(simulator, stmt_index_, result, stmt);
+        }
+    }
+    return result;
+}
+
+std::unordered_set<Stmt *> FaultAnalyzer::get_stmts(const StmtBits &bits) const {
+    std::unordered_set<Stmt *> result;
+    for (uint64_t i = 0; i < bits.size(); i++) {
+        auto word = bits[i];
+        while (word) {
+            auto bit = lowest_bit(word);
+            result.emplace(stmts_[i * 64 + bit]);
+            word &= word - 1;
         }
     }
+    return result;
 }
 
 std::unordered_set<Stmt *> FaultAnalyzer::compute_coverage(uint32_t index) {
+    index_stmts();
     auto *run = runs_[index].get();
-    std::unordered_set<Stmt *> result;
+    StmtBits result;
     if (run->has_coverage()) {
         auto const &cov = run->coverage();
-        for (auto const &stmt : cov) result.emplace(stmt);
-    } else {
-        auto num_states = run->num_states();
-        for (uint64_t i = 0; i < num_states; i++) {
-            auto *state = run->get_state(i);
-            // given the state, we need to go through each generators
-            GeneratorGraph g(generator_);
-            auto generators = g.get_sorted_nodes();
-            for (auto const &gen : generators) {
-                // need to calculate the sequential or combination block
-                auto stmts = gen->get_all_stmts();
-                for (auto const &stmt : stmts) {
-                    compute_hit_stmts(state, result, stmt.get());
-                }
-            }
+        for (auto const &stmt : cov) get_stmt_index(stmt);
+        result.resize((stmts_.size() + 63) / 64, 0);
+        for (auto const &stmt : cov) {
+            auto i = stmt_index_.at(stmt);
+            result[i / 64] |= 1ull << (i % 64);
         }
+    } else {
+        Simulator simulator(generator_);
+        result = compute_coverage_bits(run, &simulator);
     }
-    coverage_maps_.emplace(index, result);
-    return result;
+    coverage_maps_[index] = result;
+    return get_stmts(result);
 }
 
 std::unordered_set<Stmt *> FaultAnalyzer::compute_fault_stmts_from_coverage() {
-    // compute coverage for each run
+    index_stmts();
+    // compute coverage for each run. runs with coverage data are cheap, and may introduce new
+    // statements, so we do them first
     auto const num_runs_ = num_runs();
-    for (uint64_t i = 0; i < num_runs_; i++) {
-        if (coverage_maps_.find(i) == coverage_maps_.end()) {
+    std::vector<uint32_t> state_runs;
+    for (uint32_t i = 0; i < num_runs_; i++) {
+        if (coverage_maps_.find(i) != coverage_maps_.end()) continue;
+        if (runs_[i]->has_coverage()) {
             compute_coverage(i);
+        } else {
+            state_runs.emplace_back(i);
         }
     }
-    std::map<Stmt *, uint32_t> correct_stmt_count;
-    std::map<Stmt *, uint32_t> wrong_stmt_count;
-    for (auto const &[run_index, coverage] : coverage_maps_) {
-        auto const &run = runs_[run_index];
-        bool has_wrong_value = run->has_wrong_value();
-        for (auto const &stmt : coverage) {
-            if (has_wrong_value) {
-                if (wrong_stmt_count.find(stmt) == wrong_stmt_count.end())
-                    wrong_stmt_count[stmt] = 0;
-                wrong_stmt_count[stmt] += 1;
-            } else {
-                if (correct_stmt_count.find(stmt) == correct_stmt_count.end())
-                    correct_stmt_count[stmt] = 0;
-                correct_stmt_count[stmt] += 1;
-            }
+
+    if (!state_runs.empty()) {
+        // runs are computed in parallel. each chunk gets its own simulator since loading states
+        // changes its values
+        Simulator simulator(generator_);
+        uint64_t num_cpus = std::min<uint64_t>(get_num_cpus(), state_runs.size());
+        uint64_t chunk_size = (state_runs.size() + num_cpus - 1) / num_cpus;
+        std::vector<StmtBits> results(state_runs.size());
+        cxxpool::thread_pool pool{num_cpus};
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(num_cpus);
+        for (uint64_t start = 0; start < state_runs.size(); start += chunk_size) {
+            auto end = std::min<uint64_t>(start + chunk_size, state_runs.size());
+            auto t = pool.push(
+                [&, start, end](Simulator sim) {
+                    for (auto i = start; i < end; i++) {
+                        results[i] = compute_coverage_bits(runs_[state_runs[i]].get(), &sim);
+                    }
+                },
+                simulator);
+            tasks.emplace_back(std::move(t));
+        }
+        for (auto &t : tasks) t.get();
+        for (uint64_t i = 0; i < state_runs.size(); i++) {
+            coverage_maps_[state_runs[i]] = std::move(results[i]);
         }
     }
-    std::unordered_set<Stmt *> result;
-    // compute the sum
-    for (auto const &iter : wrong_stmt_count) {
-        auto const &stmt = iter.first;
-        if (correct_stmt_count.find(stmt) == correct_stmt_count.end()) result.emplace(stmt);
+
+    // a statement is suspicious if it is only covered by the wrong runs
+    auto const num_words = (stmts_.size() + 63) / 64;
+    StmtBits wrong_stmts(num_words, 0);
+    StmtBits correct_stmts(num_words, 0);
+    for (auto const &[run_index, coverage] : coverage_maps_) {
+        auto &target = runs_[run_index]->has_wrong_value() ? wrong_stmts : correct_stmts;
+        // older coverage may have fewer words since statements are numbered incrementally
+        for (uint64_t i = 0; i < coverage.size(); i++) target[i] |= coverage[i];
     }
-    return result;
+    for (uint64_t i = 0; i < num_words; i++) wrong_stmts[i] &= ~correct_stmts[i];
+    return get_stmts(wrong_stmts);
 }
 
 class XMLWriter {
@@ -395,7 +584,7 @@ void FaultAnalyzer::output_coverage_xml(std::ostream &stream) {
     // compute the collapsed map
     std::unordered_map<IRNode *, uint32_t> branch_cover_count;
     for (auto const &iter : coverage_maps_) {
-        auto const &coverage = iter.second;
+        auto const coverage = get_stmts(iter.second);
         for (auto const &stmt : coverage) {
             if (branch_cover_count.find(stmt) == branch_cover_count.end())
                 branch_cover_count[stmt] = 0;
@@ -506,201 +695,300 @@ void FaultAnalyzer::output_coverage_xml(std::ostream &stream) {
     w.close_all();
 }
 
+// (file basename, line number) -> stmt
+using StmtLineIndex = std::unordered_map<std::string, std::unordered_map<uint32_t, Stmt *>>;
+
 class CollectScopeStmtVisitor : public IRVisitor {
 public:
     void visit(ScopedStmtBlock *stmt) override { add_stmt(stmt); }
 
-    [[nodiscard]] const std::map<std::pair<std::string, uint32_t>, Stmt *> &stmt_map() const {
-        return stmt_map_;
-    }
+    [[nodiscard]] const StmtLineIndex &stmt_map() const { return stmt_map_; }
 
 private:
     void add_stmt(Stmt *stmt) {
         auto *gen = stmt->generator_parent();
         if (!gen->verilog_fn.empty()) {
             auto filename = fs::basename(gen->verilog_fn);
-            stmt_map_.emplace(std::make_pair(filename, stmt->verilog_ln), stmt);
+            stmt_map_[filename].emplace(stmt->verilog_ln, stmt);
+        }
+    }
+
+    StmtLineIndex stmt_map_;
+};
+
+std::string_view basename_view(std::string_view filename) {
+    auto pos = filename.find_last_of("/\\");
+    if (pos == std::string_view::npos) return filename;
+    return filename.substr(pos + 1);
+}
+
+std::string_view trim_view(std::string_view str) {
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front())))
+        str.remove_prefix(1);
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back())))
+        str.remove_suffix(1);
+    return str;
+}
+
+template <typename T>
+bool parse_number(std::string_view str, T &value) {
+    str = trim_view(str);
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+// resolves (filename, line) hits from a single chunk. coverage files list entries grouped by
+// file, so the last file lookup is cached
+class StmtHitCollector {
+public:
+    explicit StmtHitCollector(const StmtLineIndex &index) : index_(index) {}
+
+    void add(std::string_view filename, uint32_t ln, uint64_t count) {
+        if (count == 0) return;
+        filename = basename_view(filename);
+        if (!has_filename_ || filename != filename_) {
+            filename_ = filename;
+            has_filename_ = true;
+            auto iter = index_.find(std::string(filename));
+            file_map_ = iter != index_.end() ? &iter->second : nullptr;
+        }
+        if (!file_map_) return;
+        auto iter = file_map_->find(ln);
+        if (iter == file_map_->end()) return;
+        add(iter->second, static_cast<uint32_t>(count));
+    }
+
+    // if the same line shows up multiple times, the smallest non-zero count is used
+    void add(Stmt *stmt, uint32_t count) {
+        auto iter = hits_.find(stmt);
+        if (iter == hits_.end()) {
+            hits_.emplace(stmt, count);
+        } else if (count < iter->second) {
+            iter->second = count;
         }
     }
 
-    std::map<std::pair<std::string, uint32_t>, Stmt *> stmt_map_;
+    [[nodiscard]] const std::unordered_map<Stmt *, uint32_t> &hits() const { return hits_; }
+
+private:
+    const StmtLineIndex &index_;
+    std::string_view filename_;
+    bool has_filename_ = false;
+    const std::unordered_map<uint32_t, Stmt *> *file_map_ = nullptr;
+    std::unordered_map<Stmt *, uint32_t> hits_;
 };
 
-std::unordered_map<Stmt *, uint32_t> reverse_map_stmt(
-    Generator *top, const std::set<std::tuple<std::string, uint32_t, uint32_t>> &hit_counts) {
+template <typename F>
+void for_each_line(std::string_view content, F &&fn) {
+    uint64_t pos = 0;
+    while (pos < content.size()) {
+        auto end = content.find('\n', pos);
+        if (end == std::string_view::npos) end = content.size();
+        auto line = content.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        fn(line);
+        pos = end + 1;
+    }
+}
+
+// split the content at line boundaries. if a tag is provided, chunks only start at lines
+// containing the tag
+std::vector<std::string_view> split_lines(std::string_view content, uint64_t num_chunks,
+                                          std::string_view tag = {}) {
+    std::vector<std::string_view> chunks;
+    uint64_t chunk_size = content.size() / std::max<uint64_t>(num_chunks, 1) + 1;
+    uint64_t start = 0;
+    while (start < content.size()) {
+        uint64_t end = std::min<uint64_t>(start + chunk_size, content.size());
+        if (end < content.size()) {
+            if (tag.empty()) {
+                end = content.find('\n', end);
+            } else {
+                // the tag is searched past the first line so that every chunk moves forward
+                auto first_line = content.find('\n', start);
+                end = first_line == std::string_view::npos
+                          ? first_line
+                          : content.find(tag, std::max<uint64_t>(end, first_line + 1));
+                if (end != std::string_view::npos) end = content.rfind('\n', end);
+            }
+            end = end == std::string_view::npos ? content.size() : end + 1;
+        }
+        chunks.emplace_back(content.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+template <typename F>
+std::unordered_map<Stmt *, uint32_t> parse_coverage_chunks(Generator *top,
+                                                           const std::string &filename,
+                                                           std::string_view tag, F &&fn) {
+    if (!fs::exists(filename)) throw UserException(::format("{0} does not exist", filename));
+    fs::MappedFile file(filename);
+
     CollectScopeStmtVisitor visitor;
     visitor.visit_root(top);
-    auto const &map = visitor.stmt_map();
-    std::unordered_map<Stmt *, uint32_t> stmts;
-    for (auto const &[fn, ln, count] : hit_counts) {
-        if (count == 0) continue;
-        auto filename = fs::basename(fn);
-        auto entry = std::make_pair(filename, ln);
-        if (map.find(entry) != map.end()) {
-            stmts.emplace(map.at(entry), count);
+    auto const &index = visitor.stmt_map();
+
+    auto num_cpus = get_num_cpus();
+    auto content = file.content();
+    auto chunks = split_lines(content, num_cpus, tag);
+    std::vector<StmtHitCollector> collectors(chunks.size(), StmtHitCollector(index));
+    if (chunks.size() > 1) {
+        cxxpool::thread_pool pool{num_cpus};
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(chunks.size());
+        for (uint64_t i = 0; i < chunks.size(); i++) {
+            auto t = pool.push([&](uint64_t i) { fn(content, chunks[i], collectors[i]); }, i);
+            tasks.emplace_back(std::move(t));
         }
+        for (auto &t : tasks) t.get();
+    } else if (!chunks.empty()) {
+        fn(content, chunks[0], collectors[0]);
+    }
+
+    // merge the result
+    if (collectors.empty()) return {};
+    StmtHitCollector result(index);
+    for (auto const &collector : collectors) {
+        for (auto const &[stmt, count] : collector.hits()) result.add(stmt, count);
     }
-    return stmts;
+    return result.hits();
+}
+
+void parse_verilator_coverage_line(std::string_view line, StmtHitCollector &collector) {
+    if (line.empty() || line[0] != 'C') return;
+    // parse the line based on key value pair
+    // keys start with \1, and values start with \2. the entry list is ended with a quote
+    std::string_view page, fn, ln;
+    bool has_page = false, has_fn = false, has_ln = false;
+    auto pos = line.find(1);
+    auto end = line.find('\'', pos == std::string_view::npos ? 0 : pos);
+    while (pos != std::string_view::npos && pos < end) {
+        auto key_end = line.find(2, pos + 1);
+        if (key_end == std::string_view::npos || key_end > end)
+            throw InternalException("Failed to parse" + std::string(line));
+        auto value_end = line.find_first_of("\1'", key_end + 1);
+        if (value_end == std::string_view::npos)
+            throw InternalException("Failed to parse" + std::string(line));
+        auto key = line.substr(pos + 1, key_end - pos - 1);
+        auto value = line.substr(key_end + 1, value_end - key_end - 1);
+        if (key == "page") {
+            page = value;
+            has_page = true;
+        } else if (key == "f") {
+            fn = value;
+            has_fn = true;
+        } else if (key == "l") {
+            ln = value;
+            has_ln = true;
+        }
+        pos = line[value_end] == 1 ? value_end : std::string_view::npos;
+    }
+    // parse the page type
+    if (!has_page) throw UserException("Unable to parse " + std::string(line));
+    constexpr std::string_view line_cov_prefix = "v_line";
+    if (page.substr(0, line_cov_prefix.size()) != line_cov_prefix) return;
+    if (end == std::string_view::npos || end >= line.size() - 1)
+        throw UserException("Unable to parse " + std::string(line));
+    // need to parse the count
+    uint64_t count;
+    if (!parse_number(line.substr(end + 1), count))
+        throw UserException("Unable to parse " + std::string(line));
+    // check on the filename and line number
+    uint32_t line_number;
+    if (!has_fn || !has_ln || !parse_number(ln, line_number))
+        throw UserException("Unable to parse" + std::string(line));
+    collector.add(fn, line_number, count);
 }
 
 std::unordered_map<Stmt *, uint32_t> parse_verilator_coverage(Generator *top,
                                                               const std::string &filename) {
-    if (!fs::exists(filename)) throw UserException(::format("{0} does not exist"));
-    std::ifstream file(filename);
-    std::set<std::tuple<std::string, uint32_t, uint32_t>> parse_result;
-    for (std::string line; std::getline(file, line);) {
-        if (line[0] != 'C') continue;
-        // parse the line based on key value pair
-        std::unordered_map<std::string, std::string> data;
-        std::string key;
-        std::string buffer;
-        // a tiny FSM to decode
-        // 0 -> nothing
-        // 1 -> key
-        // 2 -> value
+    auto parse_chunk = [](std::string_view, std::string_view chunk, StmtHitCollector &collector) {
+        for_each_line(chunk,
+                      [&](std::string_view line) { parse_verilator_coverage_line(line, collector); });
+    };
+    return parse_coverage_chunks(top, filename, {}, parse_chunk);
+}
+
+std::vector<std::string_view> get_icc_tokens(std::string_view str) {
+    // tokens are separated by at least two spaces
+    std::vector<std::string_view> result;
+    str = trim_view(str);
+    uint64_t start = 0;
+    while (start < str.size()) {
+        auto pos = str.find("  ", start);
+        if (pos == std::string_view::npos) pos = str.size();
+        auto token = trim_view(str.substr(start, pos - start));
+        if (!token.empty()) result.emplace_back(token);
+        start = pos + 2;
+    }
+    return result;
+}
+
+std::unordered_map<Stmt *, uint32_t> parse_icc_coverage(Generator *top,
+                                                        const std::string &filename) {
+    constexpr std::string_view filename_tag = "File name:";
+    // chunks start at a file section so that each of them can be parsed independently
+    auto parse_chunk = [&](std::string_view content, std::string_view chunk,
+                           StmtHitCollector &collector) {
+        // state 0: nothing
+        // state 1: searching for block header
+        // state 2: reading block coverage
         uint32_t state = 0;
-        uint64_t index;
-        for (index = 2; index < line.size(); index++) {
-            auto c = line[index];
+        std::string_view current_filename;
+        for_each_line(chunk, [&](std::string_view line) {
+            // line number is only computed for error messages
+            auto line_count = [&]() { return std::count(content.data(), line.data(), '\n'); };
+            // scan file by file
+            line = trim_view(line);
+            if (!line.empty() && line[0] == '-') return;  // skip the line section
             if (state == 0) {
-                if (c == 1) {
-                    // this is key
+                auto pos = line.find(filename_tag);
+                if (pos != std::string_view::npos) {
                     state = 1;
+                    // extract out filename
+                    current_filename = trim_view(line.substr(pos + filename_tag.size()));
                 }
             } else if (state == 1) {
-                if (c == 2) {
-                    // key ends here
-                    key = buffer;
-                    buffer = "";
+                constexpr std::string_view count_tag = "Count  Block";
+                if (line.find(count_tag) != std::string_view::npos) {
                     state = 2;
-                } else {
-                    buffer += c;
                 }
             } else {
-                if (c == '\'' || c == 1) {
-                    // end of value
-                    if (key.empty()) throw InternalException("Failed to parse" + line);
-                    data.emplace(key, buffer);
-                    key = "";
-                    buffer = "";
-                    if (c == 1) state = 1;
-                    if (c == '\'') break;
-                } else {
-                    buffer += c;
+                if (line.empty()) {
+                    // reset everything
+                    current_filename = {};
+                    state = 0;
+                    return;
                 }
-            }
-        }
-        // parse the page type
-        if (data.find("page") == data.end()) throw UserException("Unable to parse " + line);
-        auto page_type = data.at("page");
-        const std::string line_cov_prefix = "v_line";
-        if (page_type.substr(0, line_cov_prefix.size()) != line_cov_prefix) continue;
-        if (index >= line.size() - 1) throw UserException("Unable to parse " + line);
-        // need to parse the count
-        std::string count_s = line.substr(index + 1);
-        string::trim(count_s);
-        auto count = static_cast<uint64_t>(std::stol(count_s));
-        // check on the filename and line number
-        if (data.find("f") == data.end() || data.find("l") == data.end())
-            throw UserException("Unable to parse" + line);
-        auto const &fn = data.at("f");
-        auto const ln = static_cast<uint32_t>(std::stoi(data.at("l")));
-        parse_result.emplace(std::make_tuple(fn, ln, count));
-    }
-
-    auto reverse_map = reverse_map_stmt(top, parse_result);
-    return reverse_map;
-}
-
-std::vector<std::string> get_icc_tokens(std::string str) {
-    std::vector<std::string> result;
-    // trim the input and output
-    string::trim(str);
-    std::string buf;
-    for (uint64_t pos = 0; pos < str.size(); pos++) {
-        if (str[pos] == ' ') {
-            if (pos < str.size() - 1) {
-                if (str[pos + 1] == ' ') {
-                    // end of token
-                    string::trim(buf);
-                    if (!buf.empty()) result.emplace_back(buf);
-                    buf = "";
-                    continue;
+                auto tokens = get_icc_tokens(line);
+                if (tokens.size() < 6)
+                    throw UserException(::format("Unable to parse line {0} at file {1}:{2}",
+                                                 line, filename, line_count()));
+                // only takes the blocks if we are interested
+                // since only the control statements determine what to run
+                // we need to see if any of the branch has taken
+                auto kind = tokens[3];
+                if (kind != "true part of" && kind != "false part of" &&
+                    kind != "a case item of") {
+                    // skip since it is just a normal code block
+                    return;
                 }
-            }
-        }
-        buf += str[pos];  // maybe more efficient way to do this?
-    }
 
-    if (!buf.empty()) result.emplace_back(buf);
-    return result;
-}
-
-std::unordered_map<Stmt *, uint32_t> parse_icc_coverage(Generator *top,
-                                                        const std::string &filename) {
-    std::set<std::tuple<std::string, uint32_t, uint32_t>> parse_result;
-    if (!fs::exists(filename)) throw UserException(::format("{0} does not exist"));
-    std::ifstream file(filename);
-    // state 0: nothing
-    // state 1: searching for block header
-    // state 2: reading block coverage
-    uint32_t state = 0;
-    uint32_t line_count = 0;
-    std::string current_filename;
-    for (std::string line; std::getline(file, line); line_count++) {
-        // scan file by file
-        string::trim(line);
-        if (line[0] == '-') continue;  // skip the line section
-        if (state == 0) {
-            const std::string filename_tag = "File name:";
-            auto pos = line.find(filename_tag);
-            if (pos != std::string::npos) {
-                state = 1;
-                // extract out filename
-                current_filename = line.substr(pos + filename_tag.size());
-                string::trim(current_filename);
-            }
-        } else if (state == 1) {
-            const std::string count_tag = "Count  Block";
-            auto pos = line.find(count_tag);
-            if (pos != std::string::npos) {
-                state = 2;
-            }
-        } else {
-            if (line.empty()) {
-                // reset everything
-                current_filename = "";
-                state = 0;
-                continue;
+                uint32_t count, ln;
+                if (!parse_number(tokens[0], count) || !parse_number(tokens[2], ln))
+                    throw UserException(::format("Unable to parse line {0} at file {1}:{2}",
+                                                 line, filename, line_count()));
+                if (current_filename.empty())
+                    throw UserException(
+                        ::format("Filename is empty, Unable to parse line {0} at file {1}:{2}",
+                                 line, filename, line_count()));
+                collector.add(current_filename, ln, count);
             }
-            auto tokens = get_icc_tokens(line);
-            if (tokens.size() < 6)
-                throw UserException(::format("Unable to parse line {0} at file {1}:{2}", line,
-                                             filename, line_count));
-            auto count_s = tokens[0];
-            auto line_num = tokens[2];
-            // only takes the blocks if we are interested
-            // since only the control statements determine what to run
-            // we need to see if any of the branch has taken
-            auto kind = tokens[3];
-            const static std::unordered_set<std::string> allowed_branch_kind = {
-                "true part of", "false part of", "a case item of"};
-            if (allowed_branch_kind.find(kind) == allowed_branch_kind.end()) {
-                // skip since it is just a normal code block
-                continue;
-            }
-
-            auto count = static_cast<uint32_t>(std::stoi(count_s));
-            auto fn = static_cast<uint32_t>(std::stoi(line_num));
-            if (current_filename.empty())
-                throw UserException(
-                    ::format("Filename is empty, Unable to parse line {0} at file {1}:{2}", line,
-                             filename, line_count));
-            parse_result.emplace(std::make_tuple(current_filename, fn, count));
-        }
-    }
-    auto reverse_map = reverse_map_stmt(top, parse_result);
-    return reverse_map;
+        });
+    };
+    return parse_coverage_chunks(top, filename, filename_tag, parse_chunk);
 }
 
 }  // namespace kratos
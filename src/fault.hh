@@ -15,21 +15,42 @@ public:
     explicit SimulationRun(Generator *top) : top_(top) {}
 
     void add_simulation_state(const std::map<std::string, int64_t> &values);
+    // bulk interface: resolve the signal names once, then add states as values indexed by the
+    // position of the names
+    void set_signal_names(const std::vector<std::string> &names);
+    void add_simulation_state(const std::vector<int64_t> &values);
     void mark_wrong_value(const std::string &name);
     [[nodiscard]] bool has_wrong_value() const { return !wrong_value_.empty(); }
     void add_simulation_coverage(const std::unordered_map<Stmt *, uint32_t> &coverage);
     [[nodiscard]] bool has_coverage() const { return !coverage_.empty(); }
     [[nodiscard]] const std::unordered_set<Stmt *> &coverage() const { return coverage_; }
-    // use simulator's logic to handle different states
-    // FIXME: refactor out the state and the simulator
+    // use simulator's logic to handle different states. states are stored as compact value
+    // records and loaded into a single simulator on demand, so the returned pointer is only
+    // valid until the next get_state() call
     Simulator *get_state(uint32_t index);
+    // load the state into a simulator created from the same top
+    void load_state(uint32_t index, Simulator *simulator) const;
     [[nodiscard]] uint64_t num_states() const { return states_.size(); }
+    [[nodiscard]] Generator *top() const { return top_; }
 
 private:
     std::pair<Generator *, uint64_t> select_gen(const std::vector<std::string> &tokens);
     Var *select(const std::string &name);
+    Var *select_var(const std::string &name);
+    uint32_t get_var_index(Var *var);
 
-    std::vector<std::unique_ptr<Simulator>> states_;
+    // hierarchical name resolution cache
+    std::unordered_map<std::string, Var *> var_cache_;
+    std::unordered_map<std::string, Generator *> gen_cache_;
+    // var indices set by set_signal_names
+    std::vector<uint32_t> signal_indices_;
+
+    // each state is a list of (var index, value) into vars_
+    std::vector<std::vector<std::pair<uint32_t, int64_t>>> states_;
+    std::vector<Var *> vars_;
+    std::unordered_map<Var *, uint32_t> var_index_;
+    // shared by all the states, which holds the dependency table
+    std::unique_ptr<Simulator> simulator_;
     Generator *top_;
     std::map<uint32_t, std::unordered_set<Var *>> wrong_value_;
 
@@ -48,9 +69,23 @@ public:
     void output_coverage_xml(std::ostream &stream);
 
 private:
+    // coverage is stored as a bitset over densely numbered statements
+    using StmtBits = std::vector<uint64_t>;
+
+    void index_stmts();
+    uint32_t get_stmt_index(Stmt *stmt);
+    StmtBits compute_coverage_bits(SimulationRun *run, Simulator *simulator) const;
+    std::unordered_set<Stmt *> get_stmts(const StmtBits &bits) const;
+
     Generator *generator_;
     std::vector<std::shared_ptr<SimulationRun>> runs_;
-    std::unordered_map<uint32_t, std::unordered_set<Stmt *>> coverage_maps_;
+    std::unordered_map<uint32_t, StmtBits> coverage_maps_;
+
+    // statement numbering, computed once per analyzer
+    bool stmts_indexed_ = false;
+    std::vector<Stmt *> stmts_;
+    std::unordered_map<Stmt *, uint32_t> stmt_index_;
+    std::vector<Stmt *> root_stmts_;
 };
 
 }  // namespace kratos
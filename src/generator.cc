@@ -1,5 +1,6 @@
 #include "generator.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <streambuf>
@@ -32,17 +33,8 @@ Generator &Generator::from_verilog(Context *context, const std::string &src_file
     mod.lib_files_.reserve(1 + lib_files.size());
     mod.lib_files_.emplace_back(src_file);
 
-    std::ifstream f(src_file);
-    ::string src;
-    // pre-allocate the size
-    f.seekg(0, std::ios::end);
-    src.reserve(f.tellg());
-    f.seekg(0, std::ios::beg);
-    src.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
-
     mod.lib_files_.insert(mod.lib_files_.end(), lib_files.begin(), lib_files.end());
-    // const auto &ports = ;
-    const auto ports = get_port_from_verilog(&mod, src, top_name);
+    const auto ports = get_port_from_verilog_file(&mod, src_file, top_name);
     for (auto const &[port_name, port] : ports) {
         mod.ports_.emplace(port_name);
         mod.vars_.emplace(port_name, port);
@@ -206,6 +198,7 @@ std::shared_ptr<Port> Generator::get_port(const std::string &port_name) const {
 }
 
 Expr &Generator::expr(ExprOp op, Var *left, Var *right) {
+    KRATOS_IR_COUNT(context_, ExprsCreated);
     auto expr = std::make_shared<Expr>(op, left, right);
     exprs_.emplace(expr);
     return *expr;
@@ -403,6 +396,7 @@ IRNode *Generator::get_child(uint64_t index) {
 
 void Generator::add_child_generator(const std::string &instance_name_,
                                     const std::shared_ptr<Generator> &child) {
+    materialize_on_write();
     child->instance_name = instance_name_;
     if (children_.find(child->instance_name) == children_.end()) {
         children_.emplace(child->instance_name, child);
@@ -435,6 +429,7 @@ Generator *Generator::get_child_generator(const std::string &instance_name_) {
 }
 
 void Generator::remove_child_generator(const std::shared_ptr<Generator> &child) {
+    materialize_on_write();
     auto child_name = child->instance_name;
     auto pos = std::find(children_names_.begin(), children_names_.end(), child_name);
     if (pos != children_names_.end()) {
@@ -543,6 +538,8 @@ std::vector<std::string> Generator::get_all_var_names() {
 }
 
 void Generator::add_stmt(std::shared_ptr<Stmt> stmt) {
+    KRATOS_IR_COUNT(context_, StmtsAdded);
+    materialize_on_write();
     stmt->set_parent(this);
     stmts_.emplace_back(std::move(stmt));
 }
@@ -623,6 +620,8 @@ std::shared_ptr<Param> Generator::get_param(const std::string &param_name) const
 void Generator::set_use_stmt_remove_cache(bool value) { use_stmts_remove_cache_ = value; }
 
 void Generator::remove_stmt(const std::shared_ptr<Stmt> &stmt) {
+    KRATOS_IR_COUNT(context_, StmtsRemoved);
+    materialize_on_write();
     if (use_stmts_remove_cache_) {
         stmts_remove_cache_.emplace(stmt);
         return;
@@ -997,6 +996,99 @@ void Generator::wire_interface(const std::shared_ptr<InterfaceRef> &inst1,
 
 void Generator::wire(Var &left, Var &right) { add_stmt(left.assign(right)); }
 
+namespace {
+uint32_t batch_width(const std::vector<std::string> &names, const std::vector<uint32_t> &widths,
+                     uint64_t index) {
+    if (widths.size() == 1) return widths[0];
+    if (widths.size() != names.size())
+        throw UserException(::format("Number of widths ({0}) does not match number of names ({1})",
+                                     widths.size(), names.size()));
+    return widths[index];
+}
+
+void check_batch_size(const std::vector<Var *> &sinks, const std::vector<Var *> &sources) {
+    if (sinks.size() != sources.size())
+        throw UserException(::format("Number of sinks ({0}) does not match number of sources ({1})",
+                                     sinks.size(), sources.size()));
+}
+}  // namespace
+
+std::vector<Var *> Generator::var_batch(
+    const std::vector<std::string> &names, const std::vector<uint32_t> &widths, bool is_signed,
+    const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+    SourceLocations locations(debug_info);
+    std::vector<Var *> result;
+    result.reserve(names.size());
+    for (uint64_t i = 0; i < names.size(); i++) {
+        auto &v = var(names[i], batch_width(names, widths, i), 1, is_signed);
+        if (debug) v.fn_name_ln = locations;
+        result.emplace_back(&v);
+    }
+    return result;
+}
+
+std::vector<Port *> Generator::port_batch(
+    PortDirection direction, const std::vector<std::string> &names,
+    const std::vector<uint32_t> &widths, PortType type, bool is_signed,
+    const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+    SourceLocations locations(debug_info);
+    std::vector<Port *> result;
+    result.reserve(names.size());
+    for (uint64_t i = 0; i < names.size(); i++) {
+        auto &p = port(direction, names[i], batch_width(names, widths, i), 1, type, is_signed);
+        if (debug) p.fn_name_ln = locations;
+        result.emplace_back(&p);
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<AssignStmt>> Generator::wire_batch(
+    const std::vector<Var *> &sinks, const std::vector<Var *> &sources,
+    const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+    check_batch_size(sinks, sources);
+    SourceLocations locations(debug_info);
+    std::vector<std::shared_ptr<AssignStmt>> result;
+    result.reserve(sinks.size());
+    for (uint64_t i = 0; i < sinks.size(); i++) {
+        if (!sinks[i] || !sources[i]) throw UserException("Variable cannot be null (None)");
+        auto sink = sinks[i]->shared_from_this();
+        auto source = sources[i]->shared_from_this();
+        auto [correct_dir, correct_assign] = correct_wire_direction(sink, source);
+        if (!correct_assign) {
+            throw VarException(::format("{0} cannot be assign to {1}. Please check your module "
+                                        "hierarchy",
+                                        sink->to_string(), source->to_string()),
+                               {sink.get(), source.get()});
+        }
+        auto stmt = correct_dir ? sink->assign(source) : source->assign(sink);
+        add_stmt(stmt);
+        if (debug) stmt->fn_name_ln = locations;
+        result.emplace_back(stmt);
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<AssignStmt>> Generator::assign_batch(
+    StmtBlock *block, const std::vector<Var *> &sinks, const std::vector<Var *> &sources,
+    AssignmentType type, const std::vector<std::pair<std::string, uint32_t>> &debug_info) {
+    check_batch_size(sinks, sources);
+    SourceLocations locations(debug_info);
+    std::vector<std::shared_ptr<AssignStmt>> result;
+    result.reserve(sinks.size());
+    for (uint64_t i = 0; i < sinks.size(); i++) {
+        if (!sinks[i] || !sources[i]) throw UserException("Variable cannot be null (None)");
+        auto stmt = sinks[i]->assign(sources[i]->shared_from_this(), type);
+        if (block) {
+            block->add_stmt(stmt);
+        } else {
+            add_stmt(stmt);
+        }
+        if (debug) stmt->fn_name_ln = locations;
+        result.emplace_back(stmt);
+    }
+    return result;
+}
+
 void Generator::unwire(Var &var1, Var &var2) {
     // brute force search matching statement
     std::shared_ptr<Stmt> target = nullptr;
@@ -1018,7 +1110,17 @@ void Generator::unwire(Var &var1, Var &var2) {
     }
 }
 
+void Generator::elaborate() {
+    if (!lazy_body_) return;
+    // reset first so that the body is only built once
+    auto body = std::move(lazy_body_);
+    lazy_body_ = nullptr;
+    body(*this);
+}
+
 std::shared_ptr<Generator> Generator::clone() {
+    // clones share the content of the definition
+    elaborate();
     auto generator = std::make_shared<Generator>(context_, name);
     auto port_names = get_port_names();
     // also parameters
@@ -1054,6 +1156,434 @@ void Generator::set_clone_ref(const std::shared_ptr<Generator> &ref) {
     set_external(true);
 }
 
+namespace {
+// copies the content of a definition generator into one of its clones. vars that belong to
+// the definition are mapped to the clone's vars of the same name, vars that belong to the
+// definition's children are mapped to the clone's children
+class CloneContentCopier {
+public:
+    CloneContentCopier(Generator *def, Generator *target) : def_(def), target_(target) {}
+
+    static bool supported(Stmt *stmt) {
+        switch (stmt->type()) {
+            case StatementType::Assign: {
+                auto *assign = reinterpret_cast<AssignStmt *>(stmt);
+                return supported(assign->left()) && supported(assign->right());
+            }
+            case StatementType::If: {
+                auto *if_ = reinterpret_cast<IfStmt *>(stmt);
+                return supported(if_->predicate().get()) && supported(if_->then_body().get()) &&
+                       supported(if_->else_body().get());
+            }
+            case StatementType::Switch: {
+                auto *switch_ = reinterpret_cast<SwitchStmt *>(stmt);
+                if (!supported(switch_->target().get())) return false;
+                return std::all_of(switch_->body().begin(), switch_->body().end(),
+                                   [](auto const &iter) { return supported(iter.second.get()); });
+            }
+            case StatementType::Block: {
+                auto *block = reinterpret_cast<StmtBlock *>(stmt);
+                switch (block->block_type()) {
+                    case StatementBlockType::Sequential: {
+                        auto *seq = reinterpret_cast<SequentialStmtBlock *>(block);
+                        for (auto const &cond : seq->get_event_controls()) {
+                            if (cond.type != EventControlType::Edge || !supported(cond.var))
+                                return false;
+                        }
+                        break;
+                    }
+                    case StatementBlockType::Combinational:
+                    case StatementBlockType::Scope:
+                    case StatementBlockType::Latch:
+                    case StatementBlockType::Initial:
+                    case StatementBlockType::Final:
+                        break;
+                    default:
+                        return false;
+                }
+                return std::all_of(block->begin(), block->end(),
+                                   [](auto const &s) { return supported(s.get()); });
+            }
+            case StatementType::Comment:
+            case StatementType::RawString:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool supported(Var *var) {
+        switch (var->type()) {
+            case VarType::Base:
+                // function calls are unnamed vars
+                return !var->name.empty() && !var->is_enum() && !var->is_struct() &&
+                       !var->is_interface() && attached(var);
+            case VarType::PortIO:
+                return !var->is_enum() && !var->is_struct() && !var->is_interface() &&
+                       attached(var);
+            case VarType::Parameter:
+            case VarType::ConstValue:
+                return true;
+            case VarType::Slice: {
+                auto *slice = reinterpret_cast<VarSlice *>(var);
+                if (slice->is_struct()) return false;
+                if (slice->sliced_by_var() &&
+                    !supported(reinterpret_cast<VarVarSlice *>(slice)->sliced_var()))
+                    return false;
+                return supported(slice->parent_var);
+            }
+            case VarType::BaseCasted: {
+                auto *casted = reinterpret_cast<VarCasted *>(var);
+                if (casted->cast_type() == VarCastType::Enum ||
+                    casted->cast_type() == VarCastType::Resize)
+                    return false;
+                return supported(casted->parent_var());
+            }
+            case VarType::Expression: {
+                auto *expr = reinterpret_cast<Expr *>(var);
+                switch (expr->op) {
+                    case ExprOp::Concat: {
+                        auto const &vars = reinterpret_cast<VarConcat *>(expr)->vars();
+                        return std::all_of(vars.begin(), vars.end(),
+                                           [](Var *v) { return supported(v); });
+                    }
+                    case ExprOp::Extend:
+                        return supported(reinterpret_cast<VarExtend *>(expr)->parent_var());
+                    case ExprOp::Conditional:
+                        return supported(reinterpret_cast<ConditionalExpr *>(expr)->condition) &&
+                               supported(expr->left) && supported(expr->right);
+                    case ExprOp::Duplicate:
+                        return false;
+                    default:
+                        if (!expr->left) return false;
+                        return supported(expr->left) && (!expr->right || supported(expr->right));
+                }
+            }
+            default:
+                return false;
+        }
+    }
+
+    // vars of a child are mapped by instance name, so the child has to still be there
+    static bool attached(Var *var) {
+        auto *gen = var->generator();
+        auto *parent = gen ? gen->parent_generator() : nullptr;
+        return !parent || parent->get_child_generator(gen->instance_name) == gen;
+    }
+
+    std::shared_ptr<Var> copy(Var *var) {
+        if (mapped_.find(var) != mapped_.end()) return mapped_.at(var);
+        auto result = copy_(var);
+        mapped_.emplace(var, result);
+        return result;
+    }
+
+    std::shared_ptr<Stmt> copy(const std::shared_ptr<Stmt> &stmt) {
+        std::shared_ptr<Stmt> result;
+        switch (stmt->type()) {
+            case StatementType::Assign: {
+                auto assign = stmt->as<AssignStmt>();
+                result = copy(assign->left())->assign(copy(assign->right()),
+                                                      assign->assign_type());
+                break;
+            }
+            case StatementType::If: {
+                auto if_ = stmt->as<IfStmt>();
+                auto new_if = std::make_shared<IfStmt>(copy(if_->predicate().get()));
+                for (auto const &s : *if_->then_body()) new_if->add_then_stmt(copy(s));
+                for (auto const &s : *if_->else_body()) new_if->add_else_stmt(copy(s));
+                result = new_if;
+                break;
+            }
+            case StatementType::Switch: {
+                auto switch_ = stmt->as<SwitchStmt>();
+                auto new_switch = std::make_shared<SwitchStmt>(copy(switch_->target().get()));
+                for (auto const &[c, body] : switch_->body()) {
+                    auto switch_case =
+                        c ? std::static_pointer_cast<Const>(copy(c.get())) : nullptr;
+                    if (body->empty()) {
+                        new_switch->add_switch_case(switch_case,
+                                                    std::make_shared<ScopedStmtBlock>());
+                    }
+                    for (auto const &s : *body) new_switch->add_switch_case(switch_case, copy(s));
+                }
+                result = new_switch;
+                break;
+            }
+            case StatementType::Block: {
+                auto block = stmt->as<StmtBlock>();
+                std::shared_ptr<StmtBlock> new_block;
+                switch (block->block_type()) {
+                    case StatementBlockType::Combinational: {
+                        auto comb = std::make_shared<CombinationalStmtBlock>();
+                        comb->set_general_purpose(
+                            block->as<CombinationalStmtBlock>()->is_general_purpose());
+                        new_block = comb;
+                        break;
+                    }
+                    case StatementBlockType::Sequential: {
+                        auto seq = std::make_shared<SequentialStmtBlock>();
+                        for (auto const &cond : block->as<SequentialStmtBlock>()->get_event_controls())
+                            seq->add_condition({cond.edge, copy(cond.var)});
+                        new_block = seq;
+                        break;
+                    }
+                    case StatementBlockType::Scope:
+                        new_block = std::make_shared<ScopedStmtBlock>();
+                        break;
+                    case StatementBlockType::Latch:
+                        new_block = std::make_shared<LatchStmtBlock>();
+                        break;
+                    case StatementBlockType::Initial:
+                        new_block = std::make_shared<InitialStmtBlock>();
+                        break;
+                    case StatementBlockType::Final:
+                        new_block = std::make_shared<FinalStmtBlock>();
+                        break;
+                    default:
+                        throw InternalException("Unsupported block type for clone");
+                }
+                for (auto const &s : *block) new_block->add_stmt(copy(s));
+                auto label = def_->get_block_name(block.get());
+                if (label) target_->add_named_block(*label, new_block);
+                result = new_block;
+                break;
+            }
+            case StatementType::Comment:
+            case StatementType::RawString:
+                // no vars involved
+                result = stmt->clone();
+                break;
+            default:
+                throw InternalException("Unsupported statement type for clone");
+        }
+        // statements share the same immutable scope frames
+        result->set_scope_frame(stmt->scope_frame());
+        result->fn_name_ln = stmt->fn_name_ln;
+        result->comment = stmt->comment;
+        result->verilog_ln = stmt->verilog_ln;
+        return result;
+    }
+
+private:
+    Generator *def_;
+    Generator *target_;
+    std::unordered_map<Var *, std::shared_ptr<Var>> mapped_;
+
+    std::shared_ptr<Var> copy_(Var *var) {
+        switch (var->type()) {
+            case VarType::Base:
+            case VarType::PortIO: {
+                auto *gen = var->generator();
+                if (gen == def_) {
+                    auto result = target_->get_var(var->name);
+                    if (!result) {
+                        auto &v = target_->var(var->name, var->var_width(), var->size(),
+                                               var->is_signed());
+                        v.set_explicit_array(var->explicit_array());
+                        v.set_is_packed(var->is_packed());
+                        if (var->width_param()) v.set_width_param(copy(var->width_param()).get());
+                        v.fn_name_ln = var->fn_name_ln;
+                        result = v.shared_from_this();
+                    }
+                    return result;
+                } else if (gen->parent_generator() == def_) {
+                    auto *child = target_->get_child_generator(gen->instance_name);
+                    if (!child) throw InternalException("Cloned child generator not found");
+                    return child->get_var(var->name);
+                }
+                return var->shared_from_this();
+            }
+            case VarType::Parameter: {
+                if (var->generator() != def_) return var->shared_from_this();
+                auto const *param = reinterpret_cast<Param *>(var);
+                auto result = target_->get_param(param->parameter_name());
+                if (!result)
+                    throw InternalException(
+                        ::format("Parameter {0} not found in clone", param->parameter_name()));
+                return result;
+            }
+            case VarType::Slice: {
+                auto *slice = reinterpret_cast<VarSlice *>(var);
+                auto parent = copy(slice->parent_var);
+                if (slice->sliced_by_var()) {
+                    auto index = copy(reinterpret_cast<VarVarSlice *>(slice)->sliced_var());
+                    return (*parent)[index].shared_from_this();
+                }
+                return slice->slice_var(parent);
+            }
+            case VarType::BaseCasted: {
+                auto *casted = reinterpret_cast<VarCasted *>(var);
+                return copy(casted->parent_var())->cast(casted->cast_type());
+            }
+            case VarType::Expression: {
+                auto *expr = reinterpret_cast<Expr *>(var);
+                switch (expr->op) {
+                    case ExprOp::Concat: {
+                        auto const &vars = reinterpret_cast<VarConcat *>(expr)->vars();
+                        auto result = copy(vars[0]);
+                        for (uint64_t i = 1; i < vars.size(); i++) {
+                            result = result->concat(*copy(vars[i])).shared_from_this();
+                        }
+                        return result;
+                    }
+                    case ExprOp::Extend: {
+                        auto *extend = reinterpret_cast<VarExtend *>(expr);
+                        return copy(extend->parent_var())->extend(extend->width()).shared_from_this();
+                    }
+                    case ExprOp::Conditional: {
+                        auto *cond = reinterpret_cast<ConditionalExpr *>(expr);
+                        auto result = std::make_shared<ConditionalExpr>(
+                            copy(cond->condition), copy(cond->left), copy(cond->right));
+                        result->set_generator(target_);
+                        target_->add_expr(result);
+                        return result;
+                    }
+                    default: {
+                        auto left = copy(expr->left);
+                        auto right = expr->right ? copy(expr->right) : nullptr;
+                        return target_->expr(expr->op, left.get(), right.get()).shared_from_this();
+                    }
+                }
+            }
+            case VarType::ConstValue:
+            default:
+                // constants are shared
+                return var->shared_from_this();
+        }
+    }
+};
+}  // namespace
+
+bool Generator::can_copy_content() const {
+    if (external() || !funcs_.empty() || !fsms_.empty() || !interfaces_.empty() ||
+        !port_bundle_mapping_.empty() || !properties_.empty() || !calls_.empty() ||
+        !enums_.empty())
+        return false;
+    return std::all_of(stmts_.begin(), stmts_.end(),
+                       [](auto const &stmt) { return CloneContentCopier::supported(stmt.get()); });
+}
+
+void Generator::materialize() {
+    if (!is_cloned_ || !def_instance_) return;
+    auto *def = def_instance_;
+    if (!def->can_copy_content()) {
+        throw GeneratorException(
+            ::format("Unable to materialize clone of {0}: definition contains content that "
+                     "cannot be copied",
+                     def->name),
+            {this, def});
+    }
+    // everything that can fail is done before the clone is changed, so that a failure leaves a
+    // clone that still reads from its definition
+    for (auto const &[param_name, param] : def->params_) {
+        if (!get_param(param_name))
+            throw GeneratorException(
+                ::format("Unable to materialize clone of {0}: parameter {1} not found", def->name,
+                         param_name),
+                {this, def});
+    }
+    // children are cloned as well. they stay as light-weighted clones until changed
+    std::vector<std::shared_ptr<Generator>> new_children;
+    new_children.reserve(def->children_names_.size());
+    for (auto const &child_name : def->children_names_) {
+        auto const &child = def->children_.at(child_name);
+        auto *child_def = child->is_cloned() && child->def_instance() ? child->def_instance()
+                                                                       : child.get();
+        auto new_child = child_def->clone();
+        for (auto const &[param_name, param] : child->get_params()) {
+            auto new_param = new_child->get_param(param_name);
+            if (!new_param || !param->has_value()) continue;
+            auto const *parent_param = param->parent_param();
+            if (parent_param && parent_param->generator() == def) {
+                new_param->set_value(get_param(parent_param->parameter_name()));
+            } else {
+                new_param->set_value(param->value());
+            }
+        }
+        new_children.emplace_back(new_child);
+    }
+
+    // the clone owns its content from now on
+    is_cloned_ = false;
+    is_external_ = false;
+
+    copy_over_missing_ports(def->shared_from_this());
+    for (uint64_t i = 0; i < new_children.size(); i++) {
+        auto const &child_name = def->children_names_[i];
+        add_child_generator(child_name, new_children[i]);
+        if (def->children_debug_.find(child_name) != def->children_debug_.end())
+            children_debug_.emplace(child_name, def->children_debug_.at(child_name));
+        if (def->children_comments_.find(child_name) != def->children_comments_.end())
+            children_comments_.emplace(child_name, def->children_comments_.at(child_name));
+    }
+
+    CloneContentCopier copier(def, this);
+    // copy the vars first to keep the declaration order
+    for (auto const &[var_name, var] : def->vars_) {
+        if (var->type() == VarType::Base) copier.copy(var.get());
+    }
+    stmts_.reserve(stmts_.size() + def->stmts_.size());
+    for (auto const &stmt : def->stmts_) {
+        add_stmt(copier.copy(stmt));
+    }
+}
+
+void Generator::release_body() {
+    // only the ports, including the members of interface ports, are kept
+    std::unordered_set<const Var *> kept;
+    for (auto const &port_name : ports_) kept.emplace(vars_.at(port_name).get());
+    for (auto const &[ref_name, ref] : interfaces_) {
+        if (!ref->is_port()) continue;
+        for (auto const &iter : ref->vars()) kept.emplace(iter.second);
+        for (auto const &iter : ref->ports()) kept.emplace(iter.second);
+    }
+    // connections made inside the generator are dropped. the ones made by the parent are kept
+    // so that the stub can still be instantiated
+    std::vector<std::shared_ptr<AssignStmt>> internal_stmts;
+    for (auto iter = vars_.begin(); iter != vars_.end();) {
+        auto const &var = iter->second;
+        if (kept.find(var.get()) == kept.end()) {
+            iter = vars_.erase(iter);
+            continue;
+        }
+        internal_stmts.clear();
+        for (auto const &stmt : var->sinks()) {
+            if (stmt->generator_parent() == this) internal_stmts.emplace_back(stmt);
+        }
+        for (auto const &stmt : internal_stmts) var->remove_sink(stmt);
+        internal_stmts.clear();
+        for (auto const &stmt : var->sources()) {
+            if (stmt->generator_parent() == this) internal_stmts.emplace_back(stmt);
+        }
+        for (auto const &stmt : internal_stmts) var->remove_source(stmt);
+        iter++;
+    }
+    for (auto iter = interfaces_.begin(); iter != interfaces_.end();) {
+        if (!iter->second->is_port()) {
+            iter = interfaces_.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    for (auto const &iter : children_) iter.second->parent_generator_ = nullptr;
+    children_.clear();
+    children_names_.clear();
+    children_debug_.clear();
+    children_comments_.clear();
+    stmts_.clear();
+    stmts_remove_cache_.clear();
+    exprs_.clear();
+    named_blocks_.clear();
+    fsms_.clear();
+    funcs_.clear();
+    func_index_.clear();
+    calls_.clear();
+    auxiliary_vars_.clear();
+    properties_.clear();
+    is_external_ = true;
+}
+
 void Generator::copy_over_missing_ports(const std::shared_ptr<Generator> &ref) {
     auto port_names = ref->get_port_names();
     for (auto const &port_name : port_names) {
@@ -2,6 +2,7 @@
 
 #ifndef KRATOS_MODULE_HH
 #define KRATOS_MODULE_HH
+#include <functional>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -193,6 +194,12 @@ public:
     bool is_stub() const { return is_stub_; }
     void set_is_stub(bool value) { is_stub_ = value; }
 
+    // lazy elaboration. the ports and parameters are declared up front and the body is built
+    // by elaborate() once the generator is known to be needed, see elaborate_lazy_generators
+    void set_lazy_body(std::function<void(Generator &)> body) { lazy_body_ = std::move(body); }
+    bool is_lazy() const { return static_cast<bool>(lazy_body_); }
+    void elaborate();
+
     // if imported from verilog or specified
     bool external() const { return (!lib_files_.empty()) || is_external_; }
     std::string external_filename() const { return lib_files_.empty() ? "" : lib_files_[0]; }
@@ -206,16 +213,46 @@ public:
     void wire(Var &left, Var &right);
     void unwire(Var &var1, Var &var2);
 
+    // bulk construction for netlist-style generators. they behave the same as calling the
+    // single versions in a loop. a single width applies to every name, and if debug is on,
+    // every created node gets debug_info
+    std::vector<Var *> var_batch(
+        const std::vector<std::string> &names, const std::vector<uint32_t> &widths,
+        bool is_signed = false,
+        const std::vector<std::pair<std::string, uint32_t>> &debug_info = {});
+    std::vector<Port *> port_batch(
+        PortDirection direction, const std::vector<std::string> &names,
+        const std::vector<uint32_t> &widths, PortType type = PortType::Data,
+        bool is_signed = false,
+        const std::vector<std::pair<std::string, uint32_t>> &debug_info = {});
+    // sinks[i] is wired to sources[i]. directions are corrected the same way as single wires
+    std::vector<std::shared_ptr<AssignStmt>> wire_batch(
+        const std::vector<Var *> &sinks, const std::vector<Var *> &sources,
+        const std::vector<std::pair<std::string, uint32_t>> &debug_info = {});
+    // sinks[i] = sources[i] is added to the block, or to the top level if block is null
+    std::vector<std::shared_ptr<AssignStmt>> assign_batch(
+        StmtBlock *block, const std::vector<Var *> &sinks, const std::vector<Var *> &sources,
+        AssignmentType type, const std::vector<std::pair<std::string, uint32_t>> &debug_info = {});
+
     bool debug = false;
 
     const std::unordered_set<std::shared_ptr<Generator>> &get_clones() const { return clones_; }
+    // a clone only owns its ports and parameters. the content is shared with the definition
+    // instance until the clone is changed, at which point materialize() copies it over
     std::shared_ptr<Generator> clone();
+    void materialize();
+    // whether materialize() can copy the content of this definition. functions, FSMs,
+    // interfaces, port bundles, enums and properties are not copied yet
+    bool can_copy_content() const;
     bool is_cloned() const { return is_cloned_; }
     // this is for internal libraries only. use it only if you know what you're doing
     void set_is_cloned(bool value) { is_cloned_ = value; }
     // set the def parent clone. use it only if you know what you're doing
     void set_clone_ref(const std::shared_ptr<Generator> &ref);
     void copy_over_missing_ports(const std::shared_ptr<Generator> &ref);
+    // keeps only the ports and parameters and turns the generator into an external stub.
+    // used by stream_verilog once the generator has been written out
+    void release_body();
 
     // useful passes on generator itself
     void replace(const std::string &child_name, const std::shared_ptr<Generator> &new_child);
@@ -308,6 +345,7 @@ private:
 
     bool is_stub_ = false;
     bool is_external_ = false;
+    std::function<void(Generator &)> lazy_body_;
 
     // used for shallow cloning
     std::unordered_set<std::shared_ptr<Generator>> clones_;
@@ -349,6 +387,11 @@ private:
 
     // helper functions
     void check_param_name_conflict(const std::string &parameter_name);
+    // copy-on-write for clones. content that can't be copied is left to the definition, as
+    // clones have always done
+    void inline materialize_on_write() {
+        if (is_cloned_ && def_instance_ && def_instance_->can_copy_content()) materialize();
+    }
 };
 
 }  // namespace kratos
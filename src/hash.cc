@@ -4,6 +4,7 @@
 
 #include "cxxpool.h"
 #include "debug.hh"
+#include "fmt/format.h"
 #include "generator.hh"
 #include "graph.hh"
 #include "ir.hh"
@@ -11,6 +12,8 @@
 #include "stmt.hh"
 #include "util.hh"
 
+using fmt::format;
+
 namespace kratos {
 /*
  * Once this project is moved to gcc-9, we will use the parallel execution
@@ -212,6 +215,10 @@ uint64_t hash_64_fnv1a(const void* key, uint64_t len) {
 
 }  // hash_64_fnv1a
 
+std::pair<uint64_t, uint64_t> hash_128(const void* key, uint64_t len) {
+    return {XXHash64::hash(key, len, 0), XXHash64::hash(key, len, 0x9e3779b97f4a7c15)};
+}
+
 constexpr uint64_t shift_const(uint64_t value, uint8_t amount) {
     return (value << amount) | (value >> (64u - amount));
 }
@@ -238,8 +245,38 @@ static uint64_t hash_var(Var* var) {
     }
 }
 
+static bool is_foldable_constant(Var* var) {
+    return var->type() == VarType::ConstValue && !reinterpret_cast<Const*>(var)->is_bignum();
+}
+
+// constants only contribute their width and are collected in the order they are visited.
+// concatenations, extensions and conditional expressions keep their constants
+static uint64_t hash_var_template(Var* var, AssignStmt* stmt,
+                                  std::vector<std::pair<AssignStmt*, Const*>>& constant_slots) {
+    if (!var) return 0;
+    if (is_foldable_constant(var)) {
+        constant_slots.emplace_back(stmt, reinterpret_cast<Const*>(var));
+        constexpr uint64_t const_signature = shift_const(0x9e3779b97f4a7c16, 5);
+        return const_signature ^ var->width() ^ (static_cast<uint64_t>(var->is_signed()) << 32u);
+    } else if (var->type() == VarType::Expression) {
+        auto* expr = reinterpret_cast<Expr*>(var);
+        if (expr->op >= ExprOp::Conditional) return hash_var(var);
+        auto op_hash = (uint64_t)expr->op;
+        // unlike hash_var, the operand order matters since the constants are matched by position
+        auto left = hash_var_template(expr->left, stmt, constant_slots);
+        auto right = hash_var_template(expr->right, stmt, constant_slots);
+        return shift_const(left, 1) ^ right ^ op_hash;
+    } else {
+        return hash_var(var);
+    }
+}
+
 class HashVisitor : public IRVisitor {
 public:
+    HashVisitor(Generator* root, std::vector<std::pair<AssignStmt*, Const*>>* constant_slots)
+        : HashVisitor(root) {
+        constant_slots_ = constant_slots;
+    }
     explicit HashVisitor(Generator* root) : root_(root) {
         context_ = root->context();
         // compute the hash for all vars
@@ -264,7 +301,10 @@ public:
     }
 
     void visit(AssignStmt* stmt) override {
-        uint64_t stmt_hash = hash_var(stmt->left()) ^ (shift(hash_var(stmt->right()), 1));
+        auto right_hash = constant_slots_
+                              ? hash_var_template(stmt->right(), stmt, *constant_slots_)
+                              : hash_var(stmt->right());
+        uint64_t stmt_hash = hash_var(stmt->left()) ^ (shift(right_hash, 1));
         // based on level
         stmt_hash = shift(stmt_hash, level);
         stmt_hashes_.emplace_back(stmt_hash);
@@ -342,6 +382,7 @@ private:
     std::vector<uint64_t> stmt_hashes_;
     Generator* root_;
     Context* context_;
+    std::vector<std::pair<AssignStmt*, Const*>>* constant_slots_ = nullptr;
 
     inline static uint64_t shift(uint64_t value, uint8_t amount) {
         return (value << amount) | (value >> (64u - amount));
@@ -349,6 +390,11 @@ private:
 };
 
 uint64_t hash_generator(Generator* generator) {
+    // streamed stubs keep the hash of the module that was written out
+    if (generator->external()) {
+        auto streamed_hash = generator->context()->streamed_module_hash(generator->name);
+        if (streamed_hash) return *streamed_hash;
+    }
     // if it's unique, just has the name
     if (generator->context()->is_unique(generator)) {
         return hash_64_fnv1a(generator->name.c_str(), generator->name.size());
@@ -359,13 +405,72 @@ uint64_t hash_generator(Generator* generator) {
     return hash_visitor.produce_hash();
 }
 
+uint64_t hash_generator_template(Generator* generator,
+                                 std::vector<std::pair<AssignStmt*, Const*>>& constant_slots) {
+    HashVisitor hash_visitor(generator, &constant_slots);
+    // only the generator's own content. child generators are accounted for below
+    for (uint64_t i = 0; i < generator->child_count(); i++) {
+        auto* child = generator->get_child(i);
+        if (child->ir_node_kind() != IRNodeKind::GeneratorKind) hash_visitor.visit_root(child);
+    }
+    std::vector<uint64_t> hashes = {hash_visitor.produce_hash()};
+    // the template has to be the same module text, so the declarations are compared in full
+    uint64_t decl_hash = 0;
+    for (auto const& [name, var] : generator->vars()) {
+        auto decl = ::format("{0} {1} {2} {3} {4}", name, var->var_width(),
+                             string::join(var->size().begin(), var->size().end(), ","),
+                             var->is_signed(), static_cast<uint32_t>(var->type()));
+        if (var->type() == VarType::PortIO) {
+            auto* port = reinterpret_cast<Port*>(var.get());
+            decl.append(std::to_string(static_cast<uint32_t>(port->port_direction())));
+        }
+        decl_hash ^= hash_64_fnv1a(decl.c_str(), decl.size());
+    }
+    for (auto const& [name, param] : generator->get_params()) {
+        auto decl = ::format("{0} {1} {2}", name, param->width(),
+                             param->get_initial_value() ? *param->get_initial_value() : 0);
+        decl_hash ^= hash_64_fnv1a(decl.c_str(), decl.size());
+    }
+    hashes.emplace_back(decl_hash);
+    // parameter values of the child instances are part of the instantiation statements
+    auto* context = generator->context();
+    uint64_t child_hash = 0;
+    for (auto const& child : generator->get_child_generators()) {
+        auto inst = ::format("{0} {1}", child->instance_name, child->name);
+        for (auto const& [name, param] : child->get_params()) {
+            inst.append(::format(" {0}={1}", name, param->value_str()));
+        }
+        uint64_t hash = hash_64_fnv1a(inst.c_str(), inst.size());
+        if (context->has_hash(child.get())) hash ^= shift_const(context->get_hash(child.get()), 7);
+        child_hash ^= hash;
+    }
+    hashes.emplace_back(child_hash);
+    return XXHash64::hash(hashes.data(), hashes.size() * sizeof(uint64_t), 0);
+}
+
 void hash_generator_src(Context* context, Generator* generator) {
-    auto filename = generator->external_filename();
-    std::ifstream fs(filename);
+    auto const& filename = generator->external_filename();
+    auto stamp = fs::file_stamp(filename);
+    if (!stamp) {
+        // missing files hash as empty content
+        context->add_hash(generator, XXHash64::hash(nullptr, 0, 0));
+        return;
+    }
+    // unchanged files are not read again
+    auto path = fs::abspath(filename);
+    auto cached = context->get_source_hash(path, *stamp);
+    if (cached) {
+        context->add_hash(generator, *cached);
+        return;
+    }
 
-    std::string content;
-    content.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
-    uint64_t hash = XXHash64::hash(content.c_str(), content.size(), 0);
+    fs::MappedFile file(filename);
+    auto content = file.content();
+    // the mapped pages are streamed through the hasher without an extra copy
+    XXHash64 hasher(0);
+    hasher.add(content.data(), content.size());
+    auto hash = hasher.hash();
+    context->add_source_hash(path, *stamp, hash);
     context->add_hash(generator, hash);
 }
 
@@ -393,7 +498,10 @@ void hash_generators_context(Context* context, Generator* root, HashStrategy str
         for (auto const& node : sequence) {
             // different cases
             if (node->external()) {
-                if (node->external_filename().empty()) {
+                auto streamed_hash = context->streamed_module_hash(node->name);
+                if (streamed_hash) {
+                    if (!context->has_hash(node)) context->add_hash(node, *streamed_hash);
+                } else if (node->external_filename().empty()) {
                     // user marked external file, skip it
                     continue;
                 } else {
@@ -7,7 +7,16 @@ namespace kratos {
 
 void hash_generators_context(Context *context, Generator *root, HashStrategy strategy);
 
+// hash of the generator's own content in which the constants on the right hand side of
+// assignments only contribute their width. those constants are appended to constant_slots in a
+// fixed order, together with the assignment using them, so generators with the same hash can be
+// matched slot by slot
+uint64_t hash_generator_template(Generator *generator,
+                                 std::vector<std::pair<AssignStmt *, Const *>> &constant_slots);
+
 uint64_t hash_64_fnv1a(const void* key, uint64_t len);
+// 128-bit digest made of two independently seeded xxhash64
+std::pair<uint64_t, uint64_t> hash_128(const void* key, uint64_t len);
 
 }  // namespace kratos
 
@@ -1,5 +1,7 @@
 #include "ir.hh"
 
+#include <mutex>
+
 #include "cxxpool.h"
 #include "generator.hh"
 #include "graph.hh"
@@ -7,6 +9,88 @@
 
 namespace kratos {
 
+std::atomic<SourceFileTable *> SourceFileTable::current_ = nullptr;
+
+SourceFileTable::~SourceFileTable() {
+    auto *self = this;
+    current_.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+}
+
+std::shared_ptr<SourceFileTable> SourceFileTable::shared() {
+    static std::mutex mutex;
+    static std::weak_ptr<SourceFileTable> table;
+    std::lock_guard guard(mutex);
+    auto result = table.lock();
+    if (!result) {
+        result = std::make_shared<SourceFileTable>();
+        table = result;
+        current_.store(result.get(), std::memory_order_release);
+    }
+    return result;
+}
+
+uint32_t SourceFileTable::intern(const std::string &filename) {
+    {
+        std::shared_lock lock(mutex_);
+        auto iter = ids_.find(filename);
+        if (iter != ids_.end()) return iter->second;
+    }
+    std::unique_lock lock(mutex_);
+    auto iter = ids_.find(filename);
+    if (iter != ids_.end()) return iter->second;
+    auto id = static_cast<uint32_t>(names_.size());
+    auto const &name = names_.emplace_back(filename);
+    ids_.emplace(name, id);
+    return id;
+}
+
+const std::string &SourceFileTable::filename(uint32_t id) const {
+    static const std::string empty;
+    std::shared_lock lock(mutex_);
+    // ids outlive the table they come from if a node outlives every context
+    return id < names_.size() ? names_[id] : empty;
+}
+
+SourceLocations::SourceLocations(const std::vector<std::pair<std::string, uint32_t>> &entries) {
+    entries_.reserve(entries.size());
+    for (auto const &entry : entries) emplace_back(entry);
+}
+
+SourceLocations::value_type SourceLocations::operator[](uint64_t index) const {
+    static const std::string empty;
+    auto const &[file_id, line] = entries_[index];
+    auto const *table = SourceFileTable::current();
+    return {table ? table->filename(file_id) : empty, line};
+}
+
+void SourceLocations::insert(const const_iterator &pos,
+                             const std::pair<std::string, uint32_t> &entry) {
+    auto id = SourceFileTable::shared()->intern(entry.first);
+    entries_.insert(entries_.begin() + static_cast<int64_t>(pos.index()),
+                    std::make_pair(id, entry.second));
+}
+
+void SourceLocations::insert(const const_iterator &pos, const const_iterator &first,
+                             const const_iterator &last) {
+    // the ids are shared, so they are copied over as is
+    auto const &source = first.locations()->entries_;
+    std::vector<std::pair<uint32_t, uint32_t>> temp(
+        source.begin() + static_cast<int64_t>(first.index()),
+        source.begin() + static_cast<int64_t>(last.index()));
+    entries_.insert(entries_.begin() + static_cast<int64_t>(pos.index()), temp.begin(),
+                    temp.end());
+}
+
+SourceLocations::operator std::vector<std::pair<std::string, uint32_t>>() const {
+    std::vector<std::pair<std::string, uint32_t>> result;
+    result.reserve(entries_.size());
+    for (uint64_t i = 0; i < entries_.size(); i++) {
+        auto [filename, line] = (*this)[i];
+        result.emplace_back(filename, line);
+    }
+    return result;
+}
+
 uint64_t IRNode::index_of(const kratos::IRNode *node) {
     uint64_t index;
     for (index = 0; index < child_count(); index++) {
@@ -21,8 +105,25 @@ bool IRNode::has_attribute(const std::string &value_str) const {
                        [&](auto const &attr) { return attr->value_str == value_str; });
 }
 
+Context *IRVisitor::node_context(IRNode *node) {
+    Generator *generator = nullptr;
+    switch (node->ir_node_kind()) {
+        case IRNodeKind::GeneratorKind:
+            generator = reinterpret_cast<Generator *>(node);
+            break;
+        case IRNodeKind::VarKind:
+            generator = reinterpret_cast<Var *>(node)->generator();
+            break;
+        case IRNodeKind::StmtKind:
+            generator = reinterpret_cast<Stmt *>(node)->generator_parent();
+            break;
+    }
+    return generator ? generator->context() : nullptr;
+}
+
 void IRVisitor::visit_root(IRNode *root) {
     // recursively call visits
+    count_visit(root);
     root->accept(this);
     level++;
     uint64_t count = 0;
@@ -40,6 +141,7 @@ void IRVisitor::visit_root(IRNode *root) {
 }
 
 void IRVisitor::visit_root_s(kratos::IRNode *root) {
+    count_visit(root);
     root->accept(this);
     uint64_t count = 0;
     while (count < root->child_count()) {
@@ -58,6 +160,7 @@ void IRVisitor::visit_root_tp(kratos::IRNode *root) {
         return;
     }
     auto *gen = reinterpret_cast<Generator *>(root);
+    resolve_stats_context(gen);
     GeneratorGraph graph(gen);
 
     auto nodes = graph.get_nodes();
@@ -70,6 +173,7 @@ void IRVisitor::visit_root_tp(kratos::IRNode *root) {
         auto t = pool.push(
             [this](Generator *g) {
                 if (g->external() || g->is_cloned()) return;
+                count_visit(g);
                 g->accept(this);
                 uint64_t count = 0;
                 while (count < g->child_count()) {
@@ -93,6 +197,7 @@ void IRVisitor::visit_root_tp(kratos::IRNode *root) {
 
 void IRVisitor::visit_generator_root(Generator *generator) {
     auto children = generator->get_child_generators();
+    count_visit(generator);
     generator->accept_generator(this);
     level++;
     for (auto &child : children) visit_generator_root(child.get());
@@ -100,6 +205,7 @@ void IRVisitor::visit_generator_root(Generator *generator) {
 }
 
 void IRVisitor::visit_generator_root_p(kratos::Generator *generator) {
+    resolve_stats_context(generator);
     GeneratorGraph graph(generator);
     auto levels = graph.get_leveled_nodes();
     uint32_t num_cpus = get_num_cpus();
@@ -111,7 +217,12 @@ void IRVisitor::visit_generator_root_p(kratos::Generator *generator) {
         std::vector<std::future<void>> tasks;
         tasks.reserve(current_level.size());
         for (auto *mod : current_level) {
-            auto t = pool.push([=](Generator *g) { g->accept_generator(this); }, mod);
+            auto t = pool.push(
+                [=](Generator *g) {
+                    count_visit(g);
+                    g->accept_generator(this);
+                },
+                mod);
             tasks.emplace_back(std::move(t));
         }
         for (auto &t : tasks) {
@@ -121,6 +232,7 @@ void IRVisitor::visit_generator_root_p(kratos::Generator *generator) {
 }
 
 void IRVisitor::visit_generator_root_tp(kratos::Generator *generator) {
+    resolve_stats_context(generator);
     GeneratorGraph graph(generator);
     auto nodes = graph.get_nodes();
     uint32_t num_cpus = get_num_cpus();
@@ -128,7 +240,12 @@ void IRVisitor::visit_generator_root_tp(kratos::Generator *generator) {
     std::vector<std::future<void>> tasks;
     tasks.reserve(nodes.size());
     for (auto *mod : nodes) {
-        auto t = pool.push([=](Generator *g) { g->accept_generator(this); }, mod);
+        auto t = pool.push(
+            [=](Generator *g) {
+                count_visit(g);
+                g->accept_generator(this);
+            },
+            mod);
         tasks.emplace_back(std::move(t));
     }
     for (auto &t : tasks) {
@@ -137,6 +254,7 @@ void IRVisitor::visit_generator_root_tp(kratos::Generator *generator) {
 }
 
 void IRVisitor::visit_content(Generator *generator) {
+    count_visit(generator);
     generator->accept_generator(this);
     level++;
     uint64_t stmts_count = generator->stmts_count();
@@ -154,6 +272,7 @@ void IRVisitor::visit_content(Generator *generator) {
         auto *ptr = var.get();
         if (visited_.find(ptr) == visited_.end()) {
             visited_.emplace(ptr);
+            count_visit(ptr);
             visit(var.get());
         }
     }
@@ -172,6 +291,7 @@ void IRVisitor::visit_content(Generator *generator) {
 }
 
 void IRVisitor::visit_content_s(Generator *generator) {
+    count_visit(generator);
     generator->accept_generator(this);
     uint64_t stmts_count = generator->stmts_count();
     for (uint64_t i = 0; i < stmts_count; i++) {
@@ -182,6 +302,7 @@ void IRVisitor::visit_content_s(Generator *generator) {
     auto var_names = generator->get_all_var_names();
     for (auto const &name : var_names) {
         auto var = generator->get_var(name);
+        count_visit(var.get());
         visit(var.get());
     }
     // visit the functions
@@ -1,7 +1,14 @@
 #ifndef KRATOS_IR_HH
 #define KRATOS_IR_HH
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "context.hh"
@@ -12,6 +19,100 @@ class IRVisitor;
 
 enum IRNodeKind { GeneratorKind, VarKind, StmtKind };
 
+// source file names of the debug info, interned once and referred to by id. the table only
+// grows so references to the names stay valid. every live context holds on to the same table,
+// so ids stay valid when a node moves between contexts or is not attached to one yet. it is
+// released with the last context
+class SourceFileTable {
+public:
+    ~SourceFileTable();
+
+    // the table of the live contexts. a new one is created if there is none
+    static std::shared_ptr<SourceFileTable> shared();
+    // the table of the live contexts, or null
+    static SourceFileTable *current() { return current_.load(std::memory_order_acquire); }
+
+    uint32_t intern(const std::string &filename);
+    const std::string &filename(uint32_t id) const;
+
+private:
+    static std::atomic<SourceFileTable *> current_;
+
+    mutable std::shared_mutex mutex_;
+    // deque keeps references stable as the table grows
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+// compact list of (filename, line) entries. it behaves like a vector of pairs, except
+// that elements are read-only values. only the ids are stored, names are looked up in the
+// shared SourceFileTable
+class SourceLocations {
+public:
+    using value_type = std::pair<const std::string &, uint32_t>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SourceLocations::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        const_iterator() = default;
+        const_iterator(const SourceLocations *locations, uint64_t index)
+            : locations_(locations), index_(index) {}
+        value_type operator*() const { return (*locations_)[index_]; }
+        const_iterator &operator++() {
+            index_++;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto result = *this;
+            index_++;
+            return result;
+        }
+        bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator &other) const { return index_ != other.index_; }
+        [[nodiscard]] uint64_t index() const { return index_; }
+        [[nodiscard]] const SourceLocations *locations() const { return locations_; }
+
+    private:
+        const SourceLocations *locations_ = nullptr;
+        uint64_t index_ = 0;
+    };
+
+    SourceLocations() = default;
+    SourceLocations(const std::vector<std::pair<std::string, uint32_t>> &entries);  // NOLINT
+
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+    [[nodiscard]] uint64_t size() const { return entries_.size(); }
+    value_type operator[](uint64_t index) const;
+    [[nodiscard]] value_type front() const { return (*this)[0]; }
+    [[nodiscard]] value_type back() const { return (*this)[entries_.size() - 1]; }
+    [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const { return {this, entries_.size()}; }
+    [[nodiscard]] const std::vector<std::pair<uint32_t, uint32_t>> &entries() const {
+        return entries_;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args &&...args) {
+        std::pair<std::string, uint32_t> entry(std::forward<Args>(args)...);
+        auto id = SourceFileTable::shared()->intern(entry.first);
+        entries_.emplace_back(id, entry.second);
+    }
+    void insert(const const_iterator &pos, const std::pair<std::string, uint32_t> &entry);
+    void insert(const const_iterator &pos, const const_iterator &first,
+                const const_iterator &last);
+    void clear() { entries_.clear(); }
+
+    explicit operator std::vector<std::pair<std::string, uint32_t>>() const;
+
+private:
+    std::vector<std::pair<uint32_t, uint32_t>> entries_;
+};
+
 class Attribute {
 public:
     virtual ~Attribute() = default;
@@ -41,7 +142,7 @@ public:
     [[nodiscard]] virtual IRNode *parent() const { return nullptr; }
     [[nodiscard]] IRNodeKind ir_node_kind() const { return ast_node_type_; }
 
-    std::vector<std::pair<std::string, uint32_t>> fn_name_ln;
+    SourceLocations fn_name_ln;
 
     uint32_t verilog_ln = 0;
 
@@ -122,6 +223,24 @@ protected:
     uint32_t level = 0;
 
     std::unordered_set<IRNode *> visited_;
+
+    // node visits are counted in the context of the first node visited. the parallel
+    // traversals resolve it before the workers share it
+    Context *stats_context_ = nullptr;
+    inline void resolve_stats_context([[maybe_unused]] IRNode *node) {
+#ifdef KRATOS_IR_STATS
+        if (!stats_context_) stats_context_ = node_context(node);
+#endif
+    }
+    inline void count_visit([[maybe_unused]] IRNode *node) {
+#ifdef KRATOS_IR_STATS
+        resolve_stats_context(node);
+        KRATOS_IR_COUNT(stats_context_, NodeVisits);
+#endif
+    }
+
+private:
+    static Context *node_context(IRNode *node);
 };
 
 // TODO
@@ -80,8 +80,7 @@ private:
         std::shared_ptr<SwitchStmt> switch_ =
             std::make_shared<SwitchStmt>(target->shared_from_this());
         if (target->generator()->debug) {
-            switch_->fn_name_ln = std::vector<std::pair<std::string, uint32_t>>(
-                stmt->fn_name_ln.begin(), stmt->fn_name_ln.end());
+            switch_->fn_name_ln = stmt->fn_name_ln;
             switch_->fn_name_ln.emplace_back(std::make_pair(__FILE__, __LINE__));
         }
 
@@ -211,7 +210,7 @@ public:
             compute_assign_chain(var, chain);
             if (chain.size() <= 2) continue;  // nothing to be done
 
-            std::vector<std::pair<std::string, uint32_t>> debug_info;
+            SourceLocations debug_info;
 
             for (uint64_t i = 0; i < chain.size() - 1; i++) {
                 auto& [pre, stmt] = chain[i];
@@ -289,8 +288,8 @@ public:
         }
 
         for (auto const& child : child_to_remove) {
-            if (child->is_cloned())
-                throw InternalException("Unable to optimize passthrough on cloned generator");
+            // the clone needs its own copy before we can move its wires around
+            if (child->is_cloned()) child->materialize();
             // we move the src and sinks around
             const auto& port_names = child->get_port_names();
             for (auto const& port_name : port_names) {
@@ -306,8 +305,7 @@ public:
                                                    port->is_signed());
                     if (generator->debug) {
                         // need to copy the changes over
-                        new_var.fn_name_ln = std::vector<std::pair<std::string, uint32_t>>(
-                            child->fn_name_ln.begin(), child->fn_name_ln.end());
+                        new_var.fn_name_ln = child->fn_name_ln;
                         new_var.fn_name_ln.emplace_back(__FILE__, __LINE__);
                     }
                     Var::move_src_to(port.get(), &new_var, generator, false);
@@ -1132,6 +1130,7 @@ class DeadCodeVarElimination : public IRVisitor {
 public:
     void visit(Generator* generator) override {
         bool changed = true;
+        auto const event_vars = get_event_control_vars(generator);
 
         while (changed) {
             changed = false;
@@ -1139,7 +1138,7 @@ public:
             for (auto const& var_name : var_names) {
                 auto const& var = generator->get_var(var_name);
                 if (var->type() != VarType::Base) continue;
-                if (var->sinks().empty()) {
+                if (var->sinks().empty() && event_vars.find(var.get()) == event_vars.end()) {
                     // remove all the sources
                     remove_var(var.get());
                     changed = true;
@@ -1150,11 +1149,31 @@ public:
 
         // because we run child first, the parent's content get cleared out
         // nicely before this pass runs on parent
-        clear_out_ports(generator);
+        clear_out_ports(generator, event_vars);
     }
 
 private:
-    static void clear_out_ports(Generator* generator) {
+    // port connections live in the parent, which is shared by the children running in parallel
+    std::mutex parent_mutex_;
+
+    // sequential blocks read their event controls without being a sink, e.g. the clock
+    static std::unordered_set<const Var*> get_event_control_vars(Generator* generator) {
+        std::unordered_set<const Var*> result;
+        auto stmts_count = generator->stmts_count();
+        for (uint64_t i = 0; i < stmts_count; i++) {
+            auto stmt = generator->get_stmt(i);
+            if (stmt->type() != StatementType::Block) continue;
+            auto blk = stmt->as<StmtBlock>();
+            if (blk->block_type() != StatementBlockType::Sequential) continue;
+            auto seq = blk->as<SequentialStmtBlock>();
+            for (auto const& event : seq->get_event_controls()) {
+                if (event.var) result.emplace(event.var->get_var_root_parent());
+            }
+        }
+        return result;
+    }
+
+    void clear_out_ports(Generator* generator, const std::unordered_set<const Var*>& event_vars) {
         // we don't deal with top level ports, since it changes
         // interface
         if (!generator->parent_generator()) return;
@@ -1163,7 +1182,7 @@ private:
         for (auto const& port_name : port_names) {
             auto const& p = generator->get_port(port_name);
             if (p->port_direction() == PortDirection::In) {
-                if (p->sinks().empty()) {
+                if (p->sinks().empty() && event_vars.find(p.get()) == event_vars.end()) {
                     ports_to_remove.emplace_back(port_name);
                 }
             } else if (p->port_direction() == PortDirection::Out) {
@@ -1173,6 +1192,8 @@ private:
             }
         }
 
+        if (ports_to_remove.empty()) return;
+        std::lock_guard guard(parent_mutex_);
         for (auto const& port_name : ports_to_remove) {
             // need to un-wire the parent
             auto const& port = generator->get_port(port_name);
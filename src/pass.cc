@@ -1,11 +1,13 @@
 #include "pass.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <mutex>
 #include <numeric>
+#include <queue>
 
 #include "debug.hh"
 #include "event.hh"
@@ -13,9 +15,11 @@
 #include "fmt/format.h"
 #include "fsm.hh"
 #include "generator.hh"
+#include "graph.hh"
 #include "interface.hh"
 #include "port.hh"
 #include "tb.hh"
+#include "util.hh"
 
 using fmt::format;
 using std::runtime_error;
@@ -29,6 +33,45 @@ void hash_generators(Generator* top, HashStrategy strategy) {
     hash_generators_context(top->context(), top, strategy);
 }
 
+bool is_dead_lazy_generator(Generator* generator) {
+    if (!generator->interfaces().empty()) return false;
+    bool has_output = false;
+    for (auto const& port_name : generator->get_port_names()) {
+        auto port = generator->get_port(port_name);
+        if (port->port_direction() == PortDirection::In) continue;
+        has_output = true;
+        if (!port->sinks().empty()) return false;
+    }
+    // generators without outputs are kept since they are only there for their side effects,
+    // e.g. assertions
+    return has_output;
+}
+
+void elaborate_lazy_generators(Generator* top) {
+    // the bodies are built top-down on the calling thread, since they may call back into
+    // python. lazy generators created by a body are visited as well
+    std::queue<Generator*> queue;
+    queue.emplace(top);
+    while (!queue.empty()) {
+        auto* generator = queue.front();
+        queue.pop();
+        if (generator->is_stub()) {
+            generator->set_lazy_body(nullptr);
+        } else {
+            generator->elaborate();
+        }
+        for (auto const& child : generator->get_child_generators()) {
+            if (child->is_lazy() && is_dead_lazy_generator(child.get())) {
+                // the body may hold a reference to the python object that owns the child
+                child->set_lazy_body(nullptr);
+                generator->remove_child_generator(child);
+            } else {
+                queue.emplace(child.get());
+            }
+        }
+    }
+}
+
 void uniquify_generators(Generator* top) {
     // we assume users has run the hash_generators function
     Context* context = top->context();
@@ -41,8 +84,10 @@ void uniquify_generators(Generator* top) {
             if (m->external()) continue;
             module_instances.emplace_back(m.get());
         }
+        // a module written out by stream_verilog keeps its name
+        auto streamed_hash = context->streamed_module_hash(name);
         // notice that since it is a set copied by value, it is fine to iterate through it
-        if (module_instances.size() == 1)
+        if (module_instances.size() == 1 && !streamed_hash)
             // only one module. we are good
             continue;
         // reordering based on whether it's being tracked
@@ -57,14 +102,17 @@ void uniquify_generators(Generator* top) {
                 }
             }
         }
-        std::unordered_map<uint64_t, Generator*> name_map;
+        std::unordered_map<uint64_t, std::string> name_map;
         std::unordered_set<std::string> new_names;
+        if (streamed_hash) {
+            name_map.emplace(*streamed_hash, name);
+            new_names.emplace(name);
+        }
         for (auto* const ptr : module_instances) {
             if (context->has_hash(ptr)) {
                 uint64_t hash = context->get_hash(ptr);
                 if (name_map.find(hash) == name_map.end()) {
                     // need to uniquify it
-                    name_map.emplace(hash, ptr);
                     if (new_names.empty()) {
                         // use the original name
                         new_names.emplace(ptr->name);
@@ -73,16 +121,18 @@ void uniquify_generators(Generator* top) {
                         uint32_t count = new_names.size() - 1;
                         while (true) {
                             const std::string new_name = ::format("{0}_unq{1}", name, count++);
-                            if (!context->generator_name_exists(new_name)) {
+                            if (!context->generator_name_exists(new_name) &&
+                                !context->streamed_module_hash(new_name)) {
                                 context->change_generator_name(ptr, new_name);
                                 break;
                             }
                         }
                         new_names.emplace(ptr->name);
                     }
+                    name_map.emplace(hash, ptr->name);
                 } else {
                     // re-use the old name
-                    auto old_name = name_map.at(hash)->name;
+                    auto old_name = name_map.at(hash);
                     context->change_generator_name(ptr, old_name);
                 }
             }
@@ -90,6 +140,158 @@ void uniquify_generators(Generator* top) {
     }
 }
 
+void change_var_expr(const std::shared_ptr<Expr>& expr, Var* target, Var* new_var, bool move_link);
+
+namespace {
+struct FoldCandidate {
+    Generator* generator;
+    uint64_t hash;
+    // unique constants and the assignments using them, and for every visited constant the index
+    // of its slot, since a constant can be shared by several expressions and statements
+    std::vector<Const*> slots;
+    std::vector<std::vector<AssignStmt*>> slot_stmts;
+    std::vector<uint32_t> pattern;
+};
+
+FoldCandidate get_fold_candidate(Generator* generator) {
+    FoldCandidate candidate{generator, 0, {}, {}, {}};
+    std::vector<std::pair<AssignStmt*, Const*>> constant_slots;
+    candidate.hash = hash_generator_template(generator, constant_slots);
+    std::unordered_map<Const*, uint32_t> slot_index;
+    candidate.pattern.reserve(constant_slots.size());
+    for (auto const& [stmt, constant] : constant_slots) {
+        auto iter = slot_index.find(constant);
+        if (iter == slot_index.end()) {
+            iter = slot_index.emplace(constant, candidate.slots.size()).first;
+            candidate.slots.emplace_back(constant);
+            candidate.slot_stmts.emplace_back();
+        }
+        auto& stmts = candidate.slot_stmts[iter->second];
+        if (std::find(stmts.begin(), stmts.end(), stmt) == stmts.end()) stmts.emplace_back(stmt);
+        candidate.pattern.emplace_back(iter->second);
+    }
+    return candidate;
+}
+
+bool same_template(const FoldCandidate& a, const FoldCandidate& b) {
+    if (a.hash != b.hash || a.pattern != b.pattern) return false;
+    for (uint64_t i = 0; i < a.slots.size(); i++) {
+        auto const* const_a = a.slots[i];
+        auto const* const_b = b.slots[i];
+        if (const_a->width() != const_b->width() || const_a->is_signed() != const_b->is_signed())
+            return false;
+    }
+    return true;
+}
+
+bool has_name(Generator* generator, const std::string& name) {
+    return generator->vars().find(name) != generator->vars().end() ||
+           generator->get_params().find(name) != generator->get_params().end();
+}
+
+void replace_constant(AssignStmt* stmt, Const* constant, Param* param) {
+    if (stmt->right() == constant) {
+        stmt->set_right(param->shared_from_this());
+    } else {
+        change_var_expr(stmt->right()->as<Expr>(), constant, param, false);
+    }
+}
+
+void fold_family(Context* context, const std::vector<FoldCandidate>& family) {
+    auto const& first = family.front();
+    // only the constants that are not the same across the family become parameters
+    std::vector<uint64_t> folded_slots;
+    for (uint64_t i = 0; i < first.slots.size(); i++) {
+        auto value = first.slots[i]->value();
+        for (auto const& candidate : family) {
+            if (candidate.slots[i]->value() != value) {
+                folded_slots.emplace_back(i);
+                break;
+            }
+        }
+    }
+    if (folded_slots.empty()) return;
+
+    uint32_t count = 0;
+    auto const first_hash = context->get_hash(first.generator);
+    for (auto const slot : folded_slots) {
+        std::string param_name;
+        bool used;
+        do {
+            param_name = ::format("CONST_{0}", count++);
+            used = false;
+            for (auto const& candidate : family) {
+                used = has_name(candidate.generator, param_name);
+                if (used) break;
+            }
+        } while (used);
+
+        auto const default_value = first.slots[slot]->value();
+        for (auto const& candidate : family) {
+            auto* constant = candidate.slots[slot];
+            auto value = constant->value();
+            auto& param = candidate.generator->parameter(param_name, constant->width(),
+                                                         constant->is_signed());
+            param.set_initial_value(default_value);
+            param.set_value(value);
+            for (auto* stmt : candidate.slot_stmts[slot]) replace_constant(stmt, constant, &param);
+            // clones are instantiated with the values of their definition
+            for (auto const& clone : candidate.generator->get_clones()) {
+                auto& p = clone->parameter(param_name, constant->width(), constant->is_signed());
+                p.set_initial_value(default_value);
+                p.set_value(value);
+            }
+        }
+    }
+    // the family is one module from now on
+    for (auto const& candidate : family) {
+        context->remove_hash(candidate.generator);
+        context->add_hash(candidate.generator, first_hash);
+    }
+}
+}  // namespace
+
+void fold_generator_parameters(Generator* top) {
+    // we assume users has run the hash_generators function
+    Context* context = top->context();
+    // children first, so that the parents see the folded hashes
+    GeneratorGraph graph(top);
+    std::vector<std::string> names;
+    std::unordered_set<std::string> visited;
+    for (auto* generator : graph.get_sorted_nodes()) {
+        if (visited.emplace(generator->name).second) names.emplace_back(generator->name);
+    }
+
+    for (auto const& name : names) {
+        // modules written out already can't change
+        if (context->streamed_module_hash(name)) continue;
+        std::vector<Generator*> module_instances;
+        bool tracked = false;
+        for (auto const& m : context->get_generators_by_name(name)) {
+            if (m->external() || !context->has_hash(m.get())) continue;
+            tracked = tracked || context->is_generated_tracked(m.get());
+            module_instances.emplace_back(m.get());
+        }
+        if (tracked || module_instances.size() < 2) continue;
+
+        std::vector<std::vector<FoldCandidate>> families;
+        for (auto* generator : module_instances) {
+            auto candidate = get_fold_candidate(generator);
+            auto iter = std::find_if(families.begin(), families.end(), [&](auto const& family) {
+                return same_template(family.front(), candidate);
+            });
+            if (iter == families.end()) {
+                families.emplace_back(std::vector<FoldCandidate>{std::move(candidate)});
+            } else {
+                iter->emplace_back(std::move(candidate));
+            }
+        }
+        for (auto const& family : families) {
+            if (family.size() > 1) fold_family(context, family);
+        }
+    }
+}
+
 void PassManager::register_pass(const std::string& name, std::function<void(Generator*)> fn) {
     if (has_pass(name))
         throw UserException(::format("{0} already exists in the pass manager", name));
@@ -109,9 +311,17 @@ void PassManager::add_pass(const std::string& name) {
     passes_order_.emplace_back(name);
 }
 
+std::vector<std::string> PassManager::registered_passes() const {
+    std::vector<std::string> result;
+    result.reserve(passes_.size());
+    for (auto const& iter : passes_) result.emplace_back(iter.first);
+    return result;
+}
+
 void PassManager::run_passes(Generator* generator) {
     // compute padding
     int string_size = 0;
+    perf_results_.clear();
     if (collect_perf_) {
         for (auto const& fn_name : passes_order_) {
             auto s = static_cast<int>(fn_name.size());
@@ -119,24 +329,122 @@ void PassManager::run_passes(Generator* generator) {
                 string_size = s;
             }
         }
+        perf_results_.reserve(passes_order_.size());
     }
 
     for (const auto& fn_name : passes_order_) {
-        auto fn = passes_.at(fn_name);
+        auto const& fn = passes_.at(fn_name);
+        PassPerf perf;
+        if (collect_perf_) {
+            perf.name = fn_name;
+            perf.rss_before = mem::current_rss();
+            if (reset_peak_rss_) mem::reset_peak_rss();
+            perf.allocations = mem::allocation_count();
+            perf.allocated_bytes = mem::allocated_bytes();
+        }
+        auto *context = generator->context();
+        uint64_t visits = 0;
+        if (Context::ir_stats_enabled() && context) {
+            visits = context->ir_counter(IRCounter::NodeVisits);
+        }
         auto start = std::chrono::system_clock::now();
         fn(generator);
+        if (Context::ir_stats_enabled() && context) {
+            context->add_pass_visits(fn_name, context->ir_counter(IRCounter::NodeVisits) - visits);
+        }
 
         if (collect_perf_) {
             auto end = std::chrono::system_clock::now();
-            auto diff = end - start;
-            auto time = std::chrono::duration_cast<std::chrono::milliseconds>(diff).count();
-            std::cout << "[name]: " << std::left << std::setw(string_size) << fn_name
-                      << "\t[time]: " << time << " ms" << std::endl;
+            perf.time = std::chrono::duration<double, std::milli>(end - start).count();
+            perf.allocations = mem::allocation_count() - perf.allocations;
+            perf.allocated_bytes = mem::allocated_bytes() - perf.allocated_bytes;
+            perf.rss_after = mem::current_rss();
+            perf.peak_rss = std::max(mem::peak_rss(), perf.rss_after);
+
+            if (print_perf_) {
+                constexpr double mb = 1024 * 1024;
+                std::cout << "[name]: " << std::left << std::setw(string_size) << fn_name
+                          << "\t[time]: " << static_cast<int64_t>(perf.time) << " ms"
+                          << std::fixed << std::setprecision(1)
+                          << "\t[rss]: " << perf.rss_before / mb << " -> " << perf.rss_after / mb
+                          << " MB\t[peak]: " << perf.peak_rss / mb << " MB";
+                if (mem::allocation_counting()) {
+                    std::cout << "\t[alloc]: " << perf.allocations << " ("
+                              << perf.allocated_bytes / mb << " MB)";
+                }
+                std::cout << std::defaultfloat << std::endl;
+            }
+            perf_results_.emplace_back(std::move(perf));
         }
     }
 }
 
+std::vector<std::string> default_pass_pipeline(const DefaultPassOptions& options) {
+    std::vector<std::string> result;
+    auto add = [&](const char* name, bool enabled = true) {
+        if (enabled) result.emplace_back(name);
+    };
+    // lazy generators have to be built before any pass looks at them
+    add("elaborate_lazy_generators");
+    add("remove_assertion", options.remove_assertion);
+    add("realize_fsm");
+    add("ssa_transform_fix", options.ssa_transform);
+    add("remove_pass_through_modules", options.optimize_passthrough);
+    add("merge_if_block", options.optimize_if);
+    add("transform_if_to_case", options.optimize_if);
+    // we run the dead code elimination early on
+    add("dead_code_elimination", options.dead_code_elimination);
+    // fsm elaboration has to happen before unused vars removal
+    add("zero_out_stubs");
+    add("remove_fanout_one_wires", options.optimize_fanout);
+    add("zero_generator_inputs");
+    add("change_port_bundle_struct", options.optimize_bundle);
+    add("verify_generator_connectivity");
+    add("merge_const_port_assignment", options.merge_const_port_assignment);
+    add("decouple_generator_ports");
+    add("fix_assignment_type");
+    // debug info refers to the unused variables as well
+    add("remove_unused_vars", options.remove_unused && !options.insert_debug_info);
+    add("remove_unused_stmts", options.remove_unused && !options.insert_debug_info);
+    add("verify_assignments");
+    add("check_combinational_loop", options.check_combinational_loop);
+    add("check_mixed_assignment");
+    add("check_always_sensitivity");
+    add("check_inferred_latch", options.check_inferred_latch);
+    add("check_active_high", options.check_active_high);
+    add("check_function_return");
+    add("merge_wire_assignments");
+    add("check_multiple_driver", options.check_multiple_driver);
+    add("check_flip_flop_always_ff", options.check_flip_flop_always_ff);
+    // insert debug break points if needed
+    add("propagate_scope_variable", options.insert_debug_info);
+    add("inject_assertion_fail", options.insert_debug_info);
+    add(options.use_parallel ? "hash_generators_parallel" : "hash_generators_sequential");
+    add("inline_instance");
+    add("change_property_into_stmt");
+    add("infer_property_clocking");
+    // generators that only differ in constants share one parametrized module
+    add("fold_generator_parameters", options.fold_parameters);
+    add("uniquify_generators");
+    add("create_module_instantiation");
+    add("create_interface_instantiation");
+    // genvar instance lifting only happens after the module hash
+    add("lift_genvar_instances", options.lift_genvar_instances);
+    add("insert_pipeline_stages", options.insert_pipeline_stages);
+    add("sort_initial_stmts", options.sort_initial_stmts);
+    add("sort_stmts", options.reorder_stmts);
+    // legality fix at the very end
+    add("port_legality_fix", options.fix_port_legality);
+    return result;
+}
+
+void PassManager::add_default_passes(const DefaultPassOptions& options) {
+    for (auto const& name : default_pass_pipeline(options)) add_pass(name);
+}
+
 void PassManager::register_builtin_passes() {
+    register_pass("elaborate_lazy_generators", &elaborate_lazy_generators);
+
     register_pass("remove_pass_through_modules", &remove_pass_through_modules);
 
     register_pass("transform_if_to_case", &transform_if_to_case);
@@ -207,6 +515,8 @@ void PassManager::register_builtin_passes() {
     register_pass("hash_generators_parallel", &hash_generators_parallel);
     register_pass("hash_generators_sequential", &hash_generators_sequential);
 
+    register_pass("fold_generator_parameters", &fold_generator_parameters);
+
     register_pass("uniquify_generators", &uniquify_generators);
 
     register_pass("create_module_instantiation", &create_module_instantiation);
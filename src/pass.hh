@@ -47,6 +47,15 @@ void decouple_generator_ports(Generator* top);
 
 void uniquify_generators(Generator* top);
 
+// same-name generators that only differ in the constants they assign become one module. these
+// constants are turned into parameters and the instances override them. runs between
+// hash_generators and uniquify_generators
+void fold_generator_parameters(Generator* top);
+
+// builds the bodies of lazy generators that are reachable from the top. lazy children whose
+// outputs don't drive anything are removed without being built, and stubs are never built
+void elaborate_lazy_generators(Generator* top);
+
 void check_function_return(Generator* top);
 
 void check_inferred_latch(Generator *top);
@@ -128,6 +137,53 @@ void infer_property_clocking(Generator *top);
 
 void inline_instance(Generator *top);
 
+// statistics of a single pass run, collected when collect_perf is set and printed to stdout
+// unless print_perf is turned off.
+// memory is in bytes. allocations are only counted when kratos is built with
+// KRATOS_COUNT_ALLOCATIONS
+struct PassPerf {
+    std::string name;
+    double time = 0;  // ms
+    uint64_t rss_before = 0;
+    uint64_t rss_after = 0;
+    // high-water mark during the pass if reset_peak_rss is set and the platform allows
+    // resetting it, otherwise the peak of the process so far
+    uint64_t peak_rss = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+};
+
+// switches of the default pipeline, which is what kratos.verilog() runs. the defaults are the
+// same as its arguments
+struct DefaultPassOptions {
+    bool remove_assertion = false;
+    bool ssa_transform = false;
+    bool optimize_passthrough = true;
+    bool optimize_if = true;
+    bool dead_code_elimination = false;
+    bool optimize_fanout = true;
+    bool optimize_bundle = true;
+    bool merge_const_port_assignment = true;
+    bool remove_unused = true;
+    bool check_combinational_loop = true;
+    bool check_inferred_latch = true;
+    bool check_active_high = true;
+    bool check_multiple_driver = true;
+    bool check_flip_flop_always_ff = true;
+    bool insert_debug_info = false;
+    bool use_parallel = true;
+    bool fold_parameters = false;
+    bool lift_genvar_instances = false;
+    bool insert_pipeline_stages = false;
+    // test benches need their initial blocks sorted
+    bool sort_initial_stmts = false;
+    bool reorder_stmts = false;
+    bool fix_port_legality = false;
+};
+
+// names of the builtin passes in the default pipeline, in the order they run
+std::vector<std::string> default_pass_pipeline(const DefaultPassOptions& options);
+
 class PassManager {
 public:
     PassManager() = default;
@@ -141,17 +197,31 @@ public:
     }
 
     void register_builtin_passes();
+    // adds the default pipeline. the builtin passes have to be registered
+    void add_default_passes(const DefaultPassOptions& options);
 
     void run_passes(Generator* generator);
 
     [[nodiscard]] uint64_t num_passes() const { return passes_order_.size(); }
+    [[nodiscard]] std::vector<std::string> registered_passes() const;
     inline void set_collect_perf(bool value) { collect_perf_ = value; }
     [[nodiscard]] bool get_collect_perf() const { return collect_perf_; }
+    inline void set_print_perf(bool value) { print_perf_ = value; }
+    [[nodiscard]] bool get_print_perf() const { return print_perf_; }
+    // reset the process' memory high-water mark before every pass to get per-pass peaks. off by
+    // default since it discards the peak of the whole process
+    inline void set_reset_peak_rss(bool value) { reset_peak_rss_ = value; }
+    [[nodiscard]] bool get_reset_peak_rss() const { return reset_peak_rss_; }
+    // results of the last run_passes call
+    [[nodiscard]] const std::vector<PassPerf>& perf_results() const { return perf_results_; }
 
 private:
     std::map<std::string, std::function<void(Generator*)>> passes_;
     std::vector<std::string> passes_order_;
     bool collect_perf_ = false;
+    bool print_perf_ = true;
+    bool reset_peak_rss_ = false;
+    std::vector<PassPerf> perf_results_;
 };
 
 }  // namespace kratos
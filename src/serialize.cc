@@ -0,0 +1,1526 @@
+#include "serialize.hh"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "except.hh"
+#include "fmt/format.h"
+#include "generator.hh"
+#include "interface.hh"
+#include "stmt.hh"
+#include "util.hh"
+
+using fmt::format;
+
+namespace kratos {
+
+namespace {
+
+constexpr char IR_MAGIC[8] = {'K', 'R', 'A', 'T', 'O', 'S', 'I', 'R'};
+// written as a native integer to reject files from hosts with a different byte order
+constexpr uint32_t IR_BYTE_ORDER = 0x01020304;
+constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+
+enum class Table : uint32_t {
+    Strings,
+    StringData,
+    Indices,
+    Locations,
+    Attributes,
+    Frames,
+    FrameVars,
+    Enums,
+    EnumValues,
+    InterfaceDefs,
+    InterfaceFields,
+    InterfaceRefs,
+    Generators,
+    Children,
+    Vars,
+    Stmts,
+    Count
+};
+constexpr auto TABLE_COUNT = static_cast<uint32_t>(Table::Count);
+
+// every record only has fixed-width fields. variable-length data lives in other tables and is
+// referred to by a range
+struct Range {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+struct TableEntry {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t table_count;
+    uint32_t top;
+    TableEntry tables[TABLE_COUNT];
+};
+
+struct StringRecord {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct LocationRecord {
+    uint32_t filename;
+    uint32_t line;
+};
+
+struct AttributeRecord {
+    uint32_t type;
+    uint32_t value;
+};
+
+struct NodeMeta {
+    Range locations;
+    Range attributes;
+    uint32_t comment;
+};
+
+struct FrameRecord {
+    uint32_t parent;
+    Range vars;
+};
+
+struct FrameVarRecord {
+    uint32_t name;
+    uint32_t value;
+    uint32_t is_var;
+};
+
+enum EnumFlag : uint32_t { EnumExternal = 1u << 0u, EnumLocal = 1u << 1u };
+
+struct EnumRecord {
+    uint32_t name;
+    uint32_t width;
+    // owner generator, or NO_INDEX if the enum belongs to the context
+    uint32_t generator;
+    uint32_t flags;
+    Range values;
+};
+
+struct EnumValueRecord {
+    uint32_t name;
+    uint32_t padding;
+    uint64_t value;
+};
+
+enum class InterfaceFieldKind : uint32_t { Port, Var, Input, Output };
+
+struct InterfaceDefRecord {
+    uint32_t name;
+    // definition this modport belongs to, or NO_INDEX for interface definitions
+    uint32_t parent;
+    Range fields;
+};
+
+struct InterfaceFieldRecord {
+    uint32_t name;
+    InterfaceFieldKind kind;
+    uint32_t width;
+    uint32_t direction;
+    uint32_t port_type;
+    Range size;
+};
+
+struct InterfaceRefRecord {
+    uint32_t name;
+    uint32_t definition;
+    uint32_t is_port;
+};
+
+enum GeneratorFlag : uint32_t {
+    GeneratorDebug = 1u << 0u,
+    GeneratorStub = 1u << 1u,
+    GeneratorExternal = 1u << 2u,
+    GeneratorCloned = 1u << 3u
+};
+
+struct GeneratorRecord {
+    uint32_t name;
+    uint32_t instance_name;
+    uint32_t flags;
+    // definition of a clone
+    uint32_t def;
+    Range children;
+    Range vars;
+    Range params;
+    Range stmts;
+    Range enums;
+    Range interfaces;
+    // string ids in the index table
+    Range imports;
+    NodeMeta meta;
+};
+
+struct ChildRecord {
+    uint32_t generator;
+    uint32_t instance_name;
+    uint32_t debug_file;
+    uint32_t debug_line;
+    uint32_t comment;
+};
+
+enum class VarKind : uint32_t {
+    // declared in the generator
+    Var,
+    Port,
+    Param,
+    // looked up by name, e.g. interface members and clone ports
+    Member,
+    Const,
+    EnumConst,
+    Slice,
+    VarSlice,
+    Cast,
+    Expr,
+    Concat,
+    Extend,
+    Conditional,
+    Iter
+};
+
+enum VarFlag : uint32_t {
+    VarSigned = 1u << 0u,
+    VarExplicitArray = 1u << 1u,
+    VarPacked = 1u << 2u,
+    VarHasActiveHigh = 1u << 3u,
+    VarActiveHigh = 1u << 4u,
+    ParamHasValue = 1u << 5u,
+    ParamHasInitialValue = 1u << 6u
+};
+
+struct VarRecord {
+    VarKind kind;
+    uint32_t generator;
+    uint32_t name;
+    uint32_t width;
+    uint32_t flags;
+    // op, cast type, port direction or param type
+    uint32_t op;
+    // operands, slice bounds, port type, enum or parent param depending on the kind
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    // before/after strings for vars, raw string values for params
+    uint32_t str_a;
+    uint32_t str_b;
+    uint32_t padding;
+    int64_t value;
+    int64_t initial_value;
+    Range size;
+    Range operands;
+    // (dimension, var) pairs in the index table
+    Range size_params;
+    NodeMeta meta;
+};
+
+enum class StmtKind : uint32_t { Assign, If, Switch, For, Block, Comment, RawString, Break };
+
+struct StmtRecord {
+    StmtKind kind;
+    // assignment type or block type
+    uint32_t type;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t frame;
+    int64_t start;
+    int64_t end;
+    int64_t step;
+    Range children;
+    Range extra;
+    NodeMeta meta;
+};
+
+template <typename T>
+constexpr Table table_of();
+#define KRATOS_IR_TABLE(T, TABLE) \
+    template <>                   \
+    constexpr Table table_of<T>() { return Table::TABLE; }
+KRATOS_IR_TABLE(StringRecord, Strings)
+KRATOS_IR_TABLE(char, StringData)
+KRATOS_IR_TABLE(uint32_t, Indices)
+KRATOS_IR_TABLE(LocationRecord, Locations)
+KRATOS_IR_TABLE(AttributeRecord, Attributes)
+KRATOS_IR_TABLE(FrameRecord, Frames)
+KRATOS_IR_TABLE(FrameVarRecord, FrameVars)
+KRATOS_IR_TABLE(EnumRecord, Enums)
+KRATOS_IR_TABLE(EnumValueRecord, EnumValues)
+KRATOS_IR_TABLE(InterfaceDefRecord, InterfaceDefs)
+KRATOS_IR_TABLE(InterfaceFieldRecord, InterfaceFields)
+KRATOS_IR_TABLE(InterfaceRefRecord, InterfaceRefs)
+KRATOS_IR_TABLE(GeneratorRecord, Generators)
+KRATOS_IR_TABLE(ChildRecord, Children)
+KRATOS_IR_TABLE(VarRecord, Vars)
+KRATOS_IR_TABLE(StmtRecord, Stmts)
+#undef KRATOS_IR_TABLE
+
+uint64_t align(uint64_t offset) { return (offset + 7u) & ~uint64_t(7u); }
+
+class IRWriter {
+public:
+    explicit IRWriter(Generator *top) : top_(top) {}
+
+    std::string write() {
+        collect_generators(top_);
+        for (uint64_t i = 0; i < generators_.size(); i++) {
+            for (auto const &iter : generators_[i]->get_enums())
+                enum_owners_.emplace(iter.second.get(), i);
+        }
+        generator_records_.resize(generators_.size());
+        for (uint64_t i = 0; i < generators_.size(); i++) {
+            generator_records_[i] = generator(generators_[i]);
+        }
+        return dump();
+    }
+
+private:
+    Generator *top_;
+    std::vector<Generator *> generators_;
+    std::unordered_map<const Generator *, uint32_t> generator_index_;
+    std::unordered_map<const Var *, uint32_t> var_index_;
+    std::unordered_map<const IterVar *, uint32_t> iter_stmts_;
+    std::unordered_map<const ScopeContext *, uint32_t> frame_index_;
+    std::unordered_map<const Enum *, uint32_t> enum_index_;
+    std::unordered_map<const Enum *, uint32_t> enum_owners_;
+    std::unordered_map<const IDefinition *, uint32_t> idef_index_;
+    std::unordered_map<std::string, uint32_t> string_index_;
+
+    std::vector<StringRecord> strings_;
+    std::vector<char> string_data_;
+    std::vector<uint32_t> indices_;
+    std::vector<LocationRecord> locations_;
+    std::vector<AttributeRecord> attributes_;
+    std::vector<FrameRecord> frames_;
+    std::vector<FrameVarRecord> frame_vars_;
+    std::vector<EnumRecord> enums_;
+    std::vector<EnumValueRecord> enum_values_;
+    std::vector<InterfaceDefRecord> idefs_;
+    std::vector<InterfaceFieldRecord> ifields_;
+    std::vector<InterfaceRefRecord> irefs_;
+    std::vector<GeneratorRecord> generator_records_;
+    std::vector<ChildRecord> children_;
+    std::vector<VarRecord> vars_;
+    std::vector<StmtRecord> stmts_;
+
+    void collect_generators(Generator *gen) {
+        if (generator_index_.find(gen) != generator_index_.end()) return;
+        generator_index_.emplace(gen, generators_.size());
+        generators_.emplace_back(gen);
+        if (gen->is_cloned()) {
+            if (!gen->def_instance())
+                throw GeneratorException(
+                    ::format("Unable to serialize {0}: clone has no definition", gen->name),
+                    {gen});
+            collect_generators(gen->def_instance());
+            return;
+        }
+        if (gen->is_lazy())
+            throw GeneratorException(
+                ::format("Unable to serialize {0}: generator has not been elaborated", gen->name),
+                {gen});
+        if (!gen->functions().empty() || !gen->fsms().empty() || !gen->properties().empty() ||
+            !gen->port_bundle_mapping().empty()) {
+            throw GeneratorException(
+                ::format("Unable to serialize {0}: functions, FSMs, properties and port bundles "
+                         "are not supported",
+                         gen->name),
+                {gen});
+        }
+        for (auto const &child : gen->get_child_generators()) collect_generators(child.get());
+    }
+
+    uint32_t generator_index(const Generator *gen) const {
+        auto pos = generator_index_.find(gen);
+        if (pos == generator_index_.end())
+            throw GeneratorException(
+                ::format("{0} is outside of the serialized hierarchy", gen->name),
+                {const_cast<Generator *>(gen)});
+        return pos->second;
+    }
+
+    uint32_t string(const std::string &value) {
+        auto pos = string_index_.find(value);
+        if (pos != string_index_.end()) return pos->second;
+        auto index = static_cast<uint32_t>(strings_.size());
+        strings_.emplace_back(StringRecord{string_data_.size(), value.size()});
+        string_data_.insert(string_data_.end(), value.begin(), value.end());
+        string_index_.emplace(value, index);
+        return index;
+    }
+
+    Range indices(const std::vector<uint32_t> &values) {
+        Range range{static_cast<uint32_t>(indices_.size()), static_cast<uint32_t>(values.size())};
+        indices_.insert(indices_.end(), values.begin(), values.end());
+        return range;
+    }
+
+    NodeMeta meta(const IRNode *node) {
+        NodeMeta result{};
+        result.locations.first = static_cast<uint32_t>(locations_.size());
+        for (auto const &[filename, line] : node->fn_name_ln) {
+            locations_.emplace_back(LocationRecord{string(filename), line});
+        }
+        result.locations.count = static_cast<uint32_t>(node->fn_name_ln.size());
+        result.attributes.first = static_cast<uint32_t>(attributes_.size());
+        for (auto const &attr : node->get_attributes()) {
+            attributes_.emplace_back(AttributeRecord{string(attr->type_str), string(attr->value_str)});
+        }
+        result.attributes.count = static_cast<uint32_t>(node->get_attributes().size());
+        result.comment = node->comment.empty() ? NO_INDEX : string(node->comment);
+        return result;
+    }
+
+    uint32_t frame(const ScopeContext::Frame &frame_) {
+        if (!frame_) return NO_INDEX;
+        auto pos = frame_index_.find(frame_.get());
+        if (pos != frame_index_.end()) return pos->second;
+        FrameRecord record{};
+        record.parent = frame(frame_->parent());
+        record.vars.first = static_cast<uint32_t>(frame_vars_.size());
+        for (auto const &[name, entry] : frame_->variables()) {
+            frame_vars_.emplace_back(
+                FrameVarRecord{string(name), string(entry.second), entry.first ? 1u : 0u});
+        }
+        record.vars.count = static_cast<uint32_t>(frame_->variables().size());
+        auto index = static_cast<uint32_t>(frames_.size());
+        frames_.emplace_back(record);
+        frame_index_.emplace(frame_.get(), index);
+        return index;
+    }
+
+    uint32_t enum_(const Enum *enum_def) {
+        auto pos = enum_index_.find(enum_def);
+        if (pos != enum_index_.end()) return pos->second;
+        EnumRecord record{};
+        record.name = string(enum_def->name);
+        record.width = enum_def->width();
+        auto owner = enum_owners_.find(enum_def);
+        record.generator = owner == enum_owners_.end() ? NO_INDEX : owner->second;
+        record.flags = (enum_def->external ? EnumExternal : 0u) |
+                       (enum_def->local() ? EnumLocal : 0u);
+        record.values.first = static_cast<uint32_t>(enum_values_.size());
+        for (auto const &[name, value] : enum_def->values) {
+            enum_values_.emplace_back(
+                EnumValueRecord{string(name), 0, static_cast<uint64_t>(value->value())});
+        }
+        record.values.count = static_cast<uint32_t>(enum_def->values.size());
+        auto index = static_cast<uint32_t>(enums_.size());
+        enums_.emplace_back(record);
+        enum_index_.emplace(enum_def, index);
+        return index;
+    }
+
+    uint32_t interface_field(const std::string &name, InterfaceFieldKind kind, uint32_t width,
+                             const std::vector<uint32_t> &size, uint32_t direction,
+                             uint32_t port_type) {
+        InterfaceFieldRecord record{};
+        record.name = string(name);
+        record.kind = kind;
+        record.width = width;
+        record.direction = direction;
+        record.port_type = port_type;
+        record.size = indices(size);
+        ifields_.emplace_back(record);
+        return static_cast<uint32_t>(ifields_.size() - 1);
+    }
+
+    uint32_t interface_def(const IDefinition *def) {
+        if (def->is_modport()) {
+            // modports are written together with their definition
+            interface_def(reinterpret_cast<const InterfaceModPortDefinition *>(def)->def());
+            return idef_index_.at(def);
+        }
+        auto pos = idef_index_.find(def);
+        if (pos != idef_index_.end()) return pos->second;
+        auto const *interface = reinterpret_cast<const InterfaceDefinition *>(def);
+        InterfaceDefRecord record{};
+        record.name = string(interface->name());
+        record.parent = NO_INDEX;
+        auto first = static_cast<uint32_t>(ifields_.size());
+        for (auto const &name : interface->ports()) {
+            auto const &[width, size, dir, type] = interface->port(name);
+            interface_field(name, InterfaceFieldKind::Port, width, size,
+                            static_cast<uint32_t>(dir), static_cast<uint32_t>(type));
+        }
+        for (auto const &name : interface->vars()) {
+            auto const &[width, size] = interface->var(name);
+            interface_field(name, InterfaceFieldKind::Var, width, size, 0, 0);
+        }
+        record.fields = {first, static_cast<uint32_t>(ifields_.size()) - first};
+        auto index = static_cast<uint32_t>(idefs_.size());
+        idefs_.emplace_back(record);
+        idef_index_.emplace(def, index);
+
+        for (auto const &[modport_name, modport] : interface->mod_ports()) {
+            InterfaceDefRecord modport_record{};
+            modport_record.name = string(modport_name);
+            modport_record.parent = index;
+            first = static_cast<uint32_t>(ifields_.size());
+            for (auto const &name : modport->inputs())
+                interface_field(name, InterfaceFieldKind::Input, 0, {}, 0, 0);
+            for (auto const &name : modport->outputs())
+                interface_field(name, InterfaceFieldKind::Output, 0, {}, 0, 0);
+            modport_record.fields = {first, static_cast<uint32_t>(ifields_.size()) - first};
+            idef_index_.emplace(modport.get(), static_cast<uint32_t>(idefs_.size()));
+            idefs_.emplace_back(modport_record);
+        }
+        return index;
+    }
+
+    uint32_t add_var(const VarRecord &record) {
+        auto index = static_cast<uint32_t>(vars_.size());
+        vars_.emplace_back(record);
+        return index;
+    }
+
+    uint32_t var(Var *var_) {
+        auto pos = var_index_.find(var_);
+        if (pos != var_index_.end()) return pos->second;
+        auto index = add_var(var_record(var_));
+        var_index_.emplace(var_, index);
+        return index;
+    }
+
+    VarRecord declared_var(Var *var_, VarKind kind) {
+        VarRecord record{};
+        record.kind = kind;
+        record.generator = generator_index(var_->generator());
+        record.name = string(var_->name);
+        record.width = var_->var_width();
+        record.flags = (var_->is_signed() ? VarSigned : 0u) |
+                       (var_->explicit_array() ? VarExplicitArray : 0u) |
+                       (var_->is_packed() ? VarPacked : 0u);
+        record.size = indices(var_->size());
+        record.c = NO_INDEX;
+        if (var_->is_enum()) {
+            record.c = enum_(dynamic_cast<EnumType *>(var_)->enum_type());
+        }
+        record.str_a = string(var_->before_var_str());
+        record.str_b = string(var_->after_var_str());
+        record.a = var_->width_param() ? var(var_->width_param()) : NO_INDEX;
+        std::vector<uint32_t> size_params;
+        for (uint32_t i = 0; i < var_->size().size(); i++) {
+            auto *param = var_->get_size_param(i);
+            if (!param) continue;
+            size_params.emplace_back(i);
+            size_params.emplace_back(var(param));
+        }
+        record.size_params = indices(size_params);
+        record.meta = meta(var_);
+        return record;
+    }
+
+    VarRecord var_record(Var *var_) {
+        auto unsupported = [var_]() {
+            return VarException(
+                ::format("Unable to serialize {0}: unsupported variable", var_->to_string()),
+                {var_});
+        };
+        VarRecord record{};
+        record.generator = NO_INDEX;
+        record.a = record.b = record.c = NO_INDEX;
+        record.str_a = record.str_b = NO_INDEX;
+        record.meta.comment = NO_INDEX;
+        switch (var_->type()) {
+            case VarType::Base:
+            case VarType::PortIO: {
+                if (var_->is_struct() || var_->is_function()) throw unsupported();
+                auto *gen = var_->generator();
+                if (var_->is_interface() || gen->is_cloned()) {
+                    record.kind = VarKind::Member;
+                    record.generator = generator_index(gen);
+                    record.name = string(member_name(gen, var_));
+                    return record;
+                }
+                if (var_->type() == VarType::Base) return declared_var(var_, VarKind::Var);
+                auto *port = reinterpret_cast<Port *>(var_);
+                record = declared_var(var_, VarKind::Port);
+                record.op = static_cast<uint32_t>(port->port_direction());
+                record.b = static_cast<uint32_t>(port->port_type());
+                if (port->active_high()) {
+                    record.flags |= VarHasActiveHigh | (*port->active_high() ? VarActiveHigh : 0u);
+                }
+                return record;
+            }
+            case VarType::Parameter: {
+                auto *param = reinterpret_cast<Param *>(var_);
+                record.kind = VarKind::Param;
+                record.generator = generator_index(param->generator());
+                record.name = string(param->parameter_name());
+                record.width = param->width();
+                record.op = static_cast<uint32_t>(param->param_type());
+                record.value = param->value();
+                record.flags = (param->is_signed() ? VarSigned : 0u) |
+                               (param->has_value() ? ParamHasValue : 0u);
+                if (auto initial = param->get_initial_value()) {
+                    record.flags |= ParamHasInitialValue;
+                    record.initial_value = *initial;
+                }
+                if (auto raw = param->get_raw_str_value()) record.str_a = string(*raw);
+                if (auto raw = param->get_raw_str_initial_value()) record.str_b = string(*raw);
+                if (param->enum_def()) record.c = enum_(param->enum_def());
+                if (param->parent_param()) record.a = var(const_cast<Param *>(param->parent_param()));
+                record.meta = meta(param);
+                return record;
+            }
+            case VarType::ConstValue: {
+                if (var_->is_enum()) {
+                    auto *enum_const = reinterpret_cast<EnumConst *>(var_);
+                    record.kind = VarKind::EnumConst;
+                    record.c = enum_(enum_const->enum_def());
+                    record.name = string(enum_const->to_string());
+                    return record;
+                }
+                auto *const_ = reinterpret_cast<Const *>(var_);
+                if (const_->is_bignum() || dynamic_cast<StringConst *>(var_) ||
+                    dynamic_cast<GeneratorConst *>(var_))
+                    throw unsupported();
+                record.kind = VarKind::Const;
+                record.value = const_->value();
+                record.width = const_->width();
+                record.flags = const_->is_signed() ? VarSigned : 0u;
+                return record;
+            }
+            case VarType::Slice: {
+                auto *slice = reinterpret_cast<VarSlice *>(var_);
+                if (slice->is_struct()) throw unsupported();
+                record.a = var(slice->parent_var);
+                if (slice->sliced_by_var()) {
+                    record.kind = VarKind::VarSlice;
+                    record.b = var(reinterpret_cast<VarVarSlice *>(slice)->sliced_var());
+                } else {
+                    record.kind = VarKind::Slice;
+                    record.b = slice->high;
+                    record.c = slice->low;
+                }
+                break;
+            }
+            case VarType::BaseCasted: {
+                auto *casted = reinterpret_cast<VarCasted *>(var_);
+                record.kind = VarKind::Cast;
+                record.a = var(casted->parent_var());
+                record.op = static_cast<uint32_t>(casted->cast_type());
+                record.width = casted->var_width();
+                if (casted->cast_type() == VarCastType::Enum) {
+                    if (!casted->enum_type()) throw unsupported();
+                    record.c = enum_(casted->enum_type());
+                }
+                break;
+            }
+            case VarType::Expression: {
+                auto *expr = reinterpret_cast<Expr *>(var_);
+                switch (expr->op) {
+                    case ExprOp::Concat: {
+                        record.kind = VarKind::Concat;
+                        std::vector<uint32_t> operands;
+                        for (auto *v : reinterpret_cast<VarConcat *>(expr)->vars())
+                            operands.emplace_back(var(v));
+                        record.operands = indices(operands);
+                        break;
+                    }
+                    case ExprOp::Extend: {
+                        record.kind = VarKind::Extend;
+                        record.a = var(reinterpret_cast<VarExtend *>(expr)->parent_var());
+                        record.width = expr->width();
+                        break;
+                    }
+                    case ExprOp::Conditional: {
+                        record.kind = VarKind::Conditional;
+                        record.a = var(reinterpret_cast<ConditionalExpr *>(expr)->condition);
+                        record.b = var(expr->left);
+                        record.c = var(expr->right);
+                        break;
+                    }
+                    default: {
+                        if (!expr->left) throw unsupported();
+                        record.kind = VarKind::Expr;
+                        record.op = static_cast<uint32_t>(expr->op);
+                        record.a = var(expr->left);
+                        record.b = expr->right ? var(expr->right) : NO_INDEX;
+                    }
+                }
+                break;
+            }
+            case VarType::Iter: {
+                auto *iter = reinterpret_cast<IterVar *>(var_);
+                auto pos = iter_stmts_.find(iter);
+                if (pos == iter_stmts_.end()) throw unsupported();
+                record.kind = VarKind::Iter;
+                record.a = pos->second;
+                if (iter->generator()) record.generator = generator_index(iter->generator());
+                break;
+            }
+            default:
+                throw unsupported();
+        }
+        record.meta = meta(var_);
+        return record;
+    }
+
+    static std::string member_name(Generator *gen, Var *var_) {
+        for (auto const &[name, v] : gen->vars()) {
+            if (v.get() == var_) return name;
+        }
+        throw VarException(::format("{0} is not declared in {1}", var_->to_string(), gen->name),
+                           {var_});
+    }
+
+    StmtRecord new_stmt(StmtKind kind, const Stmt *stmt) {
+        StmtRecord record{};
+        record.kind = kind;
+        record.a = record.b = record.c = NO_INDEX;
+        record.frame = frame(stmt->scope_frame());
+        return record;
+    }
+
+    static bool skipped(const Stmt *stmt) {
+        // derived by passes
+        return stmt->type() == StatementType::ModuleInstantiation ||
+               stmt->type() == StatementType::InterfaceInstantiation;
+    }
+
+    std::vector<uint32_t> stmt_list(StmtBlock *block) {
+        std::vector<uint32_t> result;
+        result.reserve(block->size());
+        for (auto const &s : *block) {
+            if (!skipped(s.get())) result.emplace_back(this->stmt(s.get()));
+        }
+        return result;
+    }
+
+    uint32_t stmt(Stmt *stmt_) {
+        // reserve the slot first so that loops can be referred to by their iteration variable
+        auto index = static_cast<uint32_t>(stmts_.size());
+        stmts_.emplace_back();
+        StmtRecord record;
+        switch (stmt_->type()) {
+            case StatementType::Assign: {
+                auto *assign = reinterpret_cast<AssignStmt *>(stmt_);
+                if (assign->has_delay())
+                    throw StmtException("Unable to serialize assignment with delay", {stmt_});
+                record = new_stmt(StmtKind::Assign, stmt_);
+                record.type = static_cast<uint32_t>(assign->assign_type());
+                record.a = var(assign->left());
+                record.b = var(assign->right());
+                break;
+            }
+            case StatementType::If: {
+                auto *if_ = reinterpret_cast<IfStmt *>(stmt_);
+                record = new_stmt(StmtKind::If, stmt_);
+                record.a = var(if_->predicate().get());
+                record.b = this->stmt(if_->then_body().get());
+                record.c = this->stmt(if_->else_body().get());
+                break;
+            }
+            case StatementType::Switch: {
+                auto *switch_ = reinterpret_cast<SwitchStmt *>(stmt_);
+                record = new_stmt(StmtKind::Switch, stmt_);
+                record.a = var(switch_->target().get());
+                std::vector<uint32_t> cases;
+                for (auto const &[c, body] : switch_->body()) {
+                    cases.emplace_back(c ? var(c.get()) : NO_INDEX);
+                    cases.emplace_back(this->stmt(body.get()));
+                }
+                record.extra = indices(cases);
+                break;
+            }
+            case StatementType::For: {
+                auto *for_ = reinterpret_cast<ForStmt *>(stmt_);
+                record = new_stmt(StmtKind::For, stmt_);
+                iter_stmts_.emplace(for_->get_iter_var().get(), index);
+                record.a = string(for_->get_iter_var()->name);
+                record.start = for_->start();
+                record.end = for_->end();
+                record.step = for_->step();
+                record.b = this->stmt(for_->get_loop_body().get());
+                break;
+            }
+            case StatementType::Block: {
+                auto *block = reinterpret_cast<StmtBlock *>(stmt_);
+                record = new_stmt(StmtKind::Block, stmt_);
+                record.type = static_cast<uint32_t>(block->block_type());
+                switch (block->block_type()) {
+                    case StatementBlockType::Combinational:
+                        record.a =
+                            reinterpret_cast<CombinationalStmtBlock *>(block)->is_general_purpose();
+                        break;
+                    case StatementBlockType::Sequential: {
+                        std::vector<uint32_t> conditions;
+                        for (auto const &cond :
+                             reinterpret_cast<SequentialStmtBlock *>(block)->get_event_controls()) {
+                            if (cond.type != EventControlType::Edge)
+                                throw StmtException("Unable to serialize delay event control",
+                                                    {stmt_});
+                            conditions.emplace_back(static_cast<uint32_t>(cond.edge));
+                            conditions.emplace_back(var(cond.var));
+                        }
+                        record.extra = indices(conditions);
+                        break;
+                    }
+                    case StatementBlockType::Scope:
+                    case StatementBlockType::Latch:
+                    case StatementBlockType::Initial:
+                    case StatementBlockType::Final:
+                        break;
+                    default:
+                        throw StmtException("Unable to serialize function block", {stmt_});
+                }
+                auto *gen = stmt_->generator_parent();
+                if (gen) {
+                    auto label = gen->get_block_name(stmt_);
+                    if (label) record.b = string(*label);
+                }
+                auto children = stmt_list(block);
+                record.children = indices(children);
+                break;
+            }
+            case StatementType::Comment:
+            case StatementType::RawString: {
+                auto const &lines = stmt_->type() == StatementType::Comment
+                                        ? reinterpret_cast<CommentStmt *>(stmt_)->comments()
+                                        : reinterpret_cast<RawStringStmt *>(stmt_)->stmts();
+                record = new_stmt(stmt_->type() == StatementType::Comment ? StmtKind::Comment
+                                                                          : StmtKind::RawString,
+                                  stmt_);
+                std::vector<uint32_t> strs;
+                for (auto const &line : lines) strs.emplace_back(string(line));
+                record.extra = indices(strs);
+                break;
+            }
+            case StatementType::Break:
+                record = new_stmt(StmtKind::Break, stmt_);
+                break;
+            default:
+                throw StmtException("Unable to serialize statement: unsupported statement type",
+                                    {stmt_});
+        }
+        record.meta = meta(stmt_);
+        stmts_[index] = record;
+        return index;
+    }
+
+    GeneratorRecord generator(Generator *gen) {
+        GeneratorRecord record{};
+        record.name = string(gen->name);
+        record.instance_name = string(gen->instance_name);
+        record.def = NO_INDEX;
+        record.flags = (gen->debug ? GeneratorDebug : 0u) | (gen->is_stub() ? GeneratorStub : 0u);
+        record.meta = meta(gen);
+
+        std::vector<uint32_t> params;
+        for (auto const &iter : gen->get_params()) params.emplace_back(var(iter.second.get()));
+        record.params = indices(params);
+
+        if (gen->is_cloned()) {
+            record.flags |= GeneratorCloned;
+            record.def = generator_index(gen->def_instance());
+            return record;
+        }
+        if (gen->external()) record.flags |= GeneratorExternal;
+
+        std::vector<uint32_t> enums;
+        for (auto const &iter : gen->get_enums()) enums.emplace_back(enum_(iter.second.get()));
+        record.enums = indices(enums);
+
+        record.interfaces.first = static_cast<uint32_t>(irefs_.size());
+        for (auto const &[name, ref] : gen->interfaces()) {
+            irefs_.emplace_back(InterfaceRefRecord{string(name),
+                                                   interface_def(ref->definition().get()),
+                                                   ref->is_port() ? 1u : 0u});
+        }
+        record.interfaces.count = static_cast<uint32_t>(gen->interfaces().size());
+
+        record.children.first = static_cast<uint32_t>(children_.size());
+        auto const &children_debug = gen->children_debug();
+        for (auto const &child : gen->get_child_generators()) {
+            ChildRecord child_record{};
+            child_record.generator = generator_index(child.get());
+            child_record.instance_name = string(child->instance_name);
+            child_record.debug_file = NO_INDEX;
+            auto debug = children_debug.find(child->instance_name);
+            if (debug != children_debug.end()) {
+                child_record.debug_file = string(debug->second.first);
+                child_record.debug_line = debug->second.second;
+            }
+            auto comment = gen->get_child_comment(child->instance_name);
+            child_record.comment = comment.empty() ? NO_INDEX : string(comment);
+            children_.emplace_back(child_record);
+        }
+        record.children.count = static_cast<uint32_t>(children_.size()) - record.children.first;
+
+        std::vector<uint32_t> vars;
+        for (auto const &[name, v] : gen->vars()) {
+            if (v->is_interface()) continue;
+            vars.emplace_back(var(v.get()));
+        }
+        record.vars = indices(vars);
+
+        std::vector<uint32_t> stmts;
+        for (auto const &s : gen->get_all_stmts()) {
+            if (!skipped(s.get())) stmts.emplace_back(stmt(s.get()));
+        }
+        record.stmts = indices(stmts);
+
+        std::vector<uint32_t> imports;
+        for (auto const &pkg : gen->raw_package_imports()) imports.emplace_back(string(pkg));
+        record.imports = indices(imports);
+        return record;
+    }
+
+    template <typename T>
+    void dump_table(std::string &buffer, Header &header, const std::vector<T> &table) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto offset = align(buffer.size());
+        buffer.resize(offset, '\0');
+        auto &entry = header.tables[static_cast<uint32_t>(table_of<T>())];
+        entry.offset = offset;
+        entry.count = table.size();
+        buffer.append(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(T));
+    }
+
+    std::string dump() {
+        Header header{};
+        std::memcpy(header.magic, IR_MAGIC, sizeof(IR_MAGIC));
+        header.version = IR_FORMAT_VERSION;
+        header.byte_order = IR_BYTE_ORDER;
+        header.table_count = TABLE_COUNT;
+        header.top = generator_index(top_);
+
+        std::string buffer(sizeof(Header), '\0');
+        dump_table(buffer, header, strings_);
+        dump_table(buffer, header, string_data_);
+        dump_table(buffer, header, indices_);
+        dump_table(buffer, header, locations_);
+        dump_table(buffer, header, attributes_);
+        dump_table(buffer, header, frames_);
+        dump_table(buffer, header, frame_vars_);
+        dump_table(buffer, header, enums_);
+        dump_table(buffer, header, enum_values_);
+        dump_table(buffer, header, idefs_);
+        dump_table(buffer, header, ifields_);
+        dump_table(buffer, header, irefs_);
+        dump_table(buffer, header, generator_records_);
+        dump_table(buffer, header, children_);
+        dump_table(buffer, header, vars_);
+        dump_table(buffer, header, stmts_);
+        std::memcpy(buffer.data(), &header, sizeof(Header));
+        return buffer;
+    }
+};
+
+template <typename T>
+class TableView {
+public:
+    TableView() = default;
+    TableView(const T *data, uint64_t size) : data_(data), size_(size) {}
+
+    const T &operator[](uint64_t index) const {
+        if (index >= size_)
+            throw UserException(::format("Invalid IR data: index {0} out of range", index));
+        return data_[index];
+    }
+    [[nodiscard]] uint64_t size() const { return size_; }
+
+private:
+    const T *data_ = nullptr;
+    uint64_t size_ = 0;
+};
+
+class IRReader {
+public:
+    IRReader(Context *context, std::string_view data) : context_(context) {
+        if (data.size() < sizeof(Header)) throw UserException("Invalid IR data: file too small");
+        // the records are read in place, which requires 8-byte alignment. mmap'ed files
+        // always are, other buffers may need a copy
+        if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0) {
+            aligned_.resize((data.size() + 7) / 8);
+            std::memcpy(aligned_.data(), data.data(), data.size());
+            data = std::string_view(reinterpret_cast<const char *>(aligned_.data()), data.size());
+        }
+        std::memcpy(&header_, data.data(), sizeof(Header));
+        if (std::memcmp(header_.magic, IR_MAGIC, sizeof(IR_MAGIC)) != 0)
+            throw UserException("Invalid IR data: not a kratos IR file");
+        if (header_.version != IR_FORMAT_VERSION)
+            throw UserException(::format("Unsupported IR format version {0}, expected {1}",
+                                         header_.version, IR_FORMAT_VERSION));
+        if (header_.byte_order != IR_BYTE_ORDER)
+            throw UserException("IR file is written with a different byte order");
+        if (header_.table_count != TABLE_COUNT)
+            throw UserException("Invalid IR data: table count mismatch");
+        data_ = data;
+        strings_ = view<StringRecord>();
+        string_data_ = view<char>();
+        indices_ = view<uint32_t>();
+        locations_ = view<LocationRecord>();
+        attributes_ = view<AttributeRecord>();
+        frames_ = view<FrameRecord>();
+        frame_vars_ = view<FrameVarRecord>();
+        enums_ = view<EnumRecord>();
+        enum_values_ = view<EnumValueRecord>();
+        idefs_ = view<InterfaceDefRecord>();
+        ifields_ = view<InterfaceFieldRecord>();
+        irefs_ = view<InterfaceRefRecord>();
+        generator_records_ = view<GeneratorRecord>();
+        children_ = view<ChildRecord>();
+        var_records_ = view<VarRecord>();
+        stmt_records_ = view<StmtRecord>();
+    }
+
+    Generator *read() {
+        generators_.resize(generator_records_.size());
+        generators_pending_.resize(generator_records_.size());
+        vars_.resize(var_records_.size());
+        vars_pending_.resize(var_records_.size());
+        stmts_pending_.resize(stmt_records_.size());
+        frame_cache_.resize(frames_.size());
+        enum_cache_.resize(enums_.size());
+
+        for (uint64_t i = 0; i < generator_records_.size(); i++) generator(i);
+        for (uint64_t i = 0; i < idefs_.size(); i++) interface_def(i);
+        for (uint64_t i = 0; i < generator_records_.size(); i++) {
+            auto const &record = generator_records_[i];
+            auto *gen = generators_[i].get();
+            for (uint32_t j = 0; j < record.children.count; j++) {
+                auto const &child = children_[record.children.first + j];
+                auto instance_name = string(child.instance_name);
+                auto child_gen = generator(child.generator);
+                if (child.debug_file != NO_INDEX) {
+                    gen->add_child_generator(instance_name, child_gen,
+                                             {string(child.debug_file), child.debug_line});
+                } else {
+                    gen->add_child_generator(instance_name, child_gen);
+                }
+                if (child.comment != NO_INDEX)
+                    gen->set_child_comment(instance_name, string(child.comment));
+            }
+            for (uint32_t j = 0; j < record.interfaces.count; j++) {
+                auto const &ref = irefs_[record.interfaces.first + j];
+                gen->interface(interface_def(ref.definition), string(ref.name), ref.is_port);
+            }
+            for (uint32_t j = 0; j < record.imports.count; j++)
+                gen->add_raw_import(string(indices_[record.imports.first + j]));
+        }
+        // params first since vars can be parametrized by them
+        for (uint64_t i = 0; i < generator_records_.size(); i++) {
+            auto const &range = generator_records_[i].params;
+            for (uint32_t j = 0; j < range.count; j++) var(indices_[range.first + j]);
+        }
+        for (uint64_t i = 0; i < generator_records_.size(); i++) {
+            auto const &range = generator_records_[i].vars;
+            for (uint32_t j = 0; j < range.count; j++) var(indices_[range.first + j]);
+        }
+        for (uint64_t i = 0; i < generator_records_.size(); i++) {
+            auto const &range = generator_records_[i].stmts;
+            auto *gen = generators_[i].get();
+            for (uint32_t j = 0; j < range.count; j++) {
+                gen->add_stmt(stmt(indices_[range.first + j], gen));
+            }
+        }
+        return generator(header_.top).get();
+    }
+
+private:
+    Context *context_;
+    std::string_view data_;
+    std::vector<uint64_t> aligned_;
+    Header header_{};
+
+    TableView<StringRecord> strings_;
+    TableView<char> string_data_;
+    TableView<uint32_t> indices_;
+    TableView<LocationRecord> locations_;
+    TableView<AttributeRecord> attributes_;
+    TableView<FrameRecord> frames_;
+    TableView<FrameVarRecord> frame_vars_;
+    TableView<EnumRecord> enums_;
+    TableView<EnumValueRecord> enum_values_;
+    TableView<InterfaceDefRecord> idefs_;
+    TableView<InterfaceFieldRecord> ifields_;
+    TableView<InterfaceRefRecord> irefs_;
+    TableView<GeneratorRecord> generator_records_;
+    TableView<ChildRecord> children_;
+    TableView<VarRecord> var_records_;
+    TableView<StmtRecord> stmt_records_;
+
+    std::vector<std::shared_ptr<Generator>> generators_;
+    std::vector<std::shared_ptr<Var>> vars_;
+    // records that are being read. reaching one of them again means the references form a
+    // cycle, which would recurse forever
+    std::vector<bool> generators_pending_;
+    std::vector<bool> vars_pending_;
+    std::vector<bool> stmts_pending_;
+    std::vector<ScopeContext::Frame> frame_cache_;
+    std::vector<std::shared_ptr<Enum>> enum_cache_;
+    std::unordered_map<uint32_t, std::shared_ptr<IDefinition>> idefs_cache_;
+    std::unordered_map<uint32_t, std::shared_ptr<IterVar>> iter_vars_;
+
+    template <typename T>
+    TableView<T> view() {
+        auto const &entry = header_.tables[static_cast<uint32_t>(table_of<T>())];
+        if (entry.offset % alignof(T) != 0 || entry.offset > data_.size() ||
+            entry.count > (data_.size() - entry.offset) / sizeof(T))
+            throw UserException("Invalid IR data: table out of bounds");
+        return {reinterpret_cast<const T *>(data_.data() + entry.offset), entry.count};
+    }
+
+    std::string string(uint32_t index) const {
+        auto const &record = strings_[index];
+        if (record.size > string_data_.size() || record.offset > string_data_.size() - record.size)
+            throw UserException("Invalid IR data: string out of bounds");
+        if (record.size == 0) return {};
+        return std::string(&string_data_[record.offset], record.size);
+    }
+
+    std::vector<uint32_t> indices(const Range &range) const {
+        std::vector<uint32_t> result(range.count);
+        for (uint32_t i = 0; i < range.count; i++) result[i] = indices_[range.first + i];
+        return result;
+    }
+
+    void apply_meta(IRNode *node, const NodeMeta &meta) const {
+        for (uint32_t i = 0; i < meta.locations.count; i++) {
+            auto const &loc = locations_[meta.locations.first + i];
+            node->fn_name_ln.emplace_back(string(loc.filename), loc.line);
+        }
+        for (uint32_t i = 0; i < meta.attributes.count; i++) {
+            auto const &attr = attributes_[meta.attributes.first + i];
+            auto attribute = std::make_shared<Attribute>();
+            attribute->type_str = string(attr.type);
+            attribute->value_str = string(attr.value);
+            node->add_attribute(attribute);
+        }
+        if (meta.comment != NO_INDEX) node->comment = string(meta.comment);
+    }
+
+    std::shared_ptr<Generator> generator(uint32_t index) {
+        if (index >= generators_.size())
+            throw UserException("Invalid IR data: generator index out of range");
+        if (generators_[index]) return generators_[index];
+        if (generators_pending_[index])
+            throw UserException("Invalid IR data: cyclic clone definition");
+        generators_pending_[index] = true;
+        auto const &record = generator_records_[index];
+        std::shared_ptr<Generator> gen;
+        if (record.flags & GeneratorCloned) {
+            gen = generator(record.def)->clone();
+        } else {
+            gen = context_->generator(string(record.name)).shared_from_this();
+            gen->set_external(record.flags & GeneratorExternal);
+        }
+        gen->instance_name = string(record.instance_name);
+        gen->debug = record.flags & GeneratorDebug;
+        gen->set_is_stub(record.flags & GeneratorStub);
+        if (!(record.flags & GeneratorCloned)) apply_meta(gen.get(), record.meta);
+        generators_[index] = gen;
+        generators_pending_[index] = false;
+        return gen;
+    }
+
+    std::shared_ptr<Enum> enum_(uint32_t index) {
+        if (index >= enum_cache_.size())
+            throw UserException("Invalid IR data: enum index out of range");
+        if (enum_cache_[index]) return enum_cache_[index];
+        auto const &record = enums_[index];
+        auto name = string(record.name);
+        std::map<std::string, uint64_t> values;
+        for (uint32_t i = 0; i < record.values.count; i++) {
+            auto const &value = enum_values_[record.values.first + i];
+            values.emplace(string(value.name), value.value);
+        }
+        std::shared_ptr<Enum> result;
+        if (record.generator != NO_INDEX) {
+            result = generator(record.generator)->enum_(name, values, record.width).shared_from_this();
+        } else if (context_->has_enum(name)) {
+            // the same definition is shared across loads in one context
+            result = context_->enum_defs().at(name);
+        } else {
+            result = context_->enum_(name, values, record.width).shared_from_this();
+        }
+        result->external = record.flags & EnumExternal;
+        result->local() = record.flags & EnumLocal;
+        enum_cache_[index] = result;
+        return result;
+    }
+
+    std::shared_ptr<IDefinition> interface_def(uint32_t index) {
+        auto pos = idefs_cache_.find(index);
+        if (pos != idefs_cache_.end()) return pos->second;
+        auto const &record = idefs_[index];
+        auto name = string(record.name);
+        std::shared_ptr<IDefinition> result;
+        if (record.parent == NO_INDEX) {
+            auto def = std::make_shared<InterfaceDefinition>(name);
+            for (uint32_t i = 0; i < record.fields.count; i++) {
+                auto const &field = ifields_[record.fields.first + i];
+                auto field_name = string(field.name);
+                auto size = indices(field.size);
+                if (field.kind == InterfaceFieldKind::Port) {
+                    def->port(field_name, field.width, size,
+                              static_cast<PortDirection>(field.direction),
+                              static_cast<PortType>(field.port_type));
+                } else {
+                    def->var(field_name, field.width, size);
+                }
+            }
+            result = def;
+        } else {
+            if (record.parent >= index) throw UserException("Invalid IR data: bad modport parent");
+            auto def = std::static_pointer_cast<InterfaceDefinition>(interface_def(record.parent));
+            auto modport = def->create_modport_def(name);
+            for (uint32_t i = 0; i < record.fields.count; i++) {
+                auto const &field = ifields_[record.fields.first + i];
+                if (field.kind == InterfaceFieldKind::Input) {
+                    modport->set_input(string(field.name));
+                } else {
+                    modport->set_output(string(field.name));
+                }
+            }
+            result = modport;
+        }
+        idefs_cache_.emplace(index, result);
+        return result;
+    }
+
+    ScopeContext::Frame frame(uint32_t index) {
+        if (index == NO_INDEX) return nullptr;
+        if (index >= frame_cache_.size())
+            throw UserException("Invalid IR data: frame index out of range");
+        if (frame_cache_[index]) return frame_cache_[index];
+        auto const &record = frames_[index];
+        if (record.parent != NO_INDEX && record.parent >= index)
+            throw UserException("Invalid IR data: bad scope frame parent");
+        std::map<std::string, ScopeContext::Entry> variables;
+        for (uint32_t i = 0; i < record.vars.count; i++) {
+            auto const &v = frame_vars_[record.vars.first + i];
+            variables.emplace(string(v.name), ScopeContext::Entry{v.is_var, string(v.value)});
+        }
+        frame_cache_[index] = std::make_shared<const ScopeContext>(frame(record.parent),
+                                                                   std::move(variables));
+        return frame_cache_[index];
+    }
+
+    std::shared_ptr<Var> var(uint32_t index) {
+        if (index >= vars_.size()) throw UserException("Invalid IR data: var index out of range");
+        if (vars_[index]) return vars_[index];
+        if (vars_pending_[index]) throw UserException("Invalid IR data: cyclic var reference");
+        vars_pending_[index] = true;
+        auto const &record = var_records_[index];
+        auto result = create_var(record);
+        switch (record.kind) {
+            case VarKind::Member:
+            case VarKind::Const:
+            case VarKind::EnumConst:
+                // shared with other owners
+                break;
+            default:
+                apply_meta(result.get(), record.meta);
+        }
+        vars_[index] = result;
+        vars_pending_[index] = false;
+        return result;
+    }
+
+    void declare_meta(Var &v, const VarRecord &record) {
+        v.set_explicit_array(record.flags & VarExplicitArray);
+        if (!v.is_enum()) v.set_is_packed(record.flags & VarPacked);
+        v.set_before_var_str_(string(record.str_a));
+        v.set_after_var_str_(string(record.str_b));
+        if (record.a != NO_INDEX) v.set_width_param(var(record.a).get());
+        for (uint32_t i = 0; i + 1 < record.size_params.count; i += 2) {
+            auto dim = indices_[record.size_params.first + i];
+            v.set_size_param(dim, var(indices_[record.size_params.first + i + 1]).get());
+        }
+    }
+
+    std::shared_ptr<Var> create_var(const VarRecord &record) {
+        switch (record.kind) {
+            case VarKind::Var: {
+                auto gen = generator(record.generator);
+                auto name = string(record.name);
+                Var *v;
+                if (record.c != NO_INDEX) {
+                    v = &gen->enum_var(name, enum_(record.c));
+                } else {
+                    v = &gen->var(name, record.width, indices(record.size),
+                                  record.flags & VarSigned);
+                }
+                declare_meta(*v, record);
+                return v->shared_from_this();
+            }
+            case VarKind::Port: {
+                auto gen = generator(record.generator);
+                auto name = string(record.name);
+                auto dir = static_cast<PortDirection>(record.op);
+                Port *p;
+                if (record.c != NO_INDEX) {
+                    p = &gen->port(dir, name, enum_(record.c));
+                } else {
+                    p = &gen->port(dir, name, record.width, indices(record.size),
+                                   static_cast<PortType>(record.b), record.flags & VarSigned);
+                }
+                declare_meta(*p, record);
+                if (record.flags & VarHasActiveHigh) p->set_active_high(record.flags & VarActiveHigh);
+                return p->shared_from_this();
+            }
+            case VarKind::Param: {
+                auto gen = generator(record.generator);
+                auto name = string(record.name);
+                auto type = static_cast<ParamType>(record.op);
+                std::shared_ptr<Param> param = gen->get_param(name);
+                if (!param) {
+                    if (type == ParamType::RawType) {
+                        param = gen->parameter(name).as<Param>();
+                    } else if (type == ParamType::Enum ||
+                               (type == ParamType::Parameter && record.c != NO_INDEX)) {
+                        param = gen->parameter(name, enum_(record.c)).as<Param>();
+                    } else {
+                        param = gen->parameter(name, record.width, record.flags & VarSigned)
+                                    .as<Param>();
+                    }
+                }
+                if (record.flags & ParamHasInitialValue) param->set_initial_value(record.initial_value);
+                if (record.str_b != NO_INDEX) param->set_initial_raw_str_value(string(record.str_b));
+                if (record.str_a != NO_INDEX) param->set_value(string(record.str_a));
+                if (record.a != NO_INDEX) {
+                    param->set_value(var(record.a)->as<Param>());
+                } else if (record.flags & ParamHasValue) {
+                    param->set_value(record.value);
+                }
+                return param;
+            }
+            case VarKind::Member: {
+                auto gen = generator(record.generator);
+                auto name = string(record.name);
+                auto const &vars = gen->vars();
+                if (vars.find(name) == vars.end())
+                    throw UserException(::format("Invalid IR data: {0} not found in {1}", name,
+                                                 gen->name));
+                return vars.at(name);
+            }
+            case VarKind::Const:
+                return Const::constant(record.value, record.width, record.flags & VarSigned)
+                    .shared_from_this();
+            case VarKind::EnumConst:
+                return enum_(record.c)->get_enum(string(record.name));
+            case VarKind::Slice:
+                return (*var(record.a))[{record.b, record.c}].shared_from_this();
+            case VarKind::VarSlice:
+                return (*var(record.a))[var(record.b)].shared_from_this();
+            case VarKind::Cast: {
+                auto type = static_cast<VarCastType>(record.op);
+                auto result = var(record.a)->cast(type);
+                if (type == VarCastType::Resize) {
+                    result->as<VarCasted>()->set_target_width(record.width);
+                } else if (type == VarCastType::Enum) {
+                    result->as<VarCasted>()->set_enum_type(enum_(record.c).get());
+                }
+                return result;
+            }
+            case VarKind::Expr: {
+                auto op = static_cast<ExprOp>(record.op);
+                auto left = var(record.a);
+                if (op == ExprOp::Duplicate)
+                    return left->duplicate(var(record.b)->as<Const>()).shared_from_this();
+                auto right = record.b == NO_INDEX ? nullptr : var(record.b);
+                return left->generator()->expr(op, left.get(), right.get()).shared_from_this();
+            }
+            case VarKind::Concat: {
+                if (record.operands.count < 2)
+                    throw UserException("Invalid IR data: concat needs at least two operands");
+                auto result = var(indices_[record.operands.first]);
+                for (uint32_t i = 1; i < record.operands.count; i++) {
+                    result = result->concat(*var(indices_[record.operands.first + i]))
+                                 .shared_from_this();
+                }
+                return result;
+            }
+            case VarKind::Extend:
+                return var(record.a)->extend(record.width).shared_from_this();
+            case VarKind::Conditional: {
+                auto cond = var(record.a);
+                return util::mux(*cond, *var(record.b), *var(record.c));
+            }
+            case VarKind::Iter: {
+                auto pos = iter_vars_.find(record.a);
+                if (pos == iter_vars_.end())
+                    throw UserException("Invalid IR data: iteration variable used outside loop");
+                if (record.generator != NO_INDEX)
+                    pos->second->set_generator(generator(record.generator).get());
+                return pos->second;
+            }
+            default:
+                throw UserException("Invalid IR data: unknown variable kind");
+        }
+    }
+
+    void fill_block(StmtBlock *block, const StmtRecord &record, Generator *gen) {
+        for (uint32_t i = 0; i < record.children.count; i++) {
+            block->add_stmt(stmt(indices_[record.children.first + i], gen));
+        }
+    }
+
+    void block_meta(Stmt *block, uint32_t index) {
+        auto const &record = stmt_records_[index];
+        if (record.kind != StmtKind::Block)
+            throw UserException("Invalid IR data: statement is not a block");
+        apply_meta(block, record.meta);
+        block->set_scope_frame(frame(record.frame));
+    }
+
+    std::shared_ptr<Stmt> stmt(uint32_t index, Generator *gen) {
+        auto const &record = stmt_records_[index];
+        if (stmts_pending_[index]) throw UserException("Invalid IR data: cyclic statement");
+        stmts_pending_[index] = true;
+        std::shared_ptr<Stmt> result;
+        switch (record.kind) {
+            case StmtKind::Assign: {
+                result = var(record.a)->assign(var(record.b),
+                                               static_cast<AssignmentType>(record.type));
+                break;
+            }
+            case StmtKind::If: {
+                auto if_ = std::make_shared<IfStmt>(var(record.a));
+                block_meta(if_->then_body().get(), record.b);
+                block_meta(if_->else_body().get(), record.c);
+                auto const &then_record = stmt_records_[record.b];
+                for (uint32_t i = 0; i < then_record.children.count; i++)
+                    if_->add_then_stmt(stmt(indices_[then_record.children.first + i], gen));
+                auto const &else_record = stmt_records_[record.c];
+                for (uint32_t i = 0; i < else_record.children.count; i++)
+                    if_->add_else_stmt(stmt(indices_[else_record.children.first + i], gen));
+                result = if_;
+                break;
+            }
+            case StmtKind::Switch: {
+                auto switch_ = std::make_shared<SwitchStmt>(var(record.a));
+                for (uint32_t i = 0; i + 1 < record.extra.count; i += 2) {
+                    auto case_index = indices_[record.extra.first + i];
+                    auto body_index = indices_[record.extra.first + i + 1];
+                    auto switch_case =
+                        case_index == NO_INDEX ? nullptr : var(case_index)->as<Const>();
+                    auto const &body = stmt_records_[body_index];
+                    ScopedStmtBlock *block = nullptr;
+                    if (body.children.count == 0) {
+                        block = &switch_->add_switch_case(switch_case,
+                                                          std::make_shared<ScopedStmtBlock>());
+                    }
+                    for (uint32_t j = 0; j < body.children.count; j++) {
+                        block = &switch_->add_switch_case(
+                            switch_case, stmt(indices_[body.children.first + j], gen));
+                    }
+                    block_meta(block, body_index);
+                }
+                result = switch_;
+                break;
+            }
+            case StmtKind::For: {
+                auto for_ = std::make_shared<ForStmt>(string(record.a), record.start, record.end,
+                                                      record.step);
+                iter_vars_.emplace(index, for_->get_iter_var());
+                block_meta(for_->get_loop_body().get(), record.b);
+                auto const &body = stmt_records_[record.b];
+                for (uint32_t i = 0; i < body.children.count; i++)
+                    for_->add_stmt(stmt(indices_[body.children.first + i], gen));
+                result = for_;
+                break;
+            }
+            case StmtKind::Block: {
+                std::shared_ptr<StmtBlock> block;
+                switch (static_cast<StatementBlockType>(record.type)) {
+                    case StatementBlockType::Combinational: {
+                        auto comb = std::make_shared<CombinationalStmtBlock>();
+                        comb->set_general_purpose(record.a == 1);
+                        block = comb;
+                        break;
+                    }
+                    case StatementBlockType::Sequential: {
+                        auto seq = std::make_shared<SequentialStmtBlock>();
+                        for (uint32_t i = 0; i + 1 < record.extra.count; i += 2) {
+                            auto edge = static_cast<EventEdgeType>(indices_[record.extra.first + i]);
+                            seq->add_condition({edge, var(indices_[record.extra.first + i + 1])});
+                        }
+                        block = seq;
+                        break;
+                    }
+                    case StatementBlockType::Scope:
+                        block = std::make_shared<ScopedStmtBlock>();
+                        break;
+                    case StatementBlockType::Latch:
+                        block = std::make_shared<LatchStmtBlock>();
+                        break;
+                    case StatementBlockType::Initial:
+                        block = std::make_shared<InitialStmtBlock>();
+                        break;
+                    case StatementBlockType::Final:
+                        block = std::make_shared<FinalStmtBlock>();
+                        break;
+                    default:
+                        throw UserException("Invalid IR data: unknown block type");
+                }
+                fill_block(block.get(), record, gen);
+                if (record.b != NO_INDEX) gen->add_named_block(string(record.b), block);
+                result = block;
+                break;
+            }
+            case StmtKind::Comment:
+            case StmtKind::RawString: {
+                std::vector<std::string> lines;
+                lines.reserve(record.extra.count);
+                for (uint32_t i = 0; i < record.extra.count; i++)
+                    lines.emplace_back(string(indices_[record.extra.first + i]));
+                if (record.kind == StmtKind::Comment) {
+                    result = std::make_shared<CommentStmt>(lines);
+                } else {
+                    result = std::make_shared<RawStringStmt>(lines);
+                }
+                break;
+            }
+            case StmtKind::Break:
+                result = std::make_shared<BreakStmt>();
+                break;
+            default:
+                throw UserException("Invalid IR data: unknown statement kind");
+        }
+        apply_meta(result.get(), record.meta);
+        result->set_scope_frame(frame(record.frame));
+        stmts_pending_[index] = false;
+        return result;
+    }
+};
+
+}  // namespace
+
+std::string serialize_ir(Generator *top) {
+    IRWriter writer(top);
+    return writer.write();
+}
+
+void save_ir(Generator *top, const std::string &filename) {
+    auto data = serialize_ir(top);
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream.good()) throw UserException(::format("Unable to open {0}", filename));
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!stream.good()) throw UserException(::format("Unable to write {0}", filename));
+}
+
+Generator *deserialize_ir(Context *context, std::string_view data) {
+    IRReader reader(context, data);
+    return reader.read();
+}
+
+Generator *load_ir(Context *context, const std::string &filename) {
+    fs::MappedFile file(filename);
+    return deserialize_ir(context, file.content());
+}
+
+}  // namespace kratos
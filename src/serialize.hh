@@ -0,0 +1,30 @@
+#ifndef KRATOS_SERIALIZE_HH
+#define KRATOS_SERIALIZE_HH
+
+#include <string>
+#include <string_view>
+
+#include "context.hh"
+
+namespace kratos {
+
+// versioned binary snapshot of the IR reachable from a top generator: child generators and
+// clones, vars, ports, params, statements, expressions, enums, interfaces, attributes and
+// debug information (source locations, comments and scope variables).
+// the file is a header followed by tables of fixed-size records that refer to each other by
+// index, so the loader reads the records in place from a memory-mapped file.
+// module and interface instantiation statements are not stored, since they are derived by
+// create_module_instantiation and create_interface_instantiation. functions, FSMs,
+// properties, packed structs and port bundles are not supported
+constexpr uint32_t IR_FORMAT_VERSION = 1;
+
+std::string serialize_ir(Generator *top);
+void save_ir(Generator *top, const std::string &filename);
+
+// generators are created in the context. returns the top generator
+Generator *deserialize_ir(Context *context, std::string_view data);
+Generator *load_ir(Context *context, const std::string &filename);
+
+}  // namespace kratos
+
+#endif  // KRATOS_SERIALIZE_HH
@@ -192,6 +192,18 @@ Simulator::Simulator(kratos::Generator *generator) {
     dependency_ = visitor.dependency();
     linked_dependency_ = visitor.linked_dependency();
     init_pull_up_value(generator);
+    // snapshot the pull-up values so that we can reset without visiting the design again
+    init_values_ = values_;
+    init_complex_values_ = complex_values_;
+}
+
+void Simulator::reset() {
+    values_ = init_values_;
+    complex_values_ = init_complex_values_;
+    event_queue_ = {};
+    nba_values_.clear();
+    scope_.clear();
+    simulation_depth_ = 0;
 }
 
 std::optional<uint64_t> Simulator::get_value_(const kratos::Var *var) const {
@@ -540,7 +552,7 @@ void Simulator::eval() {
         if (simulation_depth_ > MAX_SIMULATION_DEPTH) {
             throw UserException("Simulation doesn't converge");
         }
-        auto &[var, stmt] = event_queue_.front();
+        auto [var, stmt] = event_queue_.front();
         event_queue_.pop();
         process_stmt(stmt, var);
     }
@@ -553,6 +565,73 @@ std::optional<std::vector<uint64_t>> Simulator::get_array(kratos::Var *var) cons
     return get_complex_value_(var);
 }
 
+uint64_t Simulator::value_count(const kratos::Var *var) {
+    uint64_t result = 1;
+    for (auto const s : var->size()) result *= s;
+    return result;
+}
+
+uint64_t Simulator::value_count(const std::vector<Var *> &vars) {
+    uint64_t result = 0;
+    for (auto const *var : vars) {
+        if (!var) throw UserException("Variable cannot be null (None)");
+        result += value_count(var);
+    }
+    return result;
+}
+
+void Simulator::set_many(const std::vector<Var *> &vars, const uint64_t *values, uint64_t count,
+                         bool eval_) {
+    // check the size before touching any value so a bad call does not leave partial updates
+    auto total = value_count(vars);
+    if (total != count)
+        throw UserException(
+            ::format("Expected {0} values for {1} variables, got {2}", total, vars.size(), count));
+    uint64_t offset = 0;
+    for (auto const *var : vars) {
+        auto n = value_count(var);
+        auto width = var->var_width();
+        if (var->size().size() == 1 && var->size().front() == 1) {
+            set_value_(var, truncate(values[offset], width));
+        } else {
+            std::vector<uint64_t> array(values + offset, values + offset + n);
+            for (auto &v : array) v = truncate(v, width);
+            set_complex_value_(var, array);
+        }
+        offset += n;
+    }
+    if (eval_) eval();
+}
+
+void Simulator::get_many(const std::vector<Var *> &vars, uint64_t *values, uint64_t count,
+                         bool *valid) const {
+    auto total = value_count(vars);
+    if (total != count)
+        throw UserException(::format("Expected buffer of size {0} for {1} variables, got {2}",
+                                     total, vars.size(), count));
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < vars.size(); i++) {
+        auto const *var = vars[i];
+        auto n = value_count(var);
+        bool has_value;
+        if (var->size().size() == 1 && var->size().front() == 1) {
+            auto v = get_value_(var);
+            has_value = v.has_value();
+            values[offset] = v ? *v : 0;
+        } else {
+            auto v = get_complex_value_(var);
+            has_value = v && v->size() == n;
+            if (has_value) {
+                std::copy(v->begin(), v->end(), values + offset);
+            } else {
+                std::fill(values + offset, values + offset + n, 0);
+            }
+        }
+        if (valid) valid[i] = has_value;
+        offset += n;
+    }
+}
+
 void Simulator::set(kratos::Var *var, std::optional<uint64_t> value, bool eval_) {
     set_value_(var, value);
     if (eval_) eval();
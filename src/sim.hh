@@ -17,9 +17,21 @@ public:
     void set_i(const Var *var, const std::optional<std::vector<int64_t>> &value, bool eval=true);
     std::optional<uint64_t> get(Var *var) const;
     std::optional<std::vector<uint64_t>> get_array(Var *var) const;
+    // bulk access over a flat buffer. each var takes value_count(var) consecutive entries in
+    // the buffer, in the order given. unknown values are read as 0, and if valid is not null,
+    // valid[i] tells whether vars[i] has a value
+    void set_many(const std::vector<Var *> &vars, const uint64_t *values, uint64_t count,
+                  bool eval = true);
+    void get_many(const std::vector<Var *> &vars, uint64_t *values, uint64_t count,
+                  bool *valid = nullptr) const;
+    static uint64_t value_count(const Var *var);
+    static uint64_t value_count(const std::vector<Var *> &vars);
 
     void eval();
     std::optional<std::vector<uint64_t>> eval_expr(const Var *var) const;
+    // restore the state right after construction, i.e. only pull-up values are set.
+    // the dependency table is kept so the simulator can be reused for many states
+    void reset();
 
     static uint64_t static_evaluate_expr(Var *expr);
 
@@ -55,6 +67,8 @@ private:
 
     // pull-up registers
     void init_pull_up_value(Generator *generator);
+    std::unordered_map<const Var *, uint64_t> init_values_;
+    std::unordered_map<const Var *, std::vector<uint64_t>> init_complex_values_;
 
     uint64_t simulation_depth_ = 0;
 };
@@ -69,15 +69,93 @@ Stmt *Stmt::pre_stmt() const {
     return nullptr;
 }
 
+const ScopeContext::Entry *ScopeContext::find(const std::string &name) const {
+    for (auto const *frame = this; frame; frame = frame->parent_.get()) {
+        auto iter = frame->variables_.find(name);
+        if (iter != frame->variables_.end()) return &iter->second;
+    }
+    return nullptr;
+}
+
+std::map<std::string, ScopeContext::Entry> ScopeContext::flatten() const {
+    std::vector<const ScopeContext *> frames;
+    for (auto const *frame = this; frame; frame = frame->parent_.get()) frames.emplace_back(frame);
+    std::map<std::string, Entry> result;
+    // child frames shadow their parents
+    for (auto iter = frames.rbegin(); iter != frames.rend(); iter++) {
+        for (auto const &[name, entry] : (*iter)->variables_) {
+            result.insert_or_assign(name, entry);
+        }
+    }
+    return result;
+}
+
+ScopeContext::Frame ScopeContext::add(const Frame &frame, const std::string &name,
+                                      const Entry &entry, bool override) {
+    if (frame) {
+        auto const *existing = frame->find(name);
+        if (existing && (!override || *existing == entry)) return frame;
+    }
+    return std::make_shared<const ScopeContext>(frame, std::map<std::string, Entry>{{name, entry}});
+}
+
+ScopeContext::Frame ScopeContext::inherit(const Frame &frame, const Frame &parent) {
+    if (!parent || frame == parent) return frame;
+    if (!frame) return parent;
+    std::map<std::string, Entry> variables;
+    for (auto const &[name, entry] : parent->flatten()) {
+        if (!frame->find(name)) variables.emplace(name, entry);
+    }
+    if (variables.empty()) return frame;
+    return std::make_shared<const ScopeContext>(frame, std::move(variables));
+}
+
+std::map<std::string, std::pair<bool, std::string>> Stmt::scope_context() const {
+    if (!scope_context_) return {};
+    return scope_context_->flatten();
+}
+
 void Stmt::set_scope_context(const std::map<std::string, std::pair<bool, std::string>> &context) {
-    scope_context_ = context;
+    if (context.empty()) {
+        scope_context_ = nullptr;
+    } else {
+        scope_context_ = std::make_shared<const ScopeContext>(nullptr, context);
+    }
 }
 
+namespace {
+// statements that share a frame before the update share the resulting frame as well
+auto memoize_scope_update(std::function<ScopeContext::Frame(const ScopeContext::Frame &)> fn) {
+    // hold on to the old frame as well so its address can't be reused during the update
+    using FramePair = std::pair<ScopeContext::Frame, ScopeContext::Frame>;
+    return [fn = std::move(fn), cache = std::unordered_map<const ScopeContext *, FramePair>()](
+               const ScopeContext::Frame &frame) mutable {
+        auto iter = cache.find(frame.get());
+        if (iter != cache.end()) return iter->second.second;
+        auto result = fn(frame);
+        cache.emplace(frame.get(), std::make_pair(frame, result));
+        return result;
+    };
+}
+}  // namespace
+
 void Stmt::add_scope_variable(const std::string &name, const std::string &value, bool is_var,
                               bool override) {
-    if (override || scope_context_.find(name) == scope_context_.end()) {
-        scope_context_.emplace(name, std::make_pair(is_var, value));
-    }
+    auto entry = std::make_pair(is_var, value);
+    update_scope_context(memoize_scope_update([&](const ScopeContext::Frame &frame) {
+        return ScopeContext::add(frame, name, entry, override);
+    }));
+}
+
+void Stmt::inherit_scope_context(const ScopeContext::Frame &frame) {
+    update_scope_context(memoize_scope_update([&](const ScopeContext::Frame &current) {
+        return ScopeContext::inherit(current, frame);
+    }));
+}
+
+void Stmt::update_scope_context(
+    const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) {
+    scope_context_ = update(scope_context_);
 }
 
 void Stmt::remove_from_parent() {
@@ -322,11 +400,11 @@ IRNode *IfStmt::get_child(uint64_t index) {
         return nullptr;
 }
 
-void IfStmt::add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                                bool override) {
-    Stmt::add_scope_variable(name, value, is_var, override);
-    then_body_->add_scope_variable(name, value, is_var, override);
-    else_body_->add_scope_variable(name, value, is_var, override);
+void IfStmt::update_scope_context(
+    const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) {
+    Stmt::update_scope_context(update);
+    then_body_->update_scope_context(update);
+    else_body_->update_scope_context(update);
 }
 
 std::shared_ptr<Stmt> IfStmt::clone() const {
@@ -472,11 +550,11 @@ void StmtBlock::set_child(uint64_t index, const std::shared_ptr<Stmt> &stmt) {
     }
 }
 
-void StmtBlock::add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                                   bool override) {
-    Stmt::add_scope_variable(name, value, is_var, override);
+void StmtBlock::update_scope_context(
+    const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) {
+    Stmt::update_scope_context(update);
     for (auto &stmt : stmts_) {
-        stmt->add_scope_variable(name, value, is_var, override);
+        stmt->update_scope_context(update);
     }
 }
 
@@ -631,11 +709,11 @@ IRNode *SwitchStmt::get_child(uint64_t index) {
     }
 }
 
-void SwitchStmt::add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                                    bool override) {
-    Stmt::add_scope_variable(name, value, is_var, override);
+void SwitchStmt::update_scope_context(
+    const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) {
+    Stmt::update_scope_context(update);
     for (auto &iter : body_) {
-        iter.second->add_scope_variable(name, value, is_var, override);
+        iter.second->update_scope_context(update);
     }
 }
 
@@ -36,6 +36,34 @@ enum class EventControlType { Delay, Edge };
 class StmtBlock;
 class ScopedStmtBlock;
 
+// immutable scope variable frame. statements that share the same scope variables point to the
+// same frame, and each frame only holds the variables added on top of its parent
+class ScopeContext {
+public:
+    using Entry = std::pair<bool, std::string>;
+    using Frame = std::shared_ptr<const ScopeContext>;
+
+    ScopeContext(Frame parent, std::map<std::string, Entry> variables)
+        : parent_(std::move(parent)), variables_(std::move(variables)) {}
+
+    [[nodiscard]] const Frame &parent() const { return parent_; }
+    [[nodiscard]] const std::map<std::string, Entry> &variables() const { return variables_; }
+    [[nodiscard]] const Entry *find(const std::string &name) const;
+    [[nodiscard]] std::map<std::string, Entry> flatten() const;
+
+    // return a frame that has the variable. if the variable is already visible and not
+    // overridden, the same frame is returned
+    static Frame add(const Frame &frame, const std::string &name, const Entry &entry,
+                     bool override);
+    // return a frame that contains every variable from frame, plus variables from parent
+    // that are not visible in frame
+    static Frame inherit(const Frame &frame, const Frame &parent);
+
+private:
+    Frame parent_;
+    std::map<std::string, Entry> variables_;
+};
+
 class Stmt : public std::enable_shared_from_this<Stmt>, public IRNode {
 public:
     explicit Stmt(StatementType type) : IRNode(IRNodeKind::StmtKind), type_(type) {}
@@ -60,15 +88,17 @@ public:
     // debug
     int stmt_id() const { return stmt_id_; }
     void set_stmt_id(uint32_t id) { stmt_id_ = id; }
-    const std::map<std::string, std::pair<bool, std::string>> &scope_context() const {
-        return scope_context_;
-    }
+    std::map<std::string, std::pair<bool, std::string>> scope_context() const;
+    const ScopeContext::Frame &scope_frame() const { return scope_context_; }
     void set_scope_context(const std::map<std::string, std::pair<bool, std::string>> &context);
-    // For now it's a flat context that every breakpoint/stmt has its own context
-    // in the future if the performance/storage size is a concern, we can group the stmt
-    // together
-    virtual void add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                                    bool override);
+    void set_scope_frame(ScopeContext::Frame frame) { scope_context_ = std::move(frame); }
+    // scope variables are propagated to child statements. statements that have the same
+    // context before the update share the same frame afterwards
+    void add_scope_variable(const std::string &name, const std::string &value, bool is_var,
+                            bool override);
+    void inherit_scope_context(const ScopeContext::Frame &frame);
+    virtual void update_scope_context(
+        const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update);
 
     virtual void remove_from_parent();
     virtual void remove_stmt(const std::shared_ptr<Stmt> &) {}
@@ -81,7 +111,7 @@ protected:
     IRNode *parent_ = nullptr;
     int stmt_id_ = -1;
 
-    std::map<std::string, std::pair<bool, std::string>> scope_context_;
+    ScopeContext::Frame scope_context_;
 
     void copy_meta(const std::shared_ptr<Stmt> &stmt) const;
 };
@@ -171,13 +201,13 @@ public:
     uint64_t child_count() override { return 3; }
     IRNode *get_child(uint64_t index) override;
 
-    // Debug
-    void add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                            bool override) override;
-
     std::shared_ptr<Stmt> clone() const override;
     void clear() override;
 
+    // Debug
+    void update_scope_context(
+        const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) override;
+
 private:
     std::shared_ptr<Var> predicate_;
     std::shared_ptr<AssignStmt> predicate_stmt_;
@@ -220,13 +250,13 @@ public:
     uint64_t child_count() override { return body_.size() + 1; }
     IRNode *get_child(uint64_t index) override;
 
-    // Debug
-    void add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                            bool override) override;
-
     std::shared_ptr<Stmt> clone() const override;
     void clear() override;
 
+    // Debug
+    void update_scope_context(
+        const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) override;
+
 private:
     std::shared_ptr<Var> target_;
     std::shared_ptr<AssignStmt> target_stmt_;
@@ -296,8 +326,8 @@ public:
     void set_stmts(const std::vector<std::shared_ptr<Stmt>> &stmts) { stmts_ = stmts; }
 
     // Debug
-    void add_scope_variable(const std::string &name, const std::string &value, bool is_var,
-                            bool override) override;
+    void update_scope_context(
+        const std::function<ScopeContext::Frame(const ScopeContext::Frame &)> &update) override;
 
 protected:
     explicit StmtBlock(StatementBlockType type);
@@ -554,6 +584,8 @@ class CommentStmt : public Stmt {
 public:
     explicit CommentStmt(const std::string &comment) : CommentStmt(comment, default_width) {}
     CommentStmt(std::string comment, uint32_t line_width);
+    explicit CommentStmt(std::vector<std::string> comments)
+        : Stmt(StatementType::Comment), comments_(std::move(comments)) {}
     CommentStmt() : Stmt(StatementType::Comment) {}
 
     const std::vector<std::string> &comments() { return comments_; }
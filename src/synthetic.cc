@@ -0,0 +1,213 @@
+#include "synthetic.hh"
+
+#include <random>
+
+#include "except.hh"
+#include "fmt/format.h"
+#include "stmt.hh"
+
+using fmt::format;
+
+namespace kratos {
+
+namespace {
+// std distributions are implementation defined, so the draws are done by hand to keep designs
+// the same across platforms
+class SyntheticRandom {
+public:
+    explicit SyntheticRandom(uint64_t seed) : engine_(seed) {}
+
+    uint64_t next() { return engine_(); }
+    // [0, n)
+    uint32_t below(uint32_t n) { return n ? static_cast<uint32_t>(engine_() % n) : 0; }
+    // [low, high]
+    uint32_t range(uint32_t low, uint32_t high) { return low + below(high - low + 1); }
+    double unit() { return static_cast<double>(engine_() >> 11u) * 0x1.0p-53; }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+enum class SyntheticStmt { Assign, If, Switch, Sequential };
+
+class DesignSynthesizer {
+public:
+    DesignSynthesizer(Context *context, const SyntheticDesignOptions &options)
+        : context_(context), options_(options), random_(options.seed) {
+        recipes_.resize(options.depth + 1);
+    }
+
+    Generator &build() { return build_module(0, random_.next()); }
+
+private:
+    Context *context_;
+    const SyntheticDesignOptions &options_;
+    SyntheticRandom random_;
+    // seeds of the modules built on each level
+    std::vector<std::vector<uint64_t>> recipes_;
+    // children of each module seed, so that a reused module gets the same subtree
+    std::unordered_map<uint64_t, std::vector<uint64_t>> children_seeds_;
+
+    // everything inside a module only depends on its seed, so modules with the same seed have
+    // the same content
+    Generator &build_module(uint32_t level, uint64_t seed) {
+        SyntheticRandom random(seed);
+        auto name = level == 0 ? std::string("top") : ::format("level{0}", level);
+        auto &gen = context_->generator(name);
+        auto const width = random.range(options_.min_width, options_.max_width);
+        auto &clk = gen.port(PortDirection::In, "clk", 1, PortType::Clock);
+        auto &in = gen.port(PortDirection::In, "in", width);
+        auto &out = gen.port(PortDirection::Out, "out", width);
+        std::vector<Var *> sources = {&in};
+
+        if (level < options_.depth) {
+            auto iter = children_seeds_.find(seed);
+            if (iter == children_seeds_.end()) {
+                std::vector<uint64_t> seeds(options_.fanout);
+                for (auto &child_seed : seeds) child_seed = draw_child_seed(level + 1);
+                iter = children_seeds_.emplace(seed, std::move(seeds)).first;
+            }
+            // the vector may be moved by the recursive calls
+            auto const seeds = iter->second;
+            for (uint32_t i = 0; i < options_.fanout; i++) {
+                auto &child = build_module(level + 1, seeds[i]);
+                auto inst_name = ::format("inst{0}", i);
+                gen.add_child_generator(inst_name, child);
+                auto *child_in = child.get_port("in").get();
+                auto *child_out = child.get_port("out").get();
+                // ports are connected through wires of the parent
+                auto &child_in_wire = gen.var(inst_name + "_in", child_in->width());
+                auto &child_out_wire = gen.var(inst_name + "_out", child_out->width());
+                gen.add_stmt(child.get_port("clk")->assign(clk));
+                gen.add_stmt(child_in_wire.assign(resize(*sources[random.below(sources.size())],
+                                                         child_in->width())));
+                gen.add_stmt(child_in->assign(child_in_wire));
+                gen.add_stmt(child_out_wire.assign(*child_out));
+                sources.emplace_back(&child_out_wire);
+            }
+        }
+
+        for (uint32_t i = 0; i < options_.num_stmts; i++) {
+            auto &target = gen.var(::format("v{0}", i), width);
+            switch (pick_stmt(random)) {
+                case SyntheticStmt::Assign: {
+                    gen.add_stmt(target.assign(random_expr(random, sources, width)));
+                    break;
+                }
+                case SyntheticStmt::If: {
+                    auto comb = gen.combinational();
+                    auto if_ = std::make_shared<IfStmt>(random_bit(random, sources));
+                    if_->add_then_stmt(target.assign(random_expr(random, sources, width)));
+                    if_->add_else_stmt(target.assign(random_expr(random, sources, width)));
+                    comb->add_stmt(if_);
+                    break;
+                }
+                case SyntheticStmt::Switch: {
+                    auto comb = gen.combinational();
+                    auto &sel = *sources[random.below(sources.size())];
+                    auto sel_width = std::min<uint32_t>(sel.width(), 2);
+                    auto &switch_target = resize(sel, sel_width);
+                    auto switch_ = std::make_shared<SwitchStmt>(switch_target);
+                    for (uint32_t value = 0; value < (1u << sel_width) - 1; value++) {
+                        switch_->add_switch_case(
+                            constant(value, sel_width).as<Const>(),
+                            target.assign(random_expr(random, sources, width)));
+                    }
+                    switch_->add_switch_case(nullptr,
+                                             target.assign(random_expr(random, sources, width)));
+                    comb->add_stmt(switch_);
+                    break;
+                }
+                case SyntheticStmt::Sequential: {
+                    auto seq = gen.sequential();
+                    seq->add_condition({EventEdgeType::Posedge, clk.shared_from_this()});
+                    seq->add_stmt(target.assign(random_expr(random, sources, width)));
+                    break;
+                }
+            }
+            sources.emplace_back(&target);
+        }
+
+        // every source drives the output so that nothing is optimized away
+        Var *result = sources.back();
+        for (uint64_t i = 0; i + 1 < sources.size(); i++) {
+            result = &(*result ^ resize(*sources[i], width));
+        }
+        gen.add_stmt(out.assign(*result));
+        return gen;
+    }
+
+    uint64_t draw_child_seed(uint32_t level) {
+        auto &recipes = recipes_[level];
+        if (!recipes.empty() && random_.unit() < options_.duplication_ratio) {
+            return recipes[random_.below(recipes.size())];
+        }
+        auto seed = random_.next();
+        recipes.emplace_back(seed);
+        return seed;
+    }
+
+    SyntheticStmt pick_stmt(SyntheticRandom &random) const {
+        auto const total = options_.assign_weight + options_.if_weight + options_.switch_weight +
+                           options_.sequential_weight;
+        auto value = random.below(total);
+        if (value < options_.assign_weight) return SyntheticStmt::Assign;
+        value -= options_.assign_weight;
+        if (value < options_.if_weight) return SyntheticStmt::If;
+        value -= options_.if_weight;
+        if (value < options_.switch_weight) return SyntheticStmt::Switch;
+        return SyntheticStmt::Sequential;
+    }
+
+    static Var &resize(Var &var, uint32_t width) {
+        if (var.width() == width) return var;
+        if (var.width() > width) return var[std::make_pair(width - 1, 0u)];
+        return var.extend(width);
+    }
+
+    static Var &random_bit(SyntheticRandom &random, const std::vector<Var *> &sources) {
+        auto &var = *sources[random.below(sources.size())];
+        return var.width() == 1 ? var : var[random.below(var.width())];
+    }
+
+    static Var &random_expr(SyntheticRandom &random, const std::vector<Var *> &sources,
+                            uint32_t width) {
+        auto &left = resize(*sources[random.below(sources.size())], width);
+        if (random.below(4) == 0) {
+            // keep the constant legal for any width
+            auto max_value = width >= 8 ? 255u : (1u << width) - 1;
+            return left + constant(random.range(0, max_value), width);
+        }
+        auto &right = resize(*sources[random.below(sources.size())], width);
+        switch (random.below(5)) {
+            case 0:
+                return left + right;
+            case 1:
+                return left - right;
+            case 2:
+                return left & right;
+            case 3:
+                return left | right;
+            default:
+                return left ^ right;
+        }
+    }
+};
+}  // namespace
+
+Generator &synthesize_design(Context *context, const SyntheticDesignOptions &options) {
+    if (options.min_width == 0 || options.min_width > options.max_width)
+        throw UserException(::format("Invalid bus width range [{0}, {1}]", options.min_width,
+                                     options.max_width));
+    if (options.assign_weight + options.if_weight + options.switch_weight +
+            options.sequential_weight ==
+        0)
+        throw UserException("At least one statement weight has to be positive");
+    if (options.duplication_ratio < 0 || options.duplication_ratio > 1)
+        throw UserException(
+            ::format("Duplication ratio has to be in [0, 1], got {0}", options.duplication_ratio));
+    DesignSynthesizer synthesizer(context, options);
+    return synthesizer.build();
+}
+
+}  // namespace kratos
@@ -0,0 +1,35 @@
+#ifndef KRATOS_SYNTHETIC_HH
+#define KRATOS_SYNTHETIC_HH
+
+#include "generator.hh"
+
+namespace kratos {
+
+struct SyntheticDesignOptions {
+    // number of child instances per generator and levels of hierarchy below the top.
+    // the design has fanout^depth leaf instances
+    uint32_t fanout = 4;
+    uint32_t depth = 3;
+    // probability that a child instance reuses a module already built on the same level, i.e.
+    // has the same hash. everything else is a new module with the same name, which gets
+    // uniquified later
+    double duplication_ratio = 0.5;
+    // number of statements per generator, drawn by the weights below
+    uint32_t num_stmts = 8;
+    uint32_t assign_weight = 4;
+    uint32_t if_weight = 2;
+    uint32_t switch_weight = 1;
+    uint32_t sequential_weight = 2;
+    // data bus width of each module, drawn from [min_width, max_width]
+    uint32_t min_width = 1;
+    uint32_t max_width = 64;
+    uint64_t seed = 0;
+};
+
+// builds a random generator hierarchy through the normal generator API, for stress tests and
+// benchmarks. the same options always produce the same design
+Generator &synthesize_design(Context *context, const SyntheticDesignOptions &options);
+
+}  // namespace kratos
+
+#endif  // KRATOS_SYNTHETIC_HH
@@ -399,8 +399,7 @@ private:
             }
             if (parent->debug) {
                 // need to copy over the changes over
-                var->fn_name_ln = std::vector<std::pair<std::string, uint32_t>>(
-                    port->fn_name_ln.begin(), port->fn_name_ln.end());
+                var->fn_name_ln = port->fn_name_ln;
                 var->fn_name_ln.emplace_back(std::make_pair(__FILE__, __LINE__));
             }
             // replace all the sources
@@ -456,8 +455,7 @@ private:
             auto var = parent->get_var(new_name);
             if (parent->debug) {
                 // need to copy over the changes over
-                var->fn_name_ln = std::vector<std::pair<std::string, uint32_t>>(
-                    port->fn_name_ln.begin(), port->fn_name_ln.end());
+                var->fn_name_ln = port->fn_name_ln;
                 var->fn_name_ln.emplace_back(std::make_pair(__FILE__, __LINE__));
             }
             // replace all the sources
@@ -7,6 +7,20 @@
 #include <fstream>
 #include <regex>
 #include <thread>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#ifdef KRATOS_COUNT_ALLOCATIONS
+#include <atomic>
+#include <new>
+#endif
 
 #include "except.hh"
 #include "expr.hh"
@@ -365,25 +379,143 @@ std::vector<std::vector<uint32_t>> get_flatten_slices(const Var *var) {
     return result;
 }
 
-std::map<std::string, std::shared_ptr<Port>> get_port_from_verilog(Generator *generator,
-                                                                   const std::string &src,
-                                                                   const std::string &top_name) {
-    std::regex re("module\\s+([\\w_$]+)[\\w\\W]*?endmodule", std::regex::ECMAScript);  // NOLINT
-    std::smatch match;
-    std::string::const_iterator iter = src.cbegin();
-    std::string module_def;
-    while (std::regex_search(iter, src.end(), match, re)) {
-        if (match.size() > 1) {
-            std::string module_name = std::string(match[1].first, match[1].second);
-            if (module_name == top_name) {
-                module_def = std::string(match[0].first, match[0].second);
+namespace {
+bool is_identifier_start(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+bool is_identifier_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+// minimal Verilog tokenizer that only produces identifiers and keywords. comments, strings
+// and compiler directives are skipped
+class VerilogIdentifierScanner {
+public:
+    explicit VerilogIdentifierScanner(std::string_view src) : src_(src) {}
+
+    // returns false at the end of the source
+    bool next(std::string_view &token, uint64_t &pos) {
+        while (pos_ < src_.size()) {
+            auto c = src_[pos_];
+            if (c == '/' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '/') {
+                auto end = src_.find('\n', pos_);
+                pos_ = end == std::string_view::npos ? src_.size() : end + 1;
+            } else if (c == '/' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '*') {
+                auto end = src_.find("*/", pos_ + 2);
+                pos_ = end == std::string_view::npos ? src_.size() : end + 2;
+            } else if (c == '"') {
+                pos_++;
+                while (pos_ < src_.size() && src_[pos_] != '"') {
+                    if (src_[pos_] == '\\') pos_++;
+                    pos_++;
+                }
+                pos_++;
+            } else if (c == '\\') {
+                // escaped identifier, terminated by white space
+                auto start = pos_++;
+                while (pos_ < src_.size() && !std::isspace(static_cast<unsigned char>(src_[pos_])))
+                    pos_++;
+                token = src_.substr(start, pos_ - start);
+                pos = start;
+                return true;
+            } else if (c == '`') {
+                // compiler directive
+                pos_++;
+                while (pos_ < src_.size() && is_identifier_char(src_[pos_])) pos_++;
+            } else if (is_identifier_start(c)) {
+                auto start = pos_++;
+                while (pos_ < src_.size() && is_identifier_char(src_[pos_])) pos_++;
+                token = src_.substr(start, pos_ - start);
+                pos = start;
+                return true;
+            } else if (std::isdigit(static_cast<unsigned char>(c))) {
+                // numbers such as 8'hFF shouldn't be treated as identifiers
+                while (pos_ < src_.size() &&
+                       (is_identifier_char(src_[pos_]) || src_[pos_] == '\''))
+                    pos_++;
+            } else {
+                pos_++;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] uint64_t pos() const { return pos_; }
+
+private:
+    std::string_view src_;
+    uint64_t pos_ = 0;
+};
+
+std::string_view module_src(std::string_view src, const std::string &top_name,
+                            const VerilogModuleIndex &index) {
+    auto iter = index.find(top_name);
+    if (iter == index.end())
+        throw std::runtime_error(::format("Unable to find {} definition", top_name));
+    auto const &[begin, end] = iter->second;
+    return src.substr(begin, end - begin);
+}
+}  // namespace
+
+VerilogModuleIndex index_verilog_modules(std::string_view src) {
+    VerilogModuleIndex result;
+    VerilogIdentifierScanner scanner(src);
+    std::string_view token;
+    uint64_t pos;
+    while (scanner.next(token, pos)) {
+        if (token != "module" && token != "macromodule") continue;
+        auto begin = pos;
+        if (!scanner.next(token, pos)) break;
+        auto name = std::string(token);
+        // look for the matching endmodule
+        bool found = false;
+        while (scanner.next(token, pos)) {
+            if (token == "endmodule") {
+                found = true;
                 break;
             }
         }
-        iter = match[0].second;
+        if (!found) break;
+        // first definition wins
+        result.emplace(name, std::make_pair(begin, scanner.pos()));
     }
-    if (module_def.empty())
+    return result;
+}
+
+std::map<std::string, std::shared_ptr<Port>> get_port_from_verilog(Generator *generator,
+                                                                   const std::string &src,
+                                                                   const std::string &top_name) {
+    auto index = index_verilog_modules(src);
+    auto module_def = module_src(src, top_name, index);
+    return get_port_from_mod_def(generator, std::string(module_def));
+}
+
+std::map<std::string, std::shared_ptr<Port>> get_port_from_verilog_file(
+    Generator *generator, const std::string &filename, const std::string &top_name) {
+    auto stamp = fs::file_stamp(filename);
+    if (!stamp) throw UserException(::format("{0} does not exist", filename));
+    auto *context = generator->context();
+    auto path = fs::abspath(filename);
+    auto index = context->get_verilog_module_index(path, *stamp);
+
+    if (!index) {
+        fs::MappedFile file(filename);
+        auto content = file.content();
+        auto entry = std::make_shared<const VerilogModuleIndex>(index_verilog_modules(content));
+        // the index is valid even if the module below turns out to be missing or broken
+        context->add_verilog_module_index(path, *stamp, entry);
+        auto module_def = module_src(content, top_name, *entry);
+        return get_port_from_mod_def(generator, std::string(module_def));
+    }
+
+    // only read the module we need
+    auto iter = index->find(top_name);
+    if (iter == index->end())
         throw std::runtime_error(::format("Unable to find {} definition", top_name));
+    auto const &[begin, end] = iter->second;
+    std::string module_def(end - begin, '\0');
+    std::ifstream stream(filename, std::ios::binary);
+    stream.seekg(static_cast<std::streamoff>(begin));
+    stream.read(module_def.data(), static_cast<std::streamsize>(module_def.size()));
+    if (!stream) throw UserException(::format("Unable to read {0}", filename));
     return get_port_from_mod_def(generator, module_def);
 }
 
@@ -582,6 +714,57 @@ char separator() {
 #endif
 }
 
+std::optional<std::pair<int64_t, uint64_t>> file_stamp(const std::string &filename) {
+#if defined(INCLUDE_FILESYSTEM)
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(filename, ec);
+    if (ec) return std::nullopt;
+    auto size = std::filesystem::file_size(filename, ec);
+    if (ec) return std::nullopt;
+    return std::make_pair(static_cast<int64_t>(time.time_since_epoch().count()),
+                          static_cast<uint64_t>(size));
+#else
+    struct stat st {};
+    if (stat(filename.c_str(), &st) != 0) return std::nullopt;
+    return std::make_pair(static_cast<int64_t>(st.st_mtime), static_cast<uint64_t>(st.st_size));
+#endif
+}
+
+MappedFile::MappedFile(const std::string &filename) {
+#ifndef _WIN32
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw UserException(::format("Unable to open {0}", filename));
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw UserException(::format("Unable to stat {0}", filename));
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    if (size_ > 0) {
+        auto *ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            madvise(ptr, size_, MADV_SEQUENTIAL);
+            data_ = reinterpret_cast<const char *>(ptr);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0) return;
+#endif
+    // fallback
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.good()) throw UserException(::format("Unable to open {0}", filename));
+    buffer_ = std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped_) munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
 }  // namespace fs
 
 namespace string {
@@ -625,4 +808,101 @@ std::vector<std::string> get_tokens(const std::string &line, const std::string &
 
 }  // namespace string
 
+namespace mem {
+#ifdef __linux__
+// reads "<key>: <value> kB" from /proc/self/status
+static uint64_t read_proc_status(const std::string &key) {
+    std::ifstream stream("/proc/self/status");
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() &&
+            line[key.size()] == ':') {
+            return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+uint64_t current_rss() {
+#if defined(__linux__)
+    std::ifstream stream("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (!(stream >> size >> resident)) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#elif defined(__APPLE__)
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+uint64_t peak_rss() {
+#if defined(__linux__)
+    auto result = read_proc_status("VmHWM");
+    if (result) return result;
+#endif
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+bool reset_peak_rss() {
+#if defined(__linux__)
+    // writing 5 to clear_refs resets VmHWM to the current rss
+    std::ofstream stream("/proc/self/clear_refs");
+    if (!stream) return false;
+    stream << "5";
+    stream.flush();
+    return static_cast<bool>(stream);
+#else
+    return false;
+#endif
+}
+
+#ifdef KRATOS_COUNT_ALLOCATIONS
+static std::atomic<uint64_t> num_allocations = 0;
+static std::atomic<uint64_t> num_allocated_bytes = 0;
+
+bool allocation_counting() { return true; }
+uint64_t allocation_count() { return num_allocations.load(std::memory_order_relaxed); }
+uint64_t allocated_bytes() { return num_allocated_bytes.load(std::memory_order_relaxed); }
+
+static void *counted_allocate(std::size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    // malloc(0) is allowed to return nullptr
+    return std::malloc(size ? size : 1);
+}
+#else
+bool allocation_counting() { return false; }
+uint64_t allocation_count() { return 0; }
+uint64_t allocated_bytes() { return 0; }
+#endif
+}  // namespace mem
+
 }  // namespace kratos
+
+#ifdef KRATOS_COUNT_ALLOCATIONS
+// the array and nothrow forms of the default operator new and delete forward to these two
+void *operator new(std::size_t size) {
+    auto *ptr = kratos::mem::counted_allocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+#endif
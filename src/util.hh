@@ -4,8 +4,10 @@
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <optional>
 #include <regex>
 #include <sstream>
+#include <string_view>
 #include <thread>
 
 #include "except.hh"
@@ -50,6 +52,12 @@ std::vector<std::vector<uint32_t>> get_flatten_slices(const Var *var);
 std::map<std::string, std::shared_ptr<Port>> get_port_from_verilog(Generator *generator,
                                                                    const std::string &src,
                                                                    const std::string &top_name);
+// same as above, but the module index of the file is cached in the generator's context and
+// only re-computed when the file's modification time or size changes
+std::map<std::string, std::shared_ptr<Port>> get_port_from_verilog_file(
+    Generator *generator, const std::string &filename, const std::string &top_name);
+// [begin, end) offsets of every module definition in the source, keyed by module name
+VerilogModuleIndex index_verilog_modules(std::string_view src);
 
 bool inline is_2_power(uint64_t num) { return (num && (!(num & (num - 1)))); }
 
@@ -76,6 +84,27 @@ std::string get_ext(const std::string &filename);
 std::string abspath(const std::string &filename);
 std::string basename(const std::string &filename);
 char separator();
+// modification time and size of the file, used to invalidate per-file caches
+std::optional<std::pair<int64_t, uint64_t>> file_stamp(const std::string &filename);
+
+// read-only view of a file's content. uses mmap when available, otherwise the file is read
+// into memory
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::string_view content() const { return {data_, size_}; }
+    [[nodiscard]] uint64_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    uint64_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
 }  // namespace fs
 
 namespace string {
@@ -92,6 +121,23 @@ void trim(std::string &str);
 std::vector<std::string> get_tokens(const std::string &line, const std::string &delimiter);
 }  // namespace string
 
+namespace mem {
+// resident set size of the current process in bytes. 0 if the platform doesn't expose it
+uint64_t current_rss();
+// high-water mark of the resident set size in bytes since the last reset
+uint64_t peak_rss();
+// reset the high-water mark so that peak_rss() only covers what follows. returns false if
+// the platform doesn't allow it, in which case peak_rss() is the peak of the whole process.
+// the mark belongs to the process, so anything else reading VmHWM loses the earlier peak
+bool reset_peak_rss();
+
+// allocation counters from the global operator new, only available when kratos is built with
+// KRATOS_COUNT_ALLOCATIONS
+bool allocation_counting();
+uint64_t allocation_count();
+uint64_t allocated_bytes();
+}  // namespace mem
+
 }  // namespace kratos
 
 #endif  // KRATOS_UTIL_HH
@@ -4,6 +4,7 @@
 #include "../src/generator.hh"
 #include "../src/pass.hh"
 #include "../src/stmt.hh"
+#include "../src/util.hh"
 #include "gtest/gtest.h"
 
 using namespace kratos;
@@ -45,3 +46,119 @@ TEST(debug, inst) {  // NOLINT
     auto code = src.at("parent");
     EXPECT_TRUE(code.find("unq") == std::string::npos);
 }
+
+TEST(debug, save_database) {  // NOLINT
+    Context c;
+    auto &parent = c.generator("parent");
+    parent.debug = true;
+    // one cpu writes batches of 4 generators
+    for (auto i = 0; i < 6; i++) {
+        auto &child = c.generator("child");
+        child.debug = true;
+        auto &in = child.port(PortDirection::In, "in", 1);
+        auto &out = child.port(PortDirection::Out, "out", 1);
+        auto stmt = out.assign(in);
+        stmt->fn_name_ln.emplace_back(std::make_pair("test.py", 42));
+        child.add_stmt(stmt);
+        parent.add_child_generator("inst" + std::to_string(i), child.shared_from_this());
+    }
+    fix_assignment_type(&parent);
+
+    const std::string filename = "test_debug.db";
+    auto save = [&](int num_cpus) {
+        fs::remove(filename);
+        set_num_cpus(num_cpus);
+        DebugDatabase db;
+        db.set_break_points(&parent);
+        db.save_database(filename, true);
+        set_num_cpus(-1);
+        std::ifstream stream(filename);
+        return std::string((std::istreambuf_iterator<char>(stream)),
+                           std::istreambuf_iterator<char>());
+    };
+    // 7 generators are split into multiple batches
+    auto content = save(1);
+    // the output doesn't depend on how the modules are scheduled
+    EXPECT_EQ(save(4), content);
+    // section keys are kept next to the database, which only has the keys hgdb knows about
+    EXPECT_TRUE(fs::exists(filename + ".sections"));
+    EXPECT_FALSE(fs::exists(filename + ".variables"));
+    fs::remove(filename);
+    fs::remove(filename + ".sections");
+    EXPECT_EQ(content.find(R"({"generator":"kratos","top":"parent","table":[)"), 0);
+    EXPECT_EQ(content.find(R"("sections")"), std::string::npos);
+    EXPECT_NE(content.find(R"({"name":"inst5","module":"child"})"), std::string::npos);
+    EXPECT_NE(content.find(R"("filename":"test.py")"), std::string::npos);
+    EXPECT_NE(content.find(R"("type":"assign","line":42)"), std::string::npos);
+    EXPECT_NE(content.find(R"(,"reorder":false})"), std::string::npos);
+}
+
+TEST(debug, save_database_incremental) {  // NOLINT
+    Context c;
+    auto &parent = c.generator("parent");
+    parent.debug = true;
+    std::vector<Generator *> children;
+    for (auto i = 0; i < 2; i++) {
+        auto &child = c.generator("child" + std::to_string(i));
+        children.emplace_back(&child);
+        child.debug = true;
+        auto &in = child.port(PortDirection::In, "in", 1);
+        auto &out = child.port(PortDirection::Out, "out", 1);
+        auto stmt = out.assign(in);
+        stmt->fn_name_ln.emplace_back(std::make_pair("test.py", 42 + i));
+        child.add_stmt(stmt);
+        parent.add_child_generator("inst" + std::to_string(i), child.shared_from_this());
+    }
+    fix_assignment_type(&parent);
+    hash_generators_sequential(&parent);
+
+    const std::string filename = "test_debug_incremental.db";
+    auto read_file = [&]() {
+        std::ifstream stream(filename);
+        return std::string((std::istreambuf_iterator<char>(stream)),
+                           std::istreambuf_iterator<char>());
+    };
+    auto save = [&](const std::map<Generator *, std::map<std::string, std::string>> &mapping) {
+        DebugDatabase db;
+        db.set_break_points(&parent);
+        db.set_variable_mapping(mapping);
+        db.save_database(filename);
+    };
+
+    save({});
+    // tamper with the saved section so that we can tell whether it's copied over
+    auto content = read_file();
+    const std::string name = R"("name":"child0")";
+    auto pos = content.find(name);
+    ASSERT_NE(pos, std::string::npos);
+    content.replace(pos, name.size(), R"("name":"cached")");
+    {
+        std::ofstream stream(filename);
+        stream << content;
+    }
+
+    save({});
+    content = read_file();
+    EXPECT_NE(content.find(R"("name":"cached")"), std::string::npos);
+    EXPECT_NE(content.find(R"("name":"child1")"), std::string::npos);
+
+    // changes in the module invalidate its section
+    save({{children[0], {{"a", "1"}}}});
+    content = read_file();
+    EXPECT_EQ(content.find(R"("name":"cached")"), std::string::npos);
+    EXPECT_NE(content.find(R"("name":"child0")"), std::string::npos);
+
+    // ids of the rebuilt sections are given out again. out is shared by the mapping and the
+    // assignment so each child gets one id
+    for (auto i = 0; i < 4; i++) {
+        std::map<std::string, std::string> child0_mapping = {{"out", "out"}};
+        if (i % 2) child0_mapping.emplace("b", "1");
+        save({{children[0], child0_mapping}, {children[1], {{"out", "out"}}}});
+    }
+    content = read_file();
+    fs::remove(filename);
+    fs::remove(filename + ".sections");
+    EXPECT_NE(content.find(R"("id":"0")"), std::string::npos);
+    EXPECT_NE(content.find(R"("id":"1")"), std::string::npos);
+    EXPECT_EQ(content.find(R"("id":"2")"), std::string::npos);
+}
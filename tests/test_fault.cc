@@ -1,5 +1,6 @@
 #include <fmt/format.h>
 
+#include <fstream>
 #include <sstream>
 
 #include "../src/codegen.hh"
@@ -108,6 +109,23 @@ TEST(fault, parse_verilog_cov_file) {  // NOLINT
     EXPECT_EQ(cov.size(), 2);
 }
 
+TEST(fault, parse_verilog_cov_file_parallel) {  // NOLINT
+    Context c;
+    auto iter = create_verilator_mod(c);
+    auto &mod = iter.first;
+    generate_verilog(&mod);
+    mod.verilog_fn = "mod.sv";
+
+    // the file will be split into multiple chunks
+    set_num_cpus(4);
+    auto coverage = parse_verilator_coverage(&mod, "cov.dat");
+    set_num_cpus(-1);
+    auto if_ = iter.second->get_stmt(0)->as<IfStmt>();
+    EXPECT_EQ(coverage.size(), 2);
+    EXPECT_EQ(coverage.at(if_->then_body().get()), 1);
+    EXPECT_EQ(coverage.at(if_->else_body().get()), 3);
+}
+
 TEST(fault, produce_cov_xml) {  // NOLINT
     const std::string filename = "cov.dat";
     Context c;
@@ -170,4 +188,98 @@ TEST(fault, parse_icc_cov_file) {  // NOLINT
     for (auto const &iter : result) {
         EXPECT_TRUE(iter.first->type() == StatementType::Block);
     }
-}
\ No newline at end of file
+
+    // the file sections are indented by more than a chunk, which used to stall the split
+    std::ifstream stream("icc_cov.txt");
+    std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const std::string indent(64, ' ');
+    for (auto pos = content.find("File name:"); pos != std::string::npos;
+         pos = content.find("File name:", pos + indent.size() + 1)) {
+        content.insert(pos, indent);
+    }
+    std::ofstream("icc_cov_indented.txt") << content;
+    set_num_cpus(64);
+    auto indented_result = parse_icc_coverage(&mod, "icc_cov_indented.txt");
+    set_num_cpus(-1);
+    std::remove("icc_cov_indented.txt");
+    EXPECT_EQ(indented_result, result);
+}
+
+TEST(fault, load_state) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 4);
+    auto &out = mod.port(PortDirection::Out, "out", 4);
+    mod.add_stmt(out.assign(in));
+
+    auto run = std::make_shared<SimulationRun>(&mod);
+    run->add_simulation_state({{"mod.in", 1}, {"mod.out", 1}});
+    run->add_simulation_state({{"mod.in", 2}});
+    EXPECT_EQ(run->num_states(), 2);
+
+    auto *state = run->get_state(1);
+    EXPECT_EQ(*state->get(&in), 2);
+    EXPECT_FALSE(state->get(&out));
+    state = run->get_state(0);
+    EXPECT_EQ(*state->get(&in), 1);
+    EXPECT_EQ(*state->get(&out), 1);
+    EXPECT_EQ(run->get_state(2), nullptr);
+}
+
+TEST(fault, parallel_runs) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 4);
+    auto &out = mod.port(PortDirection::Out, "out", 4);
+    auto comb = std::make_shared<CombinationalStmtBlock>();
+    mod.add_stmt(comb);
+    auto if_ = std::make_shared<IfStmt>(in > constant(2, 4));
+    comb->add_stmt(if_);
+    if_->add_then_stmt(out.assign(constant(4, 4)));
+    if_->add_else_stmt(out.assign(in));
+
+    set_num_cpus(4);
+    FaultAnalyzer fault(&mod);
+    // correct runs only take the else branch
+    for (auto i = 0; i < 16; i++) {
+        auto run = std::make_shared<SimulationRun>(&mod);
+        run->add_simulation_state({{"mod.in", i % 3}});
+        if (i % 4 == 0) {
+            run->add_simulation_state({{"mod.in", 3}});
+            run->mark_wrong_value("mod.out");
+        }
+        fault.add_simulation_run(run);
+    }
+    auto result = fault.compute_fault_stmts_from_coverage();
+    set_num_cpus(-1);
+    EXPECT_EQ(result.size(), 1);
+    EXPECT_TRUE(result.find(if_->then_body().get()) != result.end());
+    EXPECT_EQ(fault.compute_coverage(0).size(), 2);
+    EXPECT_EQ(fault.compute_coverage(1).size(), 1);
+}
+
+TEST(fault, bulk_state) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &child = c.generator("child");
+    mod.add_child_generator("inst", child.shared_from_this());
+    auto &in = child.port(PortDirection::In, "in", 4);
+    auto &out = child.var("out", 4, 2);
+    out.set_is_packed(false);
+
+    auto run = std::make_shared<SimulationRun>(&mod);
+    run->set_signal_names({"mod.inst.in", "mod.inst.out.1"});
+    run->add_simulation_state(std::vector<int64_t>{1, 2});
+    run->add_simulation_state(std::vector<int64_t>{3, 4});
+    EXPECT_THROW(run->add_simulation_state(std::vector<int64_t>{1}), UserException);
+    EXPECT_THROW(run->set_signal_names({"mod.inst.in", "mod.inst.in2"}), UserException);
+    // the names from before are kept
+    run->add_simulation_state(std::vector<int64_t>{5, 6});
+
+    auto *state = run->get_state(1);
+    EXPECT_EQ(*state->get(&in), 3);
+    EXPECT_EQ(*state->get(&out[1]), 4);
+    state = run->get_state(2);
+    EXPECT_EQ(*state->get(&in), 5);
+    EXPECT_EQ(*state->get(&out[1]), 6);
+}
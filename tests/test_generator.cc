@@ -5,6 +5,7 @@
 #include "../src/fsm.hh"
 #include "../src/generator.hh"
 #include "../src/interface.hh"
+#include "../src/synthetic.hh"
 #include "../src/util.hh"
 #include "gtest/gtest.h"
 
@@ -27,6 +28,55 @@ TEST(generator, load) {  // NOLINT
     EXPECT_TRUE(mod.get_port("output_port") != nullptr);
 }
 
+TEST(generator, load_index) {  // NOLINT
+    auto src = R"(
+// module fake(a);
+/* module fake2(b); endmodule */
+module mod1(input a, output b); endmodule
+module mod2(input c);
+    initial $display("endmodule module fake3");
+endmodule
+`define module_name mod3
+macromodule mod4(output d, input e);
+endmodule
+)";
+    auto index = index_verilog_modules(src);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_EQ(index.count("fake"), 0);
+    auto const &[begin, end] = index.at("mod2");
+    auto def = std::string(src).substr(begin, end - begin);
+    EXPECT_EQ(def.find("module mod2"), 0);
+    EXPECT_EQ(def.substr(def.size() - 9), "endmodule");
+    EXPECT_EQ(index.count("mod4"), 1);
+
+    // file index is refreshed when the file changes
+    auto filename = fs::join(fs::temp_directory_path(), "test_load_index.sv");
+    {
+        std::ofstream stream(filename);
+        stream << src;
+    }
+    Context c;
+    auto &mod = Generator::from_verilog(&c, filename, "mod1", {}, {});
+    EXPECT_NE(mod.get_port("b"), nullptr);
+    auto &mod4 = Generator::from_verilog(&c, filename, "mod4", {}, {});
+    EXPECT_NE(mod4.get_port("e"), nullptr);
+    {
+        std::ofstream stream(filename);
+        stream << "module mod5(input f); endmodule\n";
+    }
+    auto &mod5 = Generator::from_verilog(&c, filename, "mod5", {}, {});
+    EXPECT_NE(mod5.get_port("f"), nullptr);
+    EXPECT_THROW(Generator::from_verilog(&c, filename, "mod1", {}, {}), std::runtime_error);
+    // the index lives in the context
+    auto path = fs::abspath(filename);
+    auto stamp = *fs::file_stamp(filename);
+    EXPECT_NE(c.get_verilog_module_index(path, stamp), nullptr);
+    EXPECT_EQ(Context().get_verilog_module_index(path, stamp), nullptr);
+    c.clear();
+    EXPECT_EQ(c.get_verilog_module_index(path, stamp), nullptr);
+    fs::remove(filename);
+}
+
 TEST(generator, port) {  // NOLINT
     Context c;
     auto &mod = c.generator("mod");
@@ -728,6 +778,73 @@ TEST(codegen, copy_port_definition) {  // NOLINT
     EXPECT_NE(mod_src.find("input logic [15:0] in [(P * 32'h2)-1:0]"), std::string::npos);
 }
 
+TEST(codegen, stream_verilog) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 8);
+    auto &out = mod.port(PortDirection::Out, "out", 8);
+    // two generators named child with different content
+    auto &leaf = c.generator("leaf");
+    auto &leaf_in = leaf.port(PortDirection::In, "in", 8);
+    auto &leaf_out = leaf.port(PortDirection::Out, "out", 8);
+    leaf.add_stmt(leaf_out.assign(leaf_in + constant(1, 8)));
+    auto &child1 = c.generator("child");
+    auto &child1_in = child1.port(PortDirection::In, "in", 8);
+    auto &child1_out = child1.port(PortDirection::Out, "out", 8);
+    child1.add_child_generator("leaf", leaf);
+    child1.add_stmt(leaf_in.assign(child1_in));
+    child1.add_stmt(child1_out.assign(leaf_out));
+    auto &child2 = c.generator("child");
+    auto &child2_in = child2.port(PortDirection::In, "in", 8);
+    auto &child2_out = child2.port(PortDirection::Out, "out", 8);
+    child2.add_stmt(child2_out.assign(~child2_in));
+    mod.add_child_generator("inst1", child1);
+    mod.add_child_generator("inst2", child2);
+    auto &w = mod.var("w", 8);
+    mod.add_stmt(child1_in.assign(in));
+    mod.add_stmt(w.assign(child1_out));
+    mod.add_stmt(child2_in.assign(w));
+    mod.add_stmt(out.assign(child2_out));
+
+    // the first child is finalized before the rest of the design
+    fix_assignment_type(&child1);
+    hash_generators(&child1, HashStrategy::SequentialHash);
+    uniquify_generators(&child1);
+    create_module_instantiation(&child1);
+    SystemVerilogCodeGenOptions options;
+    options.output_dir = fs::temp_directory_path();
+    auto names = stream_verilog(&child1, options);
+    EXPECT_EQ(names, std::vector<std::string>({"child", "leaf"}));
+    auto child_filename = fs::join(options.output_dir, "child.sv");
+    auto leaf_filename = fs::join(options.output_dir, "leaf.sv");
+    EXPECT_TRUE(fs::exists(child_filename));
+    EXPECT_TRUE(fs::exists(leaf_filename));
+    fs::remove(child_filename);
+    fs::remove(leaf_filename);
+    // only the ports are left
+    EXPECT_TRUE(child1.external());
+    EXPECT_EQ(child1.stmts_count(), 0);
+    EXPECT_EQ(child1.get_child_generator_size(), 0);
+    EXPECT_EQ(child1.get_port_names().size(), 2);
+    EXPECT_TRUE(c.get_generators_by_name("leaf").empty());
+
+    fix_assignment_type(&mod);
+    hash_generators(&mod, HashStrategy::SequentialHash);
+    uniquify_generators(&mod);
+    create_module_instantiation(&mod);
+    // the streamed modules don't include a package
+    SystemVerilogCodeGenOptions pkg_options;
+    pkg_options.package_name = "mod_pkg";
+    EXPECT_THROW(generate_verilog(&mod, pkg_options), UserException);
+    auto src = generate_verilog(&mod);
+    // the streamed module keeps its name and is not generated again
+    EXPECT_EQ(src.size(), 2);
+    EXPECT_EQ(src.count("child_unq0"), 1);
+    auto mod_src = src.at("mod");
+    EXPECT_NE(mod_src.find("child inst1"), std::string::npos);
+    EXPECT_NE(mod_src.find("child_unq0 inst2"), std::string::npos);
+}
+
 TEST(generator, unwire) {  // NOLINT
     Context c;
     auto &mod = c.generator("mod");
@@ -741,4 +858,215 @@ TEST(generator, unwire) {  // NOLINT
     EXPECT_EQ(mod.stmts_count(), 1);
     mod.unwire(b, a);
     EXPECT_EQ(mod.stmts_count(), 0);
-}
\ No newline at end of file
+}
+
+TEST(generator, batch) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    mod.debug = true;
+    auto ins = mod.port_batch(PortDirection::In, {"a", "b"}, {4}, PortType::Data, false,
+                              {{"test.py", 1}});
+    auto outs = mod.port_batch(PortDirection::Out, {"c", "d"}, {4, 4});
+    auto vars = mod.var_batch({"e", "f"}, {4, 2});
+    EXPECT_EQ(ins.size(), 2);
+    EXPECT_EQ(ins[1]->width(), 4);
+    EXPECT_EQ(vars[1]->width(), 2);
+    EXPECT_EQ(ins[0]->fn_name_ln.size(), 1);
+    EXPECT_EQ(ins[0]->fn_name_ln[0].first, "test.py");
+    EXPECT_THROW(mod.var_batch({"g", "h"}, {1, 2, 3}), UserException);
+
+    // direction is corrected for ports
+    auto stmts = mod.wire_batch({ins[0], outs[1]}, {outs[0], ins[1]});
+    EXPECT_EQ(stmts.size(), 2);
+    EXPECT_EQ(stmts[0]->left(), outs[0]);
+    EXPECT_EQ(mod.stmts_count(), 2);
+    EXPECT_THROW(mod.wire_batch({ins[0]}, {}), UserException);
+
+    auto comb = mod.combinational();
+    mod.assign_batch(comb.get(), {vars[0]}, {ins[0]}, AssignmentType::Blocking);
+    EXPECT_EQ(comb->size(), 1);
+    EXPECT_EQ(mod.stmts_count(), 3);
+}
+
+TEST(generator, clone_materialize) {  // NOLINT
+    Context c;
+    auto &def = c.generator("mod");
+    auto &in = def.port(PortDirection::In, "in", 4);
+    auto &out = def.port(PortDirection::Out, "out", 4);
+    auto &sel = def.port(PortDirection::In, "sel", 1);
+    auto &v = def.var("v", 4);
+    auto &child = c.generator("child");
+    auto &child_in = child.port(PortDirection::In, "in", 4);
+    auto &child_out = child.port(PortDirection::Out, "out", 4);
+    child.add_stmt(child_out.assign(child_in));
+    def.add_child_generator("inst", child.shared_from_this());
+    def.add_stmt(child_in.assign(in));
+    auto comb = def.combinational();
+    auto if_ = std::make_shared<IfStmt>(sel);
+    if_->add_then_stmt(v.assign(child_out + in));
+    if_->add_else_stmt(v.assign(in[{3, 2}].concat(in[{1, 0}])));
+    comb->add_stmt(if_);
+    def.add_stmt(out.assign(v));
+
+    auto clone = def.clone();
+    // clones only have the interface
+    EXPECT_TRUE(clone->is_cloned());
+    EXPECT_EQ(clone->stmts_count(), 0);
+    EXPECT_EQ(clone->get_child_generator_size(), 0);
+
+    // changing the clone gives it a private copy of the content
+    auto &top = c.generator("top");
+    top.add_child_generator("inst", clone);
+    auto &extra = clone->var("extra", 4);
+    clone->add_stmt(extra.assign(clone->get_port("in")));
+    EXPECT_FALSE(clone->is_cloned());
+    EXPECT_EQ(clone->stmts_count(), def.stmts_count() + 1);
+    EXPECT_EQ(clone->get_child_generator_size(), 1);
+    auto *new_child = clone->get_child_generator("inst");
+    EXPECT_NE(new_child, &child);
+    EXPECT_TRUE(new_child->is_cloned());
+    auto stmt = clone->get_stmt(0)->as<AssignStmt>();
+    EXPECT_EQ(stmt->left(), new_child->get_port("in").get());
+    EXPECT_EQ(stmt->right(), clone->get_port("in").get());
+    auto new_if = clone->get_stmt(1)->as<CombinationalStmtBlock>()->get_stmt(0)->as<IfStmt>();
+    EXPECT_EQ(new_if->predicate(), clone->get_port("sel"));
+    auto then_stmt = new_if->then_body()->get_stmt(0)->as<AssignStmt>();
+    EXPECT_EQ(then_stmt->left(), clone->get_var("v").get());
+    auto *expr = reinterpret_cast<Expr *>(then_stmt->right());
+    EXPECT_EQ(expr->left, new_child->get_port("out").get());
+    EXPECT_EQ(expr->generator(), clone.get());
+    // the definition is not touched
+    EXPECT_EQ(def.get_child_generator("inst"), &child);
+    EXPECT_EQ(comb->size(), 1);
+    for (auto const &port_name : clone->get_port_names()) {
+        auto port = clone->get_port(port_name);
+        auto &top_port = top.port(port->port_direction(), port_name, port->width());
+        if (port->port_direction() == PortDirection::In) {
+            top.wire(*port, top_port);
+        } else {
+            top.wire(top_port, *port);
+        }
+    }
+    fix_assignment_type(&top);
+    create_module_instantiation(&top);
+    auto src = generate_verilog(&top);
+    EXPECT_NE(src.at("mod").find("assign extra = in;"), std::string::npos);
+}
+
+TEST(generator, clone_materialize_failure) {  // NOLINT
+    Context c;
+    auto &def = c.generator("mod");
+    auto &in = def.port(PortDirection::In, "in", 4);
+    auto &out = def.port(PortDirection::Out, "out", 4);
+    def.add_stmt(out.assign(in));
+    auto clone = def.clone();
+    // the clone doesn't have the parameter added after cloning
+    def.parameter("P", 4);
+    EXPECT_THROW(clone->materialize(), GeneratorException);
+    // nothing is copied and the clone still reads from its definition
+    EXPECT_TRUE(clone->is_cloned());
+    EXPECT_TRUE(clone->external());
+    EXPECT_EQ(clone->stmts_count(), 0);
+    EXPECT_EQ(clone->get_child_generator_size(), 0);
+
+    // content that can't be copied stays with the definition when the clone is changed
+    auto &def2 = c.generator("mod2");
+    def2.port(PortDirection::In, "in", 4);
+    def2.function("func");
+    EXPECT_FALSE(def2.can_copy_content());
+    auto clone2 = def2.clone();
+    auto &extra = clone2->var("extra", 4);
+    EXPECT_NO_THROW(clone2->add_stmt(extra.assign(clone2->get_port("in"))));
+    EXPECT_TRUE(clone2->is_cloned());
+    EXPECT_THROW(clone2->materialize(), GeneratorException);
+}
+
+TEST(generator, cache) {  // NOLINT
+    using ValueType = GeneratorCacheKey::ValueType;
+    Context c;
+    auto &mod1 = c.generator("mod");
+    auto &mod2 = c.generator("mod");
+    GeneratorCacheKey key1("Mod");
+    key1.add("width", GeneratorCacheKey::encode(ValueType::Int, "1"));
+    key1.add("name", GeneratorCacheKey::encode(ValueType::Str, "a"));
+    // parameter order does not matter
+    GeneratorCacheKey key2("Mod");
+    key2.add("name", GeneratorCacheKey::encode(ValueType::Str, "a"));
+    key2.add("width", GeneratorCacheKey::encode(ValueType::Int, "1"));
+    EXPECT_EQ(key1.canonical(), key2.canonical());
+    EXPECT_EQ(key1.digest(), key2.digest());
+    EXPECT_THROW(key2.add("width", GeneratorCacheKey::encode(ValueType::Int, "2")),
+                 UserException);
+    // types are part of the key
+    GeneratorCacheKey key3("Mod");
+    key3.add("width", GeneratorCacheKey::encode(ValueType::Str, "1"));
+    key3.add("name", GeneratorCacheKey::encode(ValueType::Str, "a"));
+    EXPECT_NE(key1.canonical(), key3.canonical());
+    // sets are unordered, lists are not
+    auto a = GeneratorCacheKey::encode(ValueType::Int, "1");
+    auto b = GeneratorCacheKey::encode(ValueType::Int, "2");
+    EXPECT_EQ(GeneratorCacheKey::encode(ValueType::Set, {a, b}),
+              GeneratorCacheKey::encode(ValueType::Set, {b, a}));
+    EXPECT_NE(GeneratorCacheKey::encode(ValueType::List, {a, b}),
+              GeneratorCacheKey::encode(ValueType::List, {b, a}));
+    // nesting is unambiguous
+    EXPECT_NE(GeneratorCacheKey::encode(ValueType::List, {a, b}),
+              GeneratorCacheKey::encode(
+                  ValueType::List, {GeneratorCacheKey::encode(ValueType::List, {a}), b}));
+
+    EXPECT_EQ(c.get_cached_generator(key1), nullptr);
+    c.add_cached_generator(key1, mod1.shared_from_this());
+    c.add_cached_generator(key3, mod2.shared_from_this());
+    EXPECT_EQ(c.get_cached_generator(key2).get(), &mod1);
+    EXPECT_EQ(c.get_cached_generator(key3).get(), &mod2);
+    EXPECT_EQ(c.generator_cache_size(), 2);
+    c.clear();
+    EXPECT_EQ(c.generator_cache_size(), 0);
+}
+
+TEST(generator, synthesize_design) {  // NOLINT
+    auto synthesize = [](double duplication_ratio, std::vector<uint64_t> *hashes = nullptr) {
+        Context c;
+        SyntheticDesignOptions options;
+        options.fanout = 3;
+        options.depth = 3;
+        options.duplication_ratio = duplication_ratio;
+        options.max_width = 16;
+        options.seed = 42;
+        auto &top = synthesize_design(&c, options);
+        fix_assignment_type(&top);
+        check_multiple_driver(&top);
+        check_inferred_latch(&top);
+        check_combinational_loop(&top);
+        hash_generators(&top, HashStrategy::SequentialHash);
+        if (hashes) {
+            for (auto const &name : c.get_generator_names()) {
+                for (auto const &gen : c.get_generators_by_name(name))
+                    hashes->emplace_back(c.get_hash(gen.get()));
+            }
+            std::sort(hashes->begin(), hashes->end());
+        }
+        uniquify_generators(&top);
+        create_module_instantiation(&top);
+        return generate_verilog(&top);
+    };
+    // same options, same design
+    std::vector<uint64_t> hashes1, hashes2;
+    auto src = synthesize(0.5, &hashes1);
+    synthesize(0.5, &hashes2);
+    EXPECT_EQ(hashes1.size(), 1 + 3 + 9 + 27);
+    EXPECT_EQ(hashes1, hashes2);
+    EXPECT_LT(src.size(), hashes1.size());
+    EXPECT_TRUE(src.find("top") != src.end());
+    EXPECT_TRUE(src.find("level3") != src.end());
+    // every level reuses the first module
+    EXPECT_EQ(synthesize(1).size(), 4);
+    // every instance is a new module
+    EXPECT_EQ(synthesize(0).size(), 1 + 3 + 9 + 27);
+
+    Context c;
+    SyntheticDesignOptions options;
+    options.min_width = 8;
+    options.max_width = 4;
+    EXPECT_THROW(synthesize_design(&c, options), UserException);
+}
@@ -215,6 +215,67 @@ def test_for_bit_index():
     assert "out[2'(i)] = 1'h1;" in src
 
 
+def test_transform_cache():
+    from kratos.pyast import get_block_source
+
+    class Mod(Generator):
+        def __init__(self, num_loop, name):
+            super().__init__(name)
+            self.out_ = self.output("out", 4)
+            self.num_loop = num_loop
+
+            self.add_always(self.code)
+
+        @always_comb
+        def code(self):
+            if self.num_loop > 2:
+                self.out_ = 1
+            else:
+                self.out_ = 0
+
+    source = get_block_source(Mod.code.fn)
+    assert get_block_source(Mod.code.fn) is source
+    mod1 = Mod(4, "mod1")
+    mod2 = Mod(4, "mod2")
+    mod3 = Mod(1, "mod3")
+    assert "out = 4'h1;" in verilog(mod1)["mod1"]
+    assert "out = 4'h1;" in verilog(mod2)["mod2"]
+    # different static elaboration input
+    assert "out = 4'h0;" in verilog(mod3)["mod3"]
+    Generator.clear_context()
+    assert get_block_source(Mod.code.fn) is not source
+
+
+def test_static_signature():
+    from types import SimpleNamespace, MethodType
+    from kratos.pyast import compute_static_signature
+    calls = []
+
+    class Config:
+        @property
+        def enabled(self):
+            calls.append(self)
+            return True
+
+    mod = Generator("mod")
+    mod.config = Config()
+    source = SimpleNamespace(static_inputs=[
+        ("self.config.enabled", ["self", "config", "enabled"])])
+    # user properties are not evaluated and the block is not cached
+    assert compute_static_signature(source, mod, {}, {}) is None
+    assert not calls
+    # objects compared by identity are kept alive with the signature
+    source.static_inputs = [("self.config", ["self", "config"])]
+    signature, refs = compute_static_signature(source, mod, {}, {})
+    assert refs == [mod.config]
+    assert signature == (("self.config", ("obj", id(mod.config))),)
+    # methods can depend on any state of the generator, e.g. a list
+    mod.widths = [1, 2]
+    mod.helper = MethodType(lambda self: self.widths[0], mod)
+    source.static_inputs = [("self.helper", ["self", "helper"])]
+    assert compute_static_signature(source, mod, {}, {}) is None
+
+
 def test_switch(check_gold):
     class Switch(Generator):
         def __init__(self):
@@ -418,15 +479,32 @@ def test_create(check_gold):
     assert not mod2.is_cloned
     assert mod3.is_cloned
     assert mod3.def_instance == mod1
+    # the clone is only a header until it's changed
+    assert mod3.internal_generator.stmts_count() == 0
 
     # modify mod 3
     mod3.initialize_clone()
     mod3.in_.width = 3
     mod3.out_.width = 3
     assert not mod3.is_cloned
+    assert mod3.internal_generator.stmts_count() == 1
     check_gold(mod3, "test_create")
 
 
+def test_create_fallback():
+    class Mod(Generator):
+        def __init__(self, width):
+            super().__init__(f"mod_enum_{width}")
+            self.in_ = self.input("in", width)
+            self.enum("color", {"red": 0, "blue": 1})
+
+    mod1 = Mod.create(width=1)
+    # enums can't be copied to a clone, so a full instance is built instead
+    mod2 = Mod.create(width=1)
+    assert not mod2.is_cloned
+    assert mod2.internal_generator is not mod1.internal_generator
+
+
 @pytest.mark.skipif(no_verilator, reason="verilator not available")
 def test_clone():
     class Mod2(Generator):
@@ -1878,6 +1956,158 @@ def test_initial_stmt_raw_statement():
     assert "  // cool cool cool\n" in src
 
 
+def test_stream_verilog():
+    mod = Generator("mod")
+    child = Generator("child")
+    child_in = child.input("in", 4)
+    # only used inside the streamed module
+    struct = PackedStruct("child_data", [("value", 4)])
+    data = child.var_packed("data", struct)
+    child.wire(data["value"], child_in)
+    child.wire(child.output("out", 4), data["value"] + 1)
+    mod.add_child("child", child)
+    mod.wire(child.ports["in"], mod.input("a", 4))
+    mod.wire(mod.output("b", 4), child.ports["out"])
+
+    with tempfile.TemporaryDirectory() as temp:
+        options = kratos.SystemVerilogCodeGenOptions()
+        options.output_dir = temp
+        # the package is required since it's written out with the top
+        try:
+            verilog(child, codegen_options=options, stream=True)
+            assert False
+        except ValueError:
+            pass
+        options.package_name = "mod_pkg"
+        names = verilog(child, codegen_options=options, stream=True)
+        assert names == ["child"]
+        with open(os.path.join(temp, "child.sv")) as f:
+            assert "import mod_pkg::*;" in f.read()
+        # only the ports are left
+        assert child.internal_generator.external()
+        assert child.internal_generator.stmts_count() == 0
+
+        verilog(mod, codegen_options=options)
+        with open(os.path.join(temp, "mod.sv")) as f:
+            assert "child child (" in f.read()
+        with open(os.path.join(temp, "mod_pkg.svh")) as f:
+            assert "child_data" in f.read()
+
+
+def test_lazy_body():
+    class Child(Generator):
+        def __init__(self, name):
+            super().__init__(name)
+            self.output("out", 1)
+            self.built = False
+            self.set_lazy_body(self.build)
+
+        def build(self):
+            self.built = True
+            self.wire(self.ports.out, const(1, 1))
+
+    mod = Generator("mod")
+    used, unused = Child("used"), Child("unused")
+    mod.add_child("used", used)
+    mod.add_child("unused", unused)
+    mod.wire(mod.output("out", 1), used.ports.out)
+    assert used.is_lazy
+
+    src = verilog(mod)
+    assert used.built and not unused.built
+    # the body of the removed child is dropped so it doesn't keep the child alive
+    assert not unused.is_lazy
+    assert "used" in src and "unused" not in src
+    assert "out = 1'h1;" in src["used"]
+
+
+def test_fold_parameters():
+    class Child(Generator):
+        def __init__(self, value):
+            super().__init__("child")
+            in_ = self.input("in", 4)
+            self.wire(self.output("out", 4), in_ + value)
+
+    mod = Generator("mod")
+    in_ = mod.input("in", 4)
+    out = mod.output("out", 4)
+    for i in range(4):
+        child = Child(i + 1)
+        mod.add_child("child{0}".format(i), child)
+        mod.wire(child.ports["in"], in_)
+        mod.wire(out[i], child.ports.out[0])
+
+    src = verilog(mod, fold_parameters=True)
+    assert len(src) == 2
+    assert "parameter CONST_0 = 4'h1" in src["child"]
+    assert ".CONST_0(4'h4)" in src["mod"]
+
+
+def test_synthesize():
+    top = Generator.synthesize(fanout=2, depth=2, duplication_ratio=1,
+                               stmt_weights={"switch": 0}, max_width=8,
+                               seed=1)
+    assert top.name == "top"
+    src = verilog(top)
+    assert set(src.keys()) == {"top", "level1", "level2"}
+    assert "case" not in src["level2"]
+
+
+def test_pass_perf(capfd):
+    mod = Generator("mod")
+    mod.wire(mod.output("out", 4), mod.input("in", 4))
+    results = []
+    verilog(mod, pass_perf_results=results)
+    # the results are not printed unless collect_pass_perf is set
+    assert "[name]" not in capfd.readouterr().out
+    names = [perf.name for perf in results]
+    assert names.index("fix_assignment_type") < \
+        names.index("uniquify_generators")
+    for perf in results:
+        assert perf.time >= 0
+        assert perf.peak_rss >= perf.rss_after
+
+
+def test_ir_stats():
+    c = Generator.get_context()
+    c.reset_ir_stats()
+    mod = Generator("mod")
+    in_ = mod.input("in", 4)
+    mod.wire(mod.output("out", 4), in_[1, 0].concat(in_[3, 2]))
+    verilog(mod)
+    stats = c.ir_stats()
+    if not c.ir_stats_enabled:
+        assert stats.node_visits == 0
+        assert not stats.pass_visits
+        return
+    assert stats.stmts_added >= 1
+    assert stats.slice_cache_misses >= 2
+    assert stats.node_visits > 0
+    assert sum(stats.pass_visits.values()) <= stats.node_visits
+    assert "fix_assignment_type" in stats.pass_visits
+    c.reset_ir_stats()
+    assert c.ir_stats().node_visits == 0
+
+
+def test_assign_batch():
+    mod = Generator("mod", debug=True)
+    ins = mod.port_batch(["a", "b"], [4, 4], PortDirection.In)
+    outs = mod.var_batch(["c", "d"], [4, 4])
+    stmts = mod.assign_batch(outs, ins)
+    assert len(stmts) == 2
+    assert mod.stmts_count == 2
+    assert stmts[0].left.name == "c"
+    assert len(stmts[0].fn_name_ln) == 1
+
+    comb = mod.combinational()
+    wires = mod.var_batch(["e", "f"], 4)
+    stmts = mod.assign_batch(wires, outs, comb,
+                             kratos.AssignmentType.Blocking)
+    assert len(stmts) == 2
+    assert mod.stmts_count == 3
+    assert len(comb.stmt()) == 2
+
+
 if __name__ == "__main__":
     from conftest import check_gold_fn, check_file_fn
     test_function(check_gold_fn)
@@ -1,6 +1,12 @@
+#include <cstring>
+
+#include "../src/codegen.hh"
 #include "../src/context.hh"
+#include "../src/except.hh"
 #include "../src/expr.hh"
 #include "../src/generator.hh"
+#include "../src/pass.hh"
+#include "../src/serialize.hh"
 #include "../src/stmt.hh"
 #include "gtest/gtest.h"
 
@@ -84,4 +90,215 @@ TEST(ir, pre_stmt) {
 
     EXPECT_EQ(stmt2->pre_stmt(), stmt1.get());
     EXPECT_EQ(stmt1->pre_stmt(), nullptr);
-}
\ No newline at end of file
+}
+
+TEST(ir, source_locations) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &a = mod.var("a", 1);
+    auto &b = mod.var("b", 1);
+    a.fn_name_ln.emplace_back("test.py", 1);
+    a.fn_name_ln.emplace_back(std::make_pair("test.py", 2));
+    b.fn_name_ln.emplace_back("test.py", 3);
+    // file names are interned
+    EXPECT_EQ(a.fn_name_ln.entries()[0].first, b.fn_name_ln.entries()[0].first);
+    EXPECT_EQ(&a.fn_name_ln[1].first, &b.fn_name_ln.front().first);
+    EXPECT_EQ(a.fn_name_ln[1].second, 2);
+
+    b.fn_name_ln.insert(b.fn_name_ln.begin(), std::make_pair("other.py", 4));
+    b.fn_name_ln.insert(b.fn_name_ln.end(), a.fn_name_ln.begin(), a.fn_name_ln.end());
+    auto entries = std::vector<std::pair<std::string, uint32_t>>(b.fn_name_ln);
+    std::vector<std::pair<std::string, uint32_t>> expected = {
+        {"other.py", 4}, {"test.py", 3}, {"test.py", 1}, {"test.py", 2}};
+    EXPECT_EQ(entries, expected);
+    // the node only holds the ids
+    EXPECT_EQ(sizeof(a.fn_name_ln), sizeof(std::vector<std::pair<uint32_t, uint32_t>>));
+
+    // the live contexts share one table, so ids are copied across them as is
+    Context c2;
+    EXPECT_EQ(c2.source_files(), c.source_files());
+    auto &d = c2.generator("mod").var("d", 1);
+    d.fn_name_ln.insert(d.fn_name_ln.end(), b.fn_name_ln.begin(), b.fn_name_ln.end());
+    EXPECT_EQ(d.fn_name_ln.entries(), b.fn_name_ln.entries());
+    EXPECT_EQ(decltype(entries)(d.fn_name_ln), expected);
+
+    // detached statements use the same table
+    auto comment = std::make_shared<CommentStmt>("comment");
+    comment->fn_name_ln.emplace_back("test.py", 5);
+    EXPECT_EQ(comment->fn_name_ln.entries()[0].first, a.fn_name_ln.entries()[0].first);
+    mod.add_stmt(comment);
+    EXPECT_EQ(comment->fn_name_ln[0].first, "test.py");
+}
+
+namespace {
+Generator &build_serialize_design(Context &c) {
+    auto &child = c.generator("child");
+    auto &width = child.parameter("WIDTH", 32);
+    width.set_value(8);
+    auto &in = child.port(PortDirection::In, "in", 8);
+    auto &out = child.port(PortDirection::Out, "out", 8);
+    child.add_stmt(out.assign(in + constant(1, 8)));
+
+    auto &mod = c.generator("mod");
+    auto &param = mod.parameter("P", 32);
+    param.set_value(4);
+    auto &clk = mod.port(PortDirection::In, "clk", 1, 1, PortType::Clock, false);
+    auto &a = mod.port(PortDirection::In, "a", 8);
+    auto &o = mod.port(PortDirection::Out, "o", 8);
+    auto &v = mod.var("v", 8);
+    auto &w = mod.var("w", 4, 2);
+    v.comment = "register";
+    v.fn_name_ln.emplace_back("test.py", 42);
+    auto attr = std::make_shared<Attribute>();
+    attr->type_str = "note";
+    attr->value_str = "value";
+    v.add_attribute(attr);
+
+    mod.add_child_generator("inst", child.shared_from_this());
+    mod.add_stmt(in.assign(a));
+    mod.add_stmt(o.assign(out ^ v));
+
+    auto seq = mod.sequential();
+    seq->add_condition({EventEdgeType::Posedge, clk.shared_from_this()});
+    auto if_ = std::make_shared<IfStmt>(a[0].shared_from_this());
+    if_->add_then_stmt(v.assign(a + param));
+    if_->add_else_stmt(v.assign(a[{3, 0}].concat(a[{7, 4}])));
+    seq->add_stmt(if_);
+    seq->add_stmt(std::make_shared<CommentStmt>("update v"));
+
+    auto comb = mod.combinational();
+    auto switch_ = std::make_shared<SwitchStmt>(a[{1, 0}].shared_from_this());
+    switch_->add_switch_case(constant(0, 2).as<Const>(), w[0].assign(a[{3, 0}]));
+    switch_->add_switch_case(nullptr, w[0].assign(constant(0, 4)));
+    comb->add_stmt(switch_);
+    auto for_ = std::make_shared<ForStmt>("i", 0, 4, 1);
+    comb->add_stmt(for_);
+    for_->add_stmt(w[1][for_->get_iter_var()].assign(a[for_->get_iter_var()]));
+    return mod;
+}
+
+std::string generate_module(Generator &mod) {
+    fix_assignment_type(&mod);
+    create_module_instantiation(&mod);
+    auto src = generate_verilog(&mod);
+    return src.at("mod") + src.at("child");
+}
+}  // namespace
+
+TEST(ir, serialize) {  // NOLINT
+    Context c1;
+    auto &mod1 = build_serialize_design(c1);
+    auto data = serialize_ir(&mod1);
+
+    Context c2;
+    auto *mod2 = deserialize_ir(&c2, data);
+    EXPECT_EQ(mod2->name, "mod");
+    EXPECT_EQ(mod2->get_child_generator_size(), 1);
+    auto *v = mod2->get_var("v").get();
+    EXPECT_EQ(v->comment, "register");
+    EXPECT_EQ(v->fn_name_ln.size(), 1);
+    EXPECT_EQ(v->fn_name_ln[0].second, 42);
+    EXPECT_EQ(v->get_attributes().size(), 1);
+    EXPECT_EQ(v->get_attributes()[0]->value_str, "value");
+
+    EXPECT_EQ(generate_module(mod1), generate_module(*mod2));
+}
+
+TEST(ir, serialize_file) {  // NOLINT
+    Context c1;
+    auto &mod1 = build_serialize_design(c1);
+    auto filename = "serialize_file.ir";
+    save_ir(&mod1, filename);
+    Context c2;
+    auto *mod2 = load_ir(&c2, filename);
+    std::remove(filename);
+    EXPECT_EQ(generate_module(mod1), generate_module(*mod2));
+}
+
+TEST(ir, serialize_invalid) {  // NOLINT
+    Context c1;
+    auto &mod = build_serialize_design(c1);
+    auto data = serialize_ir(&mod);
+
+    Context c2;
+    auto bad_magic = data;
+    bad_magic[0] = 'X';
+    EXPECT_THROW(deserialize_ir(&c2, bad_magic), UserException);
+    auto bad_version = data;
+    bad_version[8] = static_cast<char>(IR_FORMAT_VERSION + 1);
+    EXPECT_THROW(deserialize_ir(&c2, bad_version), UserException);
+    EXPECT_THROW(deserialize_ir(&c2, data.substr(0, data.size() / 2)), UserException);
+    auto bad_top = data;
+    uint32_t top = 0xFFFF;
+    std::memcpy(&bad_top[20], &top, sizeof(top));
+    EXPECT_THROW(deserialize_ir(&c2, bad_top), UserException);
+
+    // make a slice its own operand. the offsets follow the header and VarRecord layout
+    auto cyclic = data;
+    uint64_t vars_offset, vars_count;
+    std::memcpy(&vars_offset, &cyclic[24 + 14 * 16], sizeof(vars_offset));
+    std::memcpy(&vars_count, &cyclic[24 + 14 * 16 + 8], sizeof(vars_count));
+    constexpr uint64_t var_record_size = 104;
+    constexpr uint32_t slice_kind = 6;
+    bool found = false;
+    for (uint32_t i = 0; i < vars_count && !found; i++) {
+        auto *record = &cyclic[vars_offset + i * var_record_size];
+        uint32_t kind;
+        std::memcpy(&kind, record, sizeof(kind));
+        if (kind != slice_kind) continue;
+        std::memcpy(record + 24, &i, sizeof(i));
+        found = true;
+    }
+    EXPECT_TRUE(found);
+    EXPECT_THROW(deserialize_ir(&c2, cyclic), UserException);
+}
+
+TEST(ir, ir_stats) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 8);
+    auto &out = mod.port(PortDirection::Out, "out", 8);
+    auto &a = mod.var("a", 8);
+    auto stmt = a.assign(in[{3, 0}].concat(in[{7, 4}]));
+    mod.add_stmt(stmt);
+    mod.add_stmt(out.assign(a + in));
+    auto &b = mod.var("b", 8);
+    Var::move_sink_to(&a, &b, &mod, false);
+    Var::move_src_to(&a, &b, &mod, false);
+    mod.remove_stmt(stmt);
+
+    PassManager manager;
+    std::function<void(Generator *)> visit = [](Generator *top) {
+        VarVisitor visitor;
+        visitor.visit_root(top);
+    };
+    manager.register_pass("visit", visit);
+    manager.add_pass("visit");
+    manager.run_passes(&mod);
+
+    auto stats = c.ir_stats();
+    if (!Context::ir_stats_enabled()) {
+        EXPECT_EQ(stats.node_visits, 0);
+        EXPECT_EQ(stats.stmts_added, 0);
+        EXPECT_TRUE(stats.pass_visits.empty());
+        return;
+    }
+    EXPECT_EQ(stats.exprs_created, 1);
+    EXPECT_GE(stats.slice_cache_misses, 2);
+    // slicing the same range again comes from the cache
+    in[{3, 0}];
+    EXPECT_EQ(c.ir_stats().slice_cache_hits, stats.slice_cache_hits + 1);
+    EXPECT_EQ(c.ir_stats().slice_cache_misses, stats.slice_cache_misses);
+    EXPECT_EQ(stats.stmts_added, 2);
+    EXPECT_EQ(stats.stmts_removed, 1);
+    EXPECT_EQ(stats.src_moves, 1);
+    EXPECT_EQ(stats.sink_moves, 1);
+    EXPECT_GT(stats.node_visits, 0);
+    EXPECT_EQ(stats.pass_visits.at("visit"), stats.node_visits);
+
+    c.reset_ir_stats();
+    stats = c.ir_stats();
+    EXPECT_EQ(stats.node_visits, 0);
+    EXPECT_EQ(stats.stmts_added, 0);
+    EXPECT_TRUE(stats.pass_visits.empty());
+}
@@ -456,6 +456,29 @@ TEST(pass, dead_code_elimination_3) {
     EXPECT_EQ(mod.get_child_generator_size(), 0);
 }
 
+TEST(pass, dead_code_elimination_4) {
+    // clocks are read by the event controls, not by any assignment
+    Context ctx;
+    auto &mod = ctx.generator("mod");
+    auto &child = ctx.generator("child");
+    mod.add_child_generator("inst", child);
+    auto &clk = child.port(PortDirection::In, "clk", 1, 1, PortType::Clock, false);
+    auto &in = child.port(PortDirection::In, "in", 1);
+    auto &out = child.port(PortDirection::Out, "out", 1);
+    auto seq = child.sequential();
+    seq->add_condition({EventEdgeType::Posedge, clk.shared_from_this()});
+    seq->add_stmt(out.assign(in));
+    mod.wire(clk, mod.port(PortDirection::In, "clk", 1, 1, PortType::Clock, false));
+    mod.wire(in, mod.port(PortDirection::In, "in", 1));
+    mod.wire(mod.port(PortDirection::Out, "out", 1), out);
+
+    fix_assignment_type(&mod);
+    dead_code_elimination(&mod);
+    EXPECT_NE(child.get_port("clk"), nullptr);
+    EXPECT_EQ(mod.get_child_generator_size(), 1);
+    EXPECT_NO_THROW(generate_verilog(&mod));
+}
+
 TEST(pass, inline_pass) {
     Context ctx;
     auto &mod = ctx.generator("mod");
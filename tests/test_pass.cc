@@ -32,6 +32,33 @@ TEST(pass, module_hash) {  // NOLINT
     hash_generators(&mod1, HashStrategy::ParallelHash);
 }
 
+TEST(pass, external_hash) {  // NOLINT
+    auto filename = fs::join(fs::temp_directory_path(), "test_external_hash.sv");
+    {
+        std::ofstream stream(filename);
+        stream << "module ext(input a); endmodule\n";
+    }
+    Context c;
+    auto &mod = Generator::from_verilog(&c, filename, "ext", {}, {});
+    hash_generators(&mod, HashStrategy::SequentialHash);
+    auto hash = c.get_hash(&mod);
+    // the file hash is cached in the context
+    auto cached = c.get_source_hash(fs::abspath(filename), *fs::file_stamp(filename));
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(*cached, hash);
+    hash_generators(&mod, HashStrategy::SequentialHash);
+    EXPECT_EQ(c.get_hash(&mod), hash);
+
+    // changes to the file invalidate the cache
+    {
+        std::ofstream stream(filename);
+        stream << "module ext(input a, output b); endmodule\n";
+    }
+    hash_generators(&mod, HashStrategy::SequentialHash);
+    EXPECT_NE(c.get_hash(&mod), hash);
+    fs::remove(filename);
+}
+
 TEST(pass, generator_hash) {  // NOLINT
     Context c;
     auto &mod1 = c.generator("module1");
@@ -76,4 +103,166 @@ TEST(pass, generator_hash) {  // NOLINT
     EXPECT_EQ(mod2.name, "module1_unq0");
     EXPECT_EQ(mod3.name, "module1_unq1");
     EXPECT_EQ(mod4.name, mod2.name);
-}
\ No newline at end of file
+}
+
+TEST(pass, elaborate_lazy_generators) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &out = mod.port(PortDirection::Out, "out", 1);
+    uint32_t built = 0;
+    auto lazy_child = [&](const std::string &name) -> Generator & {
+        auto &child = c.generator(name);
+        auto &child_out = child.port(PortDirection::Out, "out", 1);
+        child.set_lazy_body([&built, &child_out](Generator &gen) {
+            built++;
+            gen.add_stmt(child_out.assign(constant(1, 1)));
+        });
+        mod.add_child_generator(name, child);
+        return child;
+    };
+    auto &used = lazy_child("used");
+    auto &unused = lazy_child("unused");
+    auto &stub = lazy_child("stub");
+    stub.set_is_stub(true);
+    mod.add_stmt(out.assign(*used.get_port("out") | *stub.get_port("out")));
+    EXPECT_TRUE(used.is_lazy());
+    EXPECT_THROW(generate_verilog(&used), GeneratorException);
+
+    elaborate_lazy_generators(&mod);
+    EXPECT_EQ(built, 1);
+    EXPECT_FALSE(used.is_lazy());
+    EXPECT_EQ(used.stmts_count(), 1);
+    // the unused one is never built and its body is released
+    EXPECT_FALSE(mod.has_child_generator("unused"));
+    EXPECT_FALSE(unused.is_lazy());
+    EXPECT_EQ(unused.stmts_count(), 0);
+    EXPECT_FALSE(stub.is_lazy());
+    EXPECT_EQ(stub.stmts_count(), 0);
+}
+
+TEST(pass, fold_generator_parameters) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 8);
+    auto &out = mod.port(PortDirection::Out, "out", 8);
+    Var *result = &in;
+    auto add_child = [&](const std::string &inst_name, int64_t value, bool add) {
+        auto &child = c.generator("child");
+        auto &child_in = child.port(PortDirection::In, "in", 8);
+        auto &child_out = child.port(PortDirection::Out, "out", 8);
+        auto &rhs = add ? child_in + constant(value, 8) : child_in - constant(value, 8);
+        child.add_stmt(child_out.assign(rhs & constant(0xF0, 8)));
+        mod.add_child_generator(inst_name, child);
+        auto &w = mod.var(inst_name + "_w", 8);
+        mod.add_stmt(child_in.assign(*result));
+        mod.add_stmt(w.assign(child_out));
+        result = &w;
+    };
+    add_child("inst1", 1, true);
+    add_child("inst2", 2, true);
+    add_child("inst3", 1, true);
+    add_child("inst4", 1, false);
+    mod.add_stmt(out.assign(*result));
+
+    fix_assignment_type(&mod);
+    hash_generators(&mod, HashStrategy::SequentialHash);
+    fold_generator_parameters(&mod);
+    // the folded modules are still well formed and nothing is dropped as unused
+    EXPECT_NO_THROW(verify_generator_connectivity(&mod));
+    remove_unused_vars(&mod);
+    for (auto const &child : c.get_generators_by_name("child")) {
+        EXPECT_EQ(child->stmts_count(), 1);
+        EXPECT_EQ(child->vars().size(), 2);
+        auto const &params = child->get_params();
+        if (params.find("CONST_0") != params.end())
+            EXPECT_EQ(params.at("CONST_0")->generator(), child.get());
+        EXPECT_NO_THROW(check_mixed_assignment(child.get()));
+    }
+    uniquify_generators(&mod);
+    create_module_instantiation(&mod);
+    auto src = generate_verilog(&mod);
+    // the subtraction can't be folded into the others
+    EXPECT_EQ(src.size(), 3);
+    auto child_src = src.at("child");
+    EXPECT_NE(child_src.find("parameter CONST_0 = 8'h1"), std::string::npos);
+    EXPECT_NE(child_src.find("(in + CONST_0) & 8'hF0"), std::string::npos);
+    EXPECT_EQ(child_src.find("CONST_1"), std::string::npos);
+    EXPECT_EQ(src.at("child_unq0").find("CONST_0"), std::string::npos);
+    auto mod_src = src.at("mod");
+    EXPECT_NE(mod_src.find("child #(\n  .CONST_0(8'h2))\ninst2"), std::string::npos);
+    EXPECT_NE(mod_src.find("child inst1"), std::string::npos);
+    EXPECT_NE(mod_src.find("child inst3"), std::string::npos);
+    EXPECT_NE(mod_src.find("child_unq0 inst4"), std::string::npos);
+}
+
+TEST(pass, default_pass_pipeline) {  // NOLINT
+    DefaultPassOptions options;
+    auto pipeline = default_pass_pipeline(options);
+    PassManager manager;
+    manager.register_builtin_passes();
+    manager.add_default_passes(options);
+    EXPECT_EQ(manager.num_passes(), pipeline.size());
+    auto position = [&](const std::string &name) {
+        return std::find(pipeline.begin(), pipeline.end(), name) - pipeline.begin();
+    };
+    EXPECT_EQ(position("elaborate_lazy_generators"), 0);
+    EXPECT_LT(position("hash_generators_parallel"), position("uniquify_generators"));
+    EXPECT_EQ(position("fold_generator_parameters"), pipeline.size());
+
+    options.fold_parameters = true;
+    options.insert_debug_info = true;
+    pipeline = default_pass_pipeline(options);
+    EXPECT_EQ(position("fold_generator_parameters") + 1, position("uniquify_generators"));
+    // debug info keeps the unused variables
+    EXPECT_EQ(position("remove_unused_vars"), pipeline.size());
+}
+
+TEST(pass, pass_perf) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &in = mod.port(PortDirection::In, "in", 8);
+    auto &out = mod.port(PortDirection::Out, "out", 8);
+    mod.add_stmt(out.assign(in));
+
+    PassManager manager;
+    std::function<void(Generator *)> alloc = [](Generator *) {
+        // keep the buffer alive until the pass returns so it shows up in the peak
+        std::vector<char> buffer(64 * 1024 * 1024, 1);
+        EXPECT_EQ(buffer.back(), 1);
+    };
+    manager.register_pass("alloc", alloc);
+    manager.register_builtin_passes();
+    manager.add_pass("fix_assignment_type");
+    manager.add_pass("alloc");
+
+    manager.run_passes(&mod);
+    EXPECT_TRUE(manager.perf_results().empty());
+
+    manager.set_collect_perf(true);
+    testing::internal::CaptureStdout();
+    manager.run_passes(&mod);
+    EXPECT_NE(testing::internal::GetCapturedStdout().find("[name]: alloc"), std::string::npos);
+    // collecting without printing, with per-pass peaks
+    manager.set_print_perf(false);
+    manager.set_reset_peak_rss(true);
+    testing::internal::CaptureStdout();
+    manager.run_passes(&mod);
+    EXPECT_TRUE(testing::internal::GetCapturedStdout().empty());
+    auto const &results = manager.perf_results();
+    EXPECT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0].name, "fix_assignment_type");
+    EXPECT_EQ(results[1].name, "alloc");
+    for (auto const &perf : results) {
+        EXPECT_GE(perf.time, 0);
+        EXPECT_GE(perf.peak_rss, perf.rss_after);
+    }
+    if (mem::current_rss() > 0) {
+        EXPECT_GE(results[1].peak_rss, results[1].rss_before + 32 * 1024 * 1024);
+    }
+    if (mem::allocation_counting()) {
+        EXPECT_GE(results[1].allocations, 1);
+        EXPECT_GE(results[1].allocated_bytes, 64 * 1024 * 1024);
+    } else {
+        EXPECT_EQ(results[1].allocations, 0);
+    }
+}
@@ -330,4 +330,28 @@ TEST(sim, ternary) {    // NOLINT
     sim.set(&a, 1);
     result = (*sim.eval_expr(&cond))[0];
     EXPECT_EQ(result, 42);
-}
\ No newline at end of file
+}
+
+TEST(sim, many) {  // NOLINT
+    Context ctx;
+    auto &gen = ctx.generator("mod");
+    auto &a = gen.var("a", 8);
+    auto &b = gen.var("b", 8, 3);
+    auto &c = gen.var("c", 8);
+    gen.add_stmt(c.assign(a + b[1]));
+    Simulator sim(&gen);
+    std::vector<Var *> inputs = {&a, &b};
+    EXPECT_EQ(Simulator::value_count(inputs), 4);
+    // a is truncated to its width
+    std::vector<uint64_t> values = {0x112, 1, 2, 3};
+    sim.set_many(inputs, values.data(), values.size());
+    std::vector<Var *> outputs = {&c, &b, &gen.var("d", 1)};
+    std::vector<uint64_t> result(Simulator::value_count(outputs), 42);
+    bool valid[3];
+    sim.get_many(outputs, result.data(), result.size(), valid);
+    EXPECT_EQ(result, std::vector<uint64_t>({0x14, 1, 2, 3, 0}));
+    EXPECT_TRUE(valid[0]);
+    EXPECT_TRUE(valid[1]);
+    EXPECT_FALSE(valid[2]);
+    EXPECT_THROW(sim.set_many(inputs, values.data(), 3), UserException);
+}
@@ -1,4 +1,7 @@
 from kratos import Simulator, Generator, posedge, always_ff, negedge
+import _kratos
+import numpy as np
+import threading
 
 
 def test_sim_reg():
@@ -55,5 +58,104 @@ def test_expr():
     assert sim.get(b) == 12
 
 
+def test_set_get_many():
+    mod = Generator("mod")
+    a = mod.input("a", 16)
+    b = mod.input("b", 8, size=2)
+    c = mod.output("c", 16)
+    mod.add_stmt(c.assign(a + a))
+
+    sim = Simulator(mod)
+    assert _kratos.Simulator.value_count([a, b, c]) == 4
+    # nothing has been set yet
+    valid = np.zeros(2, dtype=bool)
+    values = sim.get_many([a, c], valid=valid)
+    assert not valid.any()
+    assert list(values) == [0, 0]
+
+    # values are truncated to the variable width
+    sim.set_many([a, b], np.array([1 << 16 | 1, 2, 3], dtype=np.uint64))
+    values = sim.get_many([a, b, c])
+    assert list(values) == [1, 2, 3, 2]
+
+    # write into a caller-owned buffer
+    out = np.zeros(4, dtype=np.uint64)
+    valid = np.zeros(3, dtype=bool)
+    result = sim.get_many([a, b, c], out=out, valid=valid)
+    assert list(out) == [1, 2, 3, 2]
+    assert list(result) == list(out)
+    assert valid.all()
+
+    # mismatched buffers are rejected
+    try:
+        sim.set_many([a, b], np.array([1, 2], dtype=np.uint64))
+        assert False
+    except Exception:
+        pass
+    try:
+        sim.get_many([a, c], valid=np.zeros(3, dtype=bool))
+        assert False
+    except Exception:
+        pass
+
+
+def test_sim_threads():
+    num_threads = 4
+    sims = []
+    for i in range(num_threads):
+        mod = Generator("mod_{0}".format(i))
+        a = mod.input("a", 16)
+        b = mod.output("b", 16)
+        mod.add_stmt(b.assign(a + i))
+        sims.append((Simulator(mod), a, b))
+
+    results = [None] * num_threads
+
+    def run(idx):
+        sim, a, b = sims[idx]
+        out = np.zeros(1, dtype=np.uint64)
+        values = []
+        # eval, set_many and get_many release the GIL
+        for v in range(100):
+            sim.set_many([a], np.array([v], dtype=np.uint64), False)
+            sim._sim.eval()
+            sim.get_many([b], out=out)
+            values.append(int(out[0]))
+        results[idx] = values
+
+    threads = [threading.Thread(target=run, args=(i,))
+               for i in range(num_threads)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for i in range(num_threads):
+        assert results[i] == [v + i for v in range(100)]
+
+
+def test_python_pass_threads():
+    num_threads = 4
+    mods = [Generator("mod_{0}".format(i)) for i in range(num_threads)]
+    names = [None] * num_threads
+
+    def run(idx):
+        def record_name(generator):
+            # called back from C++ after run_passes released the GIL
+            names[idx] = generator.name
+
+        pass_manager = _kratos.passes.PassManager()
+        pass_manager.register_pass("record_name", record_name)
+        pass_manager.add_pass("record_name")
+        pass_manager.run_passes(mods[idx].internal_generator)
+
+    threads = [threading.Thread(target=run, args=(i,))
+               for i in range(num_threads)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert names == ["mod_{0}".format(i) for i in range(num_threads)]
+
+
 if __name__ == "__main__":
     test_expr()
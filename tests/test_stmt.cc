@@ -251,4 +251,43 @@ TEST(stmt, clone_clear) { // NOLINT
     auto raw_string_cloned = raw_string->clone()->as<RawStringStmt>();
     EXPECT_EQ(raw_string->stmts()[0], raw_string_cloned->stmts()[0]);
 
-}
\ No newline at end of file
+}
+TEST(stmt, scope_context) {  // NOLINT
+    Context c;
+    auto &mod = c.generator("mod");
+    auto &a = mod.var("a", 1);
+    auto &b = mod.var("b", 1);
+    auto comb = mod.combinational();
+    auto stmt1 = a.assign(b);
+    comb->add_stmt(stmt1);
+    auto if_ = std::make_shared<IfStmt>(b);
+    auto stmt2 = b.assign(a);
+    if_->add_then_stmt(stmt2);
+    comb->add_stmt(if_);
+
+    comb->add_scope_variable("x", "1", false, false);
+    comb->add_scope_variable("y", "a", true, false);
+    // statements with the same context share the same frame
+    EXPECT_EQ(comb->scope_frame(), stmt1->scope_frame());
+    EXPECT_EQ(comb->scope_frame(), if_->scope_frame());
+    EXPECT_EQ(comb->scope_frame(), stmt2->scope_frame());
+    auto context = stmt2->scope_context();
+    EXPECT_EQ(context.size(), 2);
+    EXPECT_EQ(context.at("y"), std::make_pair(true, std::string("a")));
+
+    // existing variables are not changed unless overridden
+    if_->add_scope_variable("x", "2", false, false);
+    EXPECT_EQ(if_->scope_frame(), comb->scope_frame());
+    if_->add_scope_variable("x", "2", false, true);
+    EXPECT_EQ(stmt2->scope_context().at("x").second, "2");
+    EXPECT_EQ(comb->scope_context().at("x").second, "1");
+    EXPECT_EQ(if_->scope_frame()->parent(), comb->scope_frame());
+
+    // inherit only fills in missing variables
+    auto stmt3 = a.assign(b);
+    stmt3->add_scope_variable("x", "3", false, false);
+    stmt3->inherit_scope_context(comb->scope_frame());
+    context = stmt3->scope_context();
+    EXPECT_EQ(context.at("x").second, "3");
+    EXPECT_EQ(context.at("y").second, "a");
+}